@@ -562,6 +562,7 @@ Admin::~Admin()
 
 bool Admin::addConnection()
 {
+	boost::mutex::scoped_lock lockClass(m_connectionsLock);
 	if(m_currentConnections >= g_config.getNumber(ConfigManager::ADMIN_CONNECTIONS_LIMIT))
 		return false;
 
@@ -571,6 +572,7 @@ bool Admin::addConnection()
 
 void Admin::removeConnection()
 {
+	boost::mutex::scoped_lock lockClass(m_connectionsLock);
 	if(m_currentConnections > 0)
 		m_currentConnections--;
 }
@@ -161,6 +161,7 @@ class Admin
 		Admin();
 
 		int32_t m_currentConnections;
+		boost::mutex m_connectionsLock;
 		bool m_encrypted;
 
 		RSA* m_key_RSA1024XTEA;
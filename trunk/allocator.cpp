@@ -18,6 +18,237 @@
 #include "otpch.h"
 #include "allocator.h"
 
+#if defined _MSC_VER
+#define ALLOCATOR_THREAD_LOCAL __declspec(thread)
+#else
+#define ALLOCATOR_THREAD_LOCAL __thread
+#endif
+
+// caches of finished threads are not reclaimed, our threads live as long as the server
+static ALLOCATOR_THREAD_LOCAL poolCache* threadCache = NULL;
+static const size_t classSizes[ALLOCATOR_CLASSES] =
+{
+	16, 32, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384,
+	448, 512, 640, 768, 896, 1024, 2048, 3072, 4096, 6144, 8192, 12288, 16384
+};
+
+PoolManager::PoolManager()
+{
+	uint8_t sizeClass = 0;
+	for(size_t i = 0; i <= ALLOCATOR_SMALL_LIMIT / ALLOCATOR_SMALL_STEP; ++i)
+	{
+		while(classSizes[sizeClass] < i * ALLOCATOR_SMALL_STEP)
+			++sizeClass;
+
+		smallClasses[i] = sizeClass;
+	}
+
+	for(size_t i = 0; i <= ALLOCATOR_LARGE_LIMIT / ALLOCATOR_LARGE_STEP; ++i)
+	{
+		while(classSizes[sizeClass] < i * ALLOCATOR_LARGE_STEP)
+			++sizeClass;
+
+		largeClasses[i] = sizeClass;
+	}
+
+	for(uint8_t i = 0; i < ALLOCATOR_CLASSES; ++i)
+	{
+		classes[i].bytes = classSizes[i];
+		classes[i].batch = std::min((size_t)64, std::max((size_t)4, (size_t)32768 / classSizes[i]));
+		classes[i].blocks = NULL;
+	}
+	#ifdef __OTSERV_ALLOCATOR_STATS__
+
+	caches = NULL;
+	#endif
+}
+
+void* PoolManager::allocate(size_t size)
+{
+	size_t bytes = size + sizeof(poolTag);
+	uint8_t sizeClass = getClass(bytes);
+
+	poolCache* cache = getCache();
+	poolTag* tag = NULL;
+	if(sizeClass < ALLOCATOR_CLASSES)
+	{
+		if(!cache->blocks[sizeClass] && !fetch(cache, sizeClass))
+			throw std::bad_alloc();
+
+		poolBlock* block = cache->blocks[sizeClass];
+		cache->blocks[sizeClass] = block->next;
+		--cache->count[sizeClass];
+
+		tag = reinterpret_cast<poolTag*>(block);
+		tag->poolclass = sizeClass + 1;
+		#ifdef __OTSERV_ALLOCATOR_STATS__
+
+		cache->stats[sizeClass].allocations++;
+		cache->stats[sizeClass].unused += classes[sizeClass].bytes - bytes;
+		#endif
+		return tag + 1;
+	}
+
+	if(!(tag = reinterpret_cast<poolTag*>(std::malloc(bytes))))
+		throw std::bad_alloc();
+
+	tag->poolclass = 0;
+	#ifdef __OTSERV_ALLOCATOR_STATS__
+
+	cache->stats[ALLOCATOR_CLASSES].allocations++;
+	cache->stats[ALLOCATOR_CLASSES].unused += size;
+	#endif
+	return tag + 1;
+}
+
+void PoolManager::deallocate(void* deletable)
+{
+	if(!deletable)
+		return;
+
+	poolTag* const tag = reinterpret_cast<poolTag*>(deletable) - 1U;
+	poolCache* cache = getCache();
+	if(!tag->poolclass)
+	{
+		std::free(tag);
+		#ifdef __OTSERV_ALLOCATOR_STATS__
+		cache->stats[ALLOCATOR_CLASSES].deallocations++;
+		#endif
+		return;
+	}
+
+	uint8_t sizeClass = tag->poolclass - 1;
+
+	poolBlock* block = reinterpret_cast<poolBlock*>(tag);
+	block->next = cache->blocks[sizeClass];
+	cache->blocks[sizeClass] = block;
+	#ifdef __OTSERV_ALLOCATOR_STATS__
+
+	cache->stats[sizeClass].deallocations++;
+	#endif
+	if(++cache->count[sizeClass] > (classes[sizeClass].batch << 1))
+		release(cache, sizeClass);
+}
+
+poolCache* PoolManager::getCache()
+{
+	if(threadCache)
+		return threadCache;
+
+	threadCache = reinterpret_cast<poolCache*>(std::calloc(1, sizeof(poolCache)));
+	if(!threadCache)
+		throw std::bad_alloc();
+	#ifdef __OTSERV_ALLOCATOR_STATS__
+
+	boost::mutex::scoped_lock lockClass(cachesLock);
+	threadCache->next = caches;
+	caches = threadCache;
+	#endif
+	return threadCache;
+}
+
+bool PoolManager::fetch(poolCache* cache, uint8_t sizeClass)
+{
+	poolClass& pool = classes[sizeClass];
+	boost::mutex::scoped_lock lockClass(pool.lock);
+	if(!pool.blocks)
+	{
+		size_t slabSize = std::max((size_t)ALLOCATOR_SLAB_SIZE, pool.bytes * pool.batch);
+		char* slab = reinterpret_cast<char*>(std::malloc(slabSize));
+		if(!slab)
+			return false;
+
+		for(size_t offset = 0; offset + pool.bytes <= slabSize; offset += pool.bytes)
+		{
+			poolBlock* block = reinterpret_cast<poolBlock*>(slab + offset);
+			block->next = pool.blocks;
+			pool.blocks = block;
+		}
+	}
+
+	for(uint32_t i = 0; i < pool.batch && pool.blocks; ++i)
+	{
+		poolBlock* block = pool.blocks;
+		pool.blocks = block->next;
+
+		block->next = cache->blocks[sizeClass];
+		cache->blocks[sizeClass] = block;
+		++cache->count[sizeClass];
+	}
+	#ifdef __OTSERV_ALLOCATOR_STATS__
+
+	cache->stats[sizeClass].transfers++;
+	#endif
+	return true;
+}
+
+void PoolManager::release(poolCache* cache, uint8_t sizeClass)
+{
+	poolClass& pool = classes[sizeClass];
+	poolBlock* first = cache->blocks[sizeClass];
+
+	poolBlock* last = first;
+	for(uint32_t i = 1; i < pool.batch; ++i)
+		last = last->next;
+
+	cache->blocks[sizeClass] = last->next;
+	cache->count[sizeClass] -= pool.batch;
+	#ifdef __OTSERV_ALLOCATOR_STATS__
+
+	cache->stats[sizeClass].transfers++;
+	#endif
+
+	boost::mutex::scoped_lock lockClass(pool.lock);
+	last->next = pool.blocks;
+	pool.blocks = first;
+}
+
+#ifdef __OTSERV_ALLOCATOR_STATS__
+void PoolManager::dumpStats()
+{
+	poolStats total[ALLOCATOR_CLASSES + 1];
+	memset(total, 0, sizeof(total));
+
+	uint32_t threads = 0;
+	{
+		boost::mutex::scoped_lock lockClass(cachesLock);
+		for(poolCache* cache = caches; cache; cache = cache->next, ++threads)
+		{
+			// counters are owned by their threads, a slightly stale read is fine here
+			for(uint8_t i = 0; i <= ALLOCATOR_CLASSES; ++i)
+			{
+				total[i].allocations += cache->stats[i].allocations;
+				total[i].deallocations += cache->stats[i].deallocations;
+				total[i].unused += cache->stats[i].unused;
+				total[i].transfers += cache->stats[i].transfers;
+			}
+		}
+	}
+
+	time_t rawtime;
+	time(&rawtime);
+	std::ofstream output("data/logs/memory_dump.log", std::ios_base::app);
+
+	output << "OTServ Allocator Stats (" << threads << " threads): " << std::ctime(&rawtime) << std::endl;
+	for(uint8_t i = 0; i <= ALLOCATOR_CLASSES; ++i)
+	{
+		int64_t bytes = (i < ALLOCATOR_CLASSES ? (int64_t)classes[i].bytes : 0);
+		output << bytes << " alloc: " << total[i].allocations << " dealloc: " << total[i].deallocations;
+		output << " unused: " << total[i].unused << " transfers: " << total[i].transfers;
+		if(total[i].allocations != 0 && bytes != 0)
+		{
+			output << " avg: " << (bytes - total[i].unused / total[i].allocations);
+			output << " %unused: " << (total[i].unused * 100 / total[i].allocations / bytes);
+		}
+
+		output << " N: " << (total[i].allocations - total[i].deallocations) << std::endl;
+	}
+
+	output << std::endl;
+	output.close();
+}
+#endif
+
 //normal new/delete
 void* operator new(size_t bytes)
 {
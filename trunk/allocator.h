@@ -20,7 +20,6 @@
 #define __ALLOCATOR__
 
 #include "otsystem.h"
-#include <boost/pool/pool.hpp>
 
 #include <memory>
 #include <cstdlib>
@@ -93,9 +92,41 @@ void operator delete[](void* p, int32_t dummy);
 void allocatorStatsThread(void* a);
 #endif
 
+#define ALLOCATOR_CLASSES 27
+#define ALLOCATOR_SMALL_STEP 16
+#define ALLOCATOR_SMALL_LIMIT 1024
+#define ALLOCATOR_LARGE_STEP 1024
+#define ALLOCATOR_LARGE_LIMIT 16384
+#define ALLOCATOR_SLAB_SIZE 65536
+
 struct poolTag
 {
-	size_t poolbytes;
+	size_t poolclass; // size class + 1, 0 for blocks taken straight from malloc
+};
+
+struct poolBlock
+{
+	poolBlock* next;
+};
+
+#ifdef __OTSERV_ALLOCATOR_STATS__
+struct poolStats
+{
+	int64_t allocations, deallocations, unused, transfers;
+};
+
+#endif
+// every thread keeps its own free lists and only goes to the central
+// lists, one lock per size class, to move whole batches of blocks
+struct poolCache
+{
+	poolBlock* blocks[ALLOCATOR_CLASSES];
+	uint32_t count[ALLOCATOR_CLASSES];
+	#ifdef __OTSERV_ALLOCATOR_STATS__
+
+	poolStats stats[ALLOCATOR_CLASSES + 1];
+	poolCache* next;
+	#endif
 };
 
 class PoolManager
@@ -103,172 +134,57 @@ class PoolManager
 	public:
 		static PoolManager* getInstance()
 		{
-			static PoolManager instance;
-			return &instance;
+			// never destroyed, objects may still be deleted after exit
+			static PoolManager* instance = new(0) PoolManager;
+			return instance;
 		}
 
-		void* allocate(size_t size)
-		{
-			Pools::iterator it;
-			poolLock.lock();
-			for(it = pools.begin(); it != pools.end(); ++it)
-			{
-				if(it->first >= size + sizeof(poolTag))
-				{
-					poolTag* tag = reinterpret_cast<poolTag*>(it->second->malloc());
-					#ifdef __OTSERV_ALLOCATOR_STATS__
-					if(!tag)
-						dumpStats();
-
-					#endif
-					tag->poolbytes = it->first;
-					#ifdef __OTSERV_ALLOCATOR_STATS__
-					poolsStats[it->first]->allocations++;
-					poolsStats[it->first]->unused+= it->first - (size + sizeof(poolTag));
-					#endif
-
-					poolLock.unlock();
-					return tag + 1;
-				}
-			}
-
-			poolTag* tag = reinterpret_cast<poolTag*>(std::malloc(size + sizeof(poolTag)));
-			#ifdef __OTSERV_ALLOCATOR_STATS__
-			poolsStats[0]->allocations++;
-			poolsStats[0]->unused += size;
-
-			#endif
-			tag->poolbytes = 0;
-			poolLock.unlock();
-			return tag + 1;
-		}
-
-		void deallocate(void* deletable)
-		{
-			if(!deletable)
-				return;
-
-			poolTag* const tag = reinterpret_cast<poolTag*>(deletable) - 1U;
-			poolLock.lock();
-			if(tag->poolbytes)
-			{
-				Pools::iterator it;
-				it = pools.find(tag->poolbytes);
-
-				it->second->free(tag);
-				#ifdef __OTSERV_ALLOCATOR_STATS__
-				poolsStats[it->first]->deallocations++;
-				#endif
-			}
-			else
-			{
-				std::free(tag);
-				#ifdef __OTSERV_ALLOCATOR_STATS__
-				poolsStats[0]->deallocations++;
-				#endif
-			}
-
-			poolLock.unlock();
-		}
+		void* allocate(size_t size);
+		void deallocate(void* deletable);
 
 		#ifdef __OTSERV_ALLOCATOR_STATS__
-		void dumpStats()
-		{
-			time_t rawtime;
-			time(&rawtime);
-			std::ofstream output("data/logs/memory_dump.log", std::ios_base::app);
-
-			output << "OTServ Allocator Stats: " << std::ctime(&rawtime) << std::endl;
-			for(PoolsStats::iterator it = poolsStats.begin(); it != poolsStats.end(); ++it)
-			{
-				output << (int32_t)(it->first) << " alloc: " << (int64_t)(it->second->allocations) << " dealloc: ";
-				output << (int64_t)(it->second->deallocations) << " unused: " << (int64_t)(it->second->unused);
-				if(it->second->allocations != 0 && it->first != 0)
-				{
-					output << " avg: " << (int64_t)((it->first) - (it->second->unused) / (it->second->allocations));
-					output << " %unused: " << (int64_t)((it->second->unused) * 100 / (it->second->allocations) / (it->first));
-				}
-
-				output << " N: " << ((int64_t)(it->second->allocations) - (int64_t)(it->second->deallocations)) << std::endl;
-			}
-
-			output << std::endl;
-			output.close();
-		}
+		void dumpStats();
 		#endif
 
-		virtual ~PoolManager()
-		{
-			Pools::iterator it = pools.begin();
-			while(it != pools.end())
-			{
-				std::free(it->second);
-				it = pools.erase(it);
-			}
-
-			#ifdef __OTSERV_ALLOCATOR_STATS__
-			for(PoolsStats::iterator sit = poolsStats.begin(); sit != poolsStats.end();)
-			{
-				std::free(sit->second);
-				sit = poolsStats.erase(sit);
-			}
-			#endif
-		}
-
 	private:
-		void addPool(size_t size, size_t nextSize)
-		{
-			pools[size] = new(0) boost::pool<boost::default_user_allocator_malloc_free>(size, nextSize);
-			#ifdef __OTSERV_ALLOCATOR_STATS__
+		PoolManager();
+		virtual ~PoolManager() {}
 
-			t_PoolStats * tmp = new(0) t_PoolStats;
-			tmp->unused = tmp->allocations = tmp->deallocations = 0;
-			poolsStats[size] = tmp;
-			#endif
-		}
+		PoolManager(const PoolManager&);
+		const PoolManager& operator=(const PoolManager&);
 
-		PoolManager()
+		uint8_t getClass(size_t bytes) const
 		{
-			addPool(4 + sizeof(poolTag), 32768);
-			addPool(20 + sizeof(poolTag), 32768);
-			addPool(32 + sizeof(poolTag), 32768);
-			addPool(48 + sizeof(poolTag), 32768);
-			addPool(96 + sizeof(poolTag), 16384);
-			addPool(128 + sizeof(poolTag), 1024);
-			addPool(384 + sizeof(poolTag), 2048);
-			addPool(512 + sizeof(poolTag), 128);
-			addPool(1024 + sizeof(poolTag), 128);
-			addPool(8192 + sizeof(poolTag), 128);
-			addPool(16384 + sizeof(poolTag), 128);
-
-			addPool(60 + sizeof(poolTag), 10000); //Tile class
-			addPool(36 + sizeof(poolTag), 10000); //Item class
-
-			#ifdef __OTSERV_ALLOCATOR_STATS__
-			t_PoolStats * tmp = new(0) t_PoolStats;
-			tmp->unused = tmp->allocations = tmp->deallocations = 0;
-			poolsStats[0] = tmp;
-			#endif
+			if(bytes <= ALLOCATOR_SMALL_LIMIT)
+				return smallClasses[(bytes + ALLOCATOR_SMALL_STEP - 1) / ALLOCATOR_SMALL_STEP];
+
+			if(bytes <= ALLOCATOR_LARGE_LIMIT)
+				return largeClasses[(bytes + ALLOCATOR_LARGE_STEP - 1) / ALLOCATOR_LARGE_STEP];
+
+			return ALLOCATOR_CLASSES;
 		}
 
-		PoolManager(const PoolManager&);
-		const PoolManager& operator=(const PoolManager&);
+		poolCache* getCache();
+		bool fetch(poolCache* cache, uint8_t sizeClass);
+		void release(poolCache* cache, uint8_t sizeClass);
 
-		typedef std::map<size_t, boost::pool<boost::default_user_allocator_malloc_free >*, std::less<size_t >,
-			dummyallocator<std::pair<const size_t, boost::pool<boost::default_user_allocator_malloc_free>* > > > Pools;
-		Pools pools;
+		uint8_t smallClasses[ALLOCATOR_SMALL_LIMIT / ALLOCATOR_SMALL_STEP + 1];
+		uint8_t largeClasses[ALLOCATOR_LARGE_LIMIT / ALLOCATOR_LARGE_STEP + 1];
 
-		#ifdef __OTSERV_ALLOCATOR_STATS__
-		struct t_PoolStats
+		struct poolClass
 		{
-			int64_t allocations, deallocations, unused;
-		};
+			size_t bytes;
+			uint32_t batch;
 
-		typedef std::map<size_t, t_PoolStats*, std::less<size_t >, dummyallocator<std::pair<const size_t, t_PoolStats* > > > PoolsStats;
-		PoolsStats poolsStats;
+			poolBlock* blocks;
+			boost::mutex lock;
+		};
+		poolClass classes[ALLOCATOR_CLASSES];
 
+		#ifdef __OTSERV_ALLOCATOR_STATS__
+		poolCache* caches;
+		boost::mutex cachesLock;
 		#endif
-		boost::recursive_mutex poolLock;
 };
 #endif
 #endif
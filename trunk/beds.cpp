@@ -28,6 +28,20 @@
 extern Game g_game;
 extern ConfigManager g_config;
 
+#ifdef _MSC_VER
+#define BEDS_THREAD_LOCAL __declspec(thread)
+#else
+#define BEDS_THREAD_LOCAL __thread
+#endif
+
+//map decode threads must not touch the database, see IOMap::mergeTileArea
+static BEDS_THREAD_LOCAL bool deferSleepers = false;
+
+void BedItem::setDeferSleepers(bool value)
+{
+	deferSleepers = value;
+}
+
 Attr_ReadValue BedItem::readAttr(AttrTypes_t attr, PropStream& propStream)
 {
 	switch(attr)
@@ -38,17 +52,10 @@ Attr_ReadValue BedItem::readAttr(AttrTypes_t attr, PropStream& propStream)
 			if(!propStream.getLong(_sleeper))
 				return ATTR_READ_ERROR;
 
-			if(_sleeper)
-			{
-				std::string name;
-				if(IOLoginData::getInstance()->getNameByGuid(_sleeper, name))
-				{
-					setSpecialDescription(name + " is sleeping there.");
-					Beds::getInstance()->setBedSleeper(this, _sleeper);
-				}
-			}
-
 			sleeper = _sleeper;
+			if(!deferSleepers)
+				loadSleeper();
+
 			return ATTR_READ_CONTINUE;
 		}
 
@@ -69,6 +76,16 @@ Attr_ReadValue BedItem::readAttr(AttrTypes_t attr, PropStream& propStream)
 	return Item::readAttr(attr, propStream);
 }
 
+void BedItem::loadSleeper()
+{
+	std::string name;
+	if(sleeper && IOLoginData::getInstance()->getNameByGuid(sleeper, name))
+	{
+		setSpecialDescription(name + " is sleeping there.");
+		Beds::getInstance()->setBedSleeper(this, sleeper);
+	}
+}
+
 bool BedItem::serializeAttr(PropWriteStream& propWriteStream) const
 {
 	bool ret = Item::serializeAttr(propWriteStream);
@@ -38,6 +38,10 @@ class BedItem : public Item
 
 		uint32_t getSleeper() const {return sleeper;}
 		void setSleeper(uint32_t guid) {sleeper = guid;}
+		void loadSleeper();
+
+		//set on map decode threads, their sleepers are loaded once the area is merged
+		static void setDeferSleepers(bool value);
 
 		House* getHouse() const {return house;}
 		void setHouse(House* h) {house = h;}
@@ -20,6 +20,7 @@
 #include "player.h"
 #include "iologindata.h"
 #include "manager.h"
+#include "textlogger.h"
 
 #include "configmanager.h"
 #include "game.h"
@@ -101,12 +102,7 @@ ChatChannel::ChatChannel(uint16_t id, const std::string& name, uint16_t flags, u
 		m_vocationMap(vocationMap)
 {
 	if(hasFlag(CHANNELFLAG_LOGGED))
-	{
-		m_file.reset(new std::ofstream(getFilePath(FILE_TYPE_LOG, (std::string)"chat/" + g_config.getString(
-			ConfigManager::PREFIX_CHANNEL_LOGS) + m_name + (std::string)".log").c_str(), std::ios::app | std::ios::out));
-		if(!m_file->is_open())
-			m_flags &= ~CHANNELFLAG_LOGGED;
-	}
+		m_logFile = (std::string)"chat/" + g_config.getString(ConfigManager::PREFIX_CHANNEL_LOGS) + m_name + (std::string)".log";
 }
 
 bool ChatChannel::addUser(Player* player)
@@ -165,8 +161,8 @@ bool ChatChannel::talk(Player* player, SpeakClasses type, const std::string& tex
 	for(it = m_users.begin(); it != m_users.end(); ++it)
 		it->second->sendToChannel(player, type, text, m_id);
 
-	if(hasFlag(CHANNELFLAG_LOGGED) && m_file->is_open())
-		*m_file << "[" << formatDate() << "] " << player->getName() << ": " << text << std::endl;
+	if(hasFlag(CHANNELFLAG_LOGGED))
+		Logger::getInstance()->eFile(m_logFile, player->getName() + ": " + text, true);
 
 	return true;
 }
@@ -176,8 +172,8 @@ bool ChatChannel::talk(std::string nick, SpeakClasses type, std::string text)
 	for(UsersMap::iterator it = m_users.begin(); it != m_users.end(); ++it)
 		it->second->sendChannelMessage(nick, text, type, m_id);
 
-	if(hasFlag(CHANNELFLAG_LOGGED) && m_file->is_open())
-		*m_file << "[" << formatDate() << "] " << nick << ": " << text << std::endl;
+	if(hasFlag(CHANNELFLAG_LOGGED))
+		Logger::getInstance()->eFile(m_logFile, nick + ": " + text, true);
 
 	return true;
 }
@@ -81,7 +81,7 @@ class ChatChannel
 		VocationMap* m_vocationMap;
 
 		UsersMap m_users;
-		boost::shared_ptr<std::ofstream> m_file;
+		std::string m_logFile;
 };
 
 class PrivateChatChannel : public ChatChannel
@@ -329,6 +329,20 @@ bool ConfigManager::load()
 	m_confBool[MONSTER_SPAWN_WALKBACK] 		= getGlobalBool("monsterSpawnWalkback", true);
 	m_confNumber[PVP_BLESSING_THRESHOLD]	= getGlobalNumber("pvpBlessingThreshold", 40);
 	m_confNumber[FAIRFIGHT_TIMERANGE]	= getGlobalNumber("fairFightTimeRange", 60);
+	m_confNumber[LOG_QUEUE_SIZE]		= getGlobalNumber("logQueueSize", 8192);
+	m_confNumber[LOG_QUEUE_MEMORY]		= getGlobalNumber("logQueueMemory", 4096);
+	m_confNumber[LOG_FLUSH_INTERVAL]	= getGlobalNumber("logFlushInterval", 1000);
+	m_confNumber[LOG_ROTATE_SIZE]		= getGlobalNumber("logRotateSize", 0);
+	m_confNumber[LOG_ROTATE_INTERVAL]	= getGlobalNumber("logRotateInterval", 0);
+	m_confNumber[STATUS_REFRESH_INTERVAL]	= getGlobalNumber("statusRefreshInterval", 5 * 1000);
+	m_confNumber[IO_THREADS]		= getGlobalNumber("ioThreads", 1);
+	m_confNumber[LOGIN_CPU_THREADS]		= getGlobalNumber("loginCpuThreads", 0);
+	m_confNumber[LOGIN_DATABASE_THREADS]	= getGlobalNumber("loginDatabaseThreads", 2);
+	m_confNumber[MAP_LOAD_THREADS]		= getGlobalNumber("mapLoadThreads", 0);
+	m_confNumber[HOUSE_FULL_SAVE_INTERVAL]	= getGlobalNumber("houseFullSaveInterval", 10);
+	m_confBool[LOG_BLOCK_WHEN_FULL]		= getGlobalBool("logBlockWhenFull", false);
+	m_confBool[BACKGROUND_SAVE]		= getGlobalBool("backgroundSave", true);
+	m_confBool[DEPOT_COMPRESSION]		= getGlobalBool("depotCompression", true);
 
 	m_loaded = true;
 	return true;
@@ -182,6 +182,17 @@ class ConfigManager
 			FIST_BASE_ATTACK,
 			PVP_BLESSING_THRESHOLD,
 			FAIRFIGHT_TIMERANGE,
+			LOG_QUEUE_SIZE,
+			LOG_QUEUE_MEMORY,
+			LOG_FLUSH_INTERVAL,
+			LOG_ROTATE_SIZE,
+			LOG_ROTATE_INTERVAL,
+			STATUS_REFRESH_INTERVAL,
+			IO_THREADS,
+			LOGIN_CPU_THREADS,
+			LOGIN_DATABASE_THREADS,
+			MAP_LOAD_THREADS,
+			HOUSE_FULL_SAVE_INTERVAL,
 			LAST_NUMBER_CONFIG /* this must be the last one */
 		};
 
@@ -300,6 +311,9 @@ class ConfigManager
 			MOUNT_COOLDOWN,
 			ENABLE_COOLDOWNS,
 			MONSTER_SPAWN_WALKBACK,
+			LOG_BLOCK_WHEN_FULL,
+			BACKGROUND_SAVE,
+			DEPOT_COMPRESSION,
 			LAST_BOOL_CONFIG /* this must be the last one */
 		};
 
@@ -48,7 +48,7 @@ Connection_ptr ConnectionManager::createConnection(boost::asio::ip::tcp::socket*
 	boost::recursive_mutex::scoped_lock lockClass(m_connectionManagerLock);
 	Connection_ptr connection = boost::shared_ptr<Connection>(new Connection(socket, io_service, servicer));
 
-	m_connections.push_back(connection);
+	m_connections.insert(connection);
 	return connection;
 }
 
@@ -59,10 +59,7 @@ void ConnectionManager::releaseConnection(Connection_ptr connection)
 	#endif
 	boost::recursive_mutex::scoped_lock lockClass(m_connectionManagerLock);
 
-	std::list<Connection_ptr>::iterator it = std::find(m_connections.begin(), m_connections.end(), connection);
-	if(it != m_connections.end())
-		m_connections.erase(it);
-	else
+	if(!m_connections.erase(connection))
 		std::clog << "[Error - ConnectionManager::releaseConnection] Connection not found" << std::endl;
 }
 
@@ -72,7 +69,7 @@ void ConnectionManager::shutdown()
 	std::clog << "Closing all connections" << std::endl;
 	#endif
 	boost::recursive_mutex::scoped_lock lockClass(m_connectionManagerLock);
-	for(std::list<Connection_ptr>::iterator it = m_connections.begin(); it != m_connections.end(); ++it)
+	for(std::set<Connection_ptr>::iterator it = m_connections.begin(); it != m_connections.end(); ++it)
 	{
 		try
 		{
@@ -296,7 +293,7 @@ void Connection::deleteConnection()
 	assert(!m_refCount);
 	try
 	{
-		m_service.dispatch(boost::bind(&Connection::onStop, this));
+		m_strand.dispatch(boost::bind(&Connection::onStop, this));
 	}
 	catch(std::exception& e)
 	{
@@ -321,13 +318,13 @@ void Connection::accept()
 	{
 		++m_pendingRead;
 		m_readTimer.expires_from_now(boost::posix_time::seconds(Connection::readTimeout));
-		m_readTimer.async_wait(boost::bind(&Connection::handleReadTimeout,
-			boost::weak_ptr<Connection>(shared_from_this()), boost::asio::placeholders::error));
+		m_readTimer.async_wait(m_strand.wrap(boost::bind(&Connection::handleReadTimeout,
+			boost::weak_ptr<Connection>(shared_from_this()), boost::asio::placeholders::error)));
 
 		// Read size of the first packet
 		boost::asio::async_read(getHandle(),
 			boost::asio::buffer(m_msg.buffer(), NETWORK_HEADER_SIZE),
-			boost::bind(&Connection::parseHeader, shared_from_this(), boost::asio::placeholders::error));
+			m_strand.wrap(boost::bind(&Connection::parseHeader, shared_from_this(), boost::asio::placeholders::error)));
 	}
 	catch(std::exception& e)
 	{
@@ -340,6 +337,17 @@ void Connection::accept()
 	}
 }
 
+void Connection::resumeRead()
+{
+	boost::recursive_mutex::scoped_lock lockClass(m_connectionLock);
+	if(!m_readPaused)
+		return;
+
+	m_readPaused = false;
+	if(m_connectionState == CONNECTION_STATE_OPEN && !m_readError)
+		accept();
+}
+
 void Connection::parseHeader(const boost::system::error_code& error)
 {
 	m_connectionLock.lock();
@@ -361,13 +369,13 @@ void Connection::parseHeader(const boost::system::error_code& error)
 	{
 		++m_pendingRead;
 		m_readTimer.expires_from_now(boost::posix_time::seconds(Connection::readTimeout));
-		m_readTimer.async_wait(boost::bind(&Connection::handleReadTimeout,
-			boost::weak_ptr<Connection>(shared_from_this()), boost::asio::placeholders::error));
+		m_readTimer.async_wait(m_strand.wrap(boost::bind(&Connection::handleReadTimeout,
+			boost::weak_ptr<Connection>(shared_from_this()), boost::asio::placeholders::error)));
 
 		// Read packet content
 		m_msg.setSize(size + NETWORK_HEADER_SIZE);
 		boost::asio::async_read(getHandle(), boost::asio::buffer(m_msg.bodyBuffer(), size),
-			boost::bind(&Connection::parsePacket, shared_from_this(), boost::asio::placeholders::error));
+			m_strand.wrap(boost::bind(&Connection::parsePacket, shared_from_this(), boost::asio::placeholders::error)));
 	}
 	catch(std::exception& e)
 	{
@@ -433,17 +441,23 @@ void Connection::parsePacket(const boost::system::error_code& error)
 	else
 		m_protocol->onRecvMessage(m_msg); // Send the packet to the current protocol
 
+	if(m_readPaused)
+	{
+		m_connectionLock.unlock();
+		return;
+	}
+
 	try
 	{
 		++m_pendingRead;
 		m_readTimer.expires_from_now(boost::posix_time::seconds(Connection::readTimeout));
-		m_readTimer.async_wait(boost::bind(&Connection::handleReadTimeout,
-			boost::weak_ptr<Connection>(shared_from_this()), boost::asio::placeholders::error));
+		m_readTimer.async_wait(m_strand.wrap(boost::bind(&Connection::handleReadTimeout,
+			boost::weak_ptr<Connection>(shared_from_this()), boost::asio::placeholders::error)));
 
 		// Wait to the next packet
 		boost::asio::async_read(getHandle(),
 			boost::asio::buffer(m_msg.buffer(), NETWORK_HEADER_SIZE),
-			boost::bind(&Connection::parseHeader, shared_from_this(), boost::asio::placeholders::error));
+			m_strand.wrap(boost::bind(&Connection::parseHeader, shared_from_this(), boost::asio::placeholders::error)));
 	}
 	catch(std::exception& e)
 	{
@@ -487,11 +501,14 @@ bool Connection::send(OutputMessage_ptr msg)
 		close();
 	}
 	else
-	{	
+	{
+		// queue it without holding our lock, sendAll() takes the pool lock first
+		m_connectionLock.unlock();
 		#ifdef __DEBUG_NET__
 		std::clog << "Connection::send Adding to queue " << msg->size() << std::endl;
 		#endif
 		OutputMessagePool::getInstance()->autoSend(msg);
+		return true;
 	}
 
 	m_connectionLock.unlock();
@@ -505,12 +522,12 @@ void Connection::internalSend(OutputMessage_ptr msg)
 	{
 		++m_pendingWrite;
 		m_writeTimer.expires_from_now(boost::posix_time::seconds(Connection::writeTimeout));
-		m_writeTimer.async_wait(boost::bind(&Connection::handleWriteTimeout,
-			boost::weak_ptr<Connection>(shared_from_this()), boost::asio::placeholders::error));
+		m_writeTimer.async_wait(m_strand.wrap(boost::bind(&Connection::handleWriteTimeout,
+			boost::weak_ptr<Connection>(shared_from_this()), boost::asio::placeholders::error)));
 
 		boost::asio::async_write(getHandle(),
 			boost::asio::buffer(msg->getOutputBuffer(), msg->size()),
-			boost::bind(&Connection::onWrite, shared_from_this(), msg, boost::asio::placeholders::error));
+			m_strand.wrap(boost::bind(&Connection::onWrite, shared_from_this(), msg, boost::asio::placeholders::error)));
 	}
 	catch(std::exception& e)
 	{
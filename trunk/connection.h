@@ -83,7 +83,7 @@ class ConnectionManager
 		typedef std::map<uint32_t, ConnectBlock> IpConnectMap;
 		IpConnectMap ipConnectMap; 
 
-		std::list<Connection_ptr> m_connections;
+		std::set<Connection_ptr> m_connections;
 		boost::recursive_mutex m_connectionManagerLock;
 };
 
@@ -106,11 +106,12 @@ class Connection : public boost::enable_shared_from_this<Connection>, boost::non
 #endif
 	private:
 		Connection(boost::asio::ip::tcp::socket* socket, boost::asio::io_service& io_service, ServicePort_ptr servicePort):
-			m_socket(socket), m_readTimer(io_service), m_writeTimer(io_service), m_service(io_service), m_servicePort(servicePort)
+			m_socket(socket), m_readTimer(io_service), m_writeTimer(io_service), m_service(io_service),
+			m_strand(io_service), m_servicePort(servicePort)
 		{
 			m_refCount = m_pendingWrite = m_pendingRead = 0;
 			m_connectionState = CONNECTION_STATE_OPEN;
-			m_receivedFirst = m_writeError = m_readError = false;
+			m_receivedFirst = m_readPaused = m_writeError = m_readError = false;
 			m_protocol = NULL;
 
 #ifdef __ENABLE_SERVER_DIAGNOSTIC__
@@ -131,9 +132,15 @@ class Connection : public boost::enable_shared_from_this<Connection>, boost::non
 		boost::asio::ip::tcp::socket& getHandle() {return *m_socket;}
 		uint32_t getIP() const;
 
+		Protocol* getProtocol() const {return m_protocol;}
+
 		void handle(Protocol* protocol);
 		void accept();
 
+		//holds reading the next packet, until the protocol got what it needs to parse it
+		void pauseRead() {m_readPaused = true;}
+		void resumeRead();
+
 		bool send(OutputMessage_ptr msg);
 		void close();
 
@@ -170,8 +177,10 @@ class Connection : public boost::enable_shared_from_this<Connection>, boost::non
 		boost::asio::deadline_timer m_readTimer, m_writeTimer;
 
 		boost::asio::io_service& m_service;
+		boost::asio::io_service::strand m_strand;
+
 		ServicePort_ptr m_servicePort;
-		bool m_receivedFirst, m_writeError, m_readError;
+		bool m_receivedFirst, m_readPaused, m_writeError, m_readError;
 
 		int32_t m_pendingWrite, m_pendingRead;
 		ConnectionState_t m_connectionState;
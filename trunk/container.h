@@ -161,6 +161,7 @@ class Container : public Item, public Cylinder
 
 		ItemList itemlist;
 		friend class ContainerIterator;
+		friend class IOLoginData;
 		friend class IOMapSerialize;
 };
 #endif
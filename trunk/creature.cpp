@@ -32,9 +32,12 @@
 #include "configmanager.h"
 #include "game.h"
 
-boost::recursive_mutex AutoId::lock;
-uint32_t AutoId::count = 1000;
-AutoId::List AutoId::list;
+boost::mutex AutoId::lock;
+uint32_t AutoId::next = 1;
+std::vector<uint8_t> AutoId::generations;
+std::deque<uint32_t> AutoId::freeSlots;
+
+const CreatureEventVector CreatureEventList::m_empty;
 
 extern Game g_game;
 extern ConfigManager g_config;
@@ -83,6 +86,7 @@ Creature::Creature()
 	lastDamageSource = COMBAT_NONE;
 	blockCount = 0;
 	blockTicks = 0;
+	eventsGeneration = CreatureEvent::getGeneration();
 	walkUpdateTicks = 0;
 	checkVector = -1;
 
@@ -1603,13 +1607,11 @@ bool Creature::registerCreatureEvent(const std::string& name)
 	if(!event || !event->isLoaded()) //check for existance
 		return false;
 
-	for(CreatureEventList::iterator it = eventsList.begin(); it != eventsList.end(); ++it)
-	{
-		if((*it) == event) //do not allow registration of same event more than once
-			return false;
-	}
+	if(std::find(eventsList.begin(), eventsList.end(), event) != eventsList.end())
+		return false; //do not allow registration of same event more than once
 
 	eventsList.push_back(event);
+	updateCreatureEvents();
 	return true;
 }
 
@@ -1619,28 +1621,34 @@ bool Creature::unregisterCreatureEvent(const std::string& name)
 	if(!event || !event->isLoaded()) //check for existance
 		return false;
 
-	for(CreatureEventList::iterator it = eventsList.begin(); it != eventsList.end(); ++it)
-	{
-		if((*it) != event)
-			continue;
-
-		eventsList.erase(it);
-		return true; // we shouldn't have a duplicate
-	}
+	CreatureEventVector::iterator it = std::find(eventsList.begin(), eventsList.end(), event);
+	if(it == eventsList.end())
+		return false;
 
-	return false;
+	eventsList.erase(it); // we shouldn't have a duplicate
+	updateCreatureEvents();
+	return true;
 }
 
-CreatureEventList Creature::getCreatureEvents(CreatureEventType_t type)
+void Creature::updateCreatureEvents()
 {
-	CreatureEventList retList;
-	for(CreatureEventList::iterator it = eventsList.begin(); it != eventsList.end(); ++it)
+	// buckets are rebuilt instead of modified, so lists handed out before stay valid
+	CreatureEventVector buckets[CREATURE_EVENT_LAST + 1];
+	for(CreatureEventVector::iterator it = eventsList.begin(); it != eventsList.end(); ++it)
 	{
-		if((*it)->getEventType() == type && (*it)->isLoaded())
-			retList.push_back(*it);
+		if((*it)->isLoaded())
+			buckets[(*it)->getEventType()].push_back(*it);
+	}
+
+	for(uint8_t i = 0; i <= CREATURE_EVENT_LAST; ++i)
+	{
+		if(!buckets[i].empty())
+			eventsBuckets[i].reset(new CreatureEventVector(buckets[i]));
+		else
+			eventsBuckets[i].reset();
 	}
 
-	return retList;
+	eventsGeneration = CreatureEvent::getGeneration();
 }
 
 FrozenPathingConditionCall::FrozenPathingConditionCall(const Position& _targetPos)
@@ -129,7 +129,31 @@ struct DeathLessThan
 };
 
 typedef std::vector<DeathEntry> DeathList;
-typedef std::list<CreatureEvent*> CreatureEventList;
+typedef std::vector<CreatureEvent*> CreatureEventVector;
+typedef boost::shared_ptr<const CreatureEventVector> CreatureEventVector_ptr;
+
+// read-only view over one event bucket, copying it only bumps a reference,
+// so handlers may (un)register events while the list is being walked
+class CreatureEventList
+{
+	public:
+		typedef CreatureEventVector::const_iterator iterator;
+		typedef CreatureEventVector::const_iterator const_iterator;
+
+		CreatureEventList() {}
+		CreatureEventList(const CreatureEventVector_ptr& events): m_events(events) {}
+
+		iterator begin() const {return m_events ? m_events->begin() : m_empty.begin();}
+		iterator end() const {return m_events ? m_events->end() : m_empty.end();}
+
+		bool empty() const {return !m_events;}
+		size_t size() const {return m_events ? m_events->size() : 0;}
+
+	protected:
+		CreatureEventVector_ptr m_events;
+		static const CreatureEventVector m_empty;
+};
+
 typedef std::list<Condition*> ConditionList;
 typedef std::map<std::string, std::string> StorageMap;
 
@@ -444,7 +468,13 @@ class Creature : public AutoId, virtual public Thing
 		//creature script events
 		bool registerCreatureEvent(const std::string& name);
 		bool unregisterCreatureEvent(const std::string& name);
-		CreatureEventList getCreatureEvents(CreatureEventType_t type);
+		CreatureEventList getCreatureEvents(CreatureEventType_t type)
+		{
+			if(eventsGeneration != CreatureEvent::getGeneration())
+				updateCreatureEvents();
+
+			return eventsBuckets[type];
+		}
 
 		virtual void setParent(Cylinder* cylinder)
 		{
@@ -535,8 +565,11 @@ class Creature : public AutoId, virtual public Thing
 		CountMap damageMap;
 		CountMap healMap;
 
-		CreatureEventList eventsList;
-		uint32_t blockCount, blockTicks, lastHitCreature;
+		void updateCreatureEvents();
+
+		CreatureEventVector eventsList;
+		CreatureEventVector_ptr eventsBuckets[CREATURE_EVENT_LAST + 1];
+		uint32_t eventsGeneration, blockCount, blockTicks, lastHitCreature;
 		CombatType_t lastDamageSource;
 
 		#ifdef __DEBUG__
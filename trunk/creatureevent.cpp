@@ -126,6 +126,8 @@ bool CreatureEvents::playerLogout(Player* player, bool forceLogout)
 
 /////////////////////////////////////
 
+uint32_t CreatureEvent::m_generation = 0;
+
 CreatureEvent::CreatureEvent(LuaInterface* _interface):
 Event(_interface)
 {
@@ -342,6 +344,7 @@ void CreatureEvent::copyEvent(CreatureEvent* creatureEvent)
 	m_interface = creatureEvent->m_interface;
 	m_scripted = creatureEvent->m_scripted;
 	m_isLoaded = creatureEvent->m_isLoaded;
+	m_generation++;
 }
 
 void CreatureEvent::clearEvent()
@@ -350,6 +353,7 @@ void CreatureEvent::clearEvent()
 	m_interface = NULL;
 	m_scripted = EVENT_SCRIPT_FALSE;
 	m_isLoaded = false;
+	m_generation++;
 }
 
 uint32_t CreatureEvent::executeLogin(Player* player)
@@ -1170,6 +1174,7 @@ uint32_t CreatureEvent::executeCombatArea(Creature* creature, Tile* tile, bool a
 	//onAreaCombat(cid, ground, position, aggressive)
 	if(m_interface->reserveEnv())
 	{
+		Item* ground = tile->unshareItem(tile->ground);
 		ScriptEnviroment* env = m_interface->getEnv();
 		if(m_scripted == EVENT_SCRIPT_BUFFER)
 		{
@@ -1177,7 +1182,7 @@ uint32_t CreatureEvent::executeCombatArea(Creature* creature, Tile* tile, bool a
 			std::stringstream scriptstream;
 			scriptstream << "local cid = " << env->addThing(creature) << std::endl;
 
-			env->streamThing(scriptstream, "ground", tile->ground, env->addThing(tile->ground));
+			env->streamThing(scriptstream, "ground", ground, env->addThing(ground));
 			env->streamPosition(scriptstream, "position", tile->getPosition(), 0);
 			scriptstream << "local aggressive = " << (aggressive ? "true" : "false") << std::endl;
 
@@ -1207,7 +1212,7 @@ uint32_t CreatureEvent::executeCombatArea(Creature* creature, Tile* tile, bool a
 			m_interface->pushFunction(m_scriptId);
 
 			lua_pushnumber(L, env->addThing(creature));
-			LuaInterface::pushThing(L, tile->ground, env->addThing(tile->ground));
+			LuaInterface::pushThing(L, ground, env->addThing(ground));
 
 			LuaInterface::pushPosition(L, tile->getPosition(), 0);
 			lua_pushboolean(L, aggressive);
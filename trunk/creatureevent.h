@@ -50,7 +50,8 @@ enum CreatureEventType_t
 	CREATURE_EVENT_CAST,
 	CREATURE_EVENT_KILL,
 	CREATURE_EVENT_DEATH,
-	CREATURE_EVENT_PREPAREDEATH
+	CREATURE_EVENT_PREPAREDEATH,
+	CREATURE_EVENT_LAST = CREATURE_EVENT_PREPAREDEATH
 };
 
 enum StatsChange_t
@@ -108,6 +109,9 @@ class CreatureEvent : public Event
 		void copyEvent(CreatureEvent* creatureEvent);
 		void clearEvent();
 
+		// bumped whenever an event gets (un)loaded, creatures rebuild their buckets on mismatch
+		static uint32_t getGeneration() {return m_generation;}
+
 		//scripting
 		uint32_t executeLogin(Player* player);
 		uint32_t executeLogout(Player* player, bool forceLogout);
@@ -144,5 +148,7 @@ class CreatureEvent : public Event
 		bool m_isLoaded;
 		std::string m_eventName;
 		CreatureEventType_t m_type;
+
+		static uint32_t m_generation;
 };
 #endif
@@ -33,35 +33,203 @@
 extern ConfigManager g_config;
 #endif
 
+#if defined _MSC_VER
+#define DATABASE_THREAD_LOCAL __declspec(thread)
+#else
+#define DATABASE_THREAD_LOCAL __thread
+#endif
+
 boost::recursive_mutex DBQuery::databaseLock;
 Database* _Database::_instance = NULL;
 
-Database* _Database::getInstance()
+std::vector<Database*> _Database::m_pool;
+boost::mutex _Database::m_poolLock;
+LatencyHistogram _Database::latency[DBLATENCY_LAST + 1];
+
+static DATABASE_THREAD_LOCAL std::vector<std::string>* recorder = NULL;
+static DATABASE_THREAD_LOCAL Database* connection = NULL;
+static DATABASE_THREAD_LOCAL bool worker = false;
+
+Database* _Database::create()
 {
-	if(!_instance)
-	{
 #if defined MULTI_SQL_DRIVERS
 #ifdef __USE_MYSQL__
-		if(g_config.getString(ConfigManager::SQL_TYPE) == "mysql")
-			_instance = new DatabaseMySQL;
+	if(g_config.getString(ConfigManager::SQL_TYPE) == "mysql")
+		return new DatabaseMySQL;
 #endif
 #ifdef __USE_SQLITE__
-		if(g_config.getString(ConfigManager::SQL_TYPE) == "sqlite")
-			_instance = new DatabaseSQLite;
+	if(g_config.getString(ConfigManager::SQL_TYPE) == "sqlite")
+		return new DatabaseSQLite;
 #endif
 #ifdef __USE_PGSQL__
-		if(g_config.getString(ConfigManager::SQL_TYPE) == "pgsql")
-			_instance = new DatabasePgSQL;
+	if(g_config.getString(ConfigManager::SQL_TYPE) == "pgsql")
+		return new DatabasePgSQL;
 #endif
+	return NULL;
 #else
-		_instance = new Database;
+	return new Database;
 #endif
+}
+
+Database* _Database::getInstance()
+{
+	if(connection)
+	{
+		connection->use();
+		return connection;
 	}
 
+	if(!_instance)
+		_instance = create();
+
 	_instance->use();
 	return _instance;
 }
 
+void _Database::connectThread()
+{
+	worker = true;
+	{
+		//the shared connection has to exist before the workers race for it
+		DBQuery query;
+		if(!getInstance()->getParam(DBPARAM_CONCURRENT))
+			return;
+	}
+
+	Database* db = create();
+	if(!db || !db->isConnected())
+	{
+		std::clog << "[Warning - Database::connectThread] Could not open a connection for database worker, using the shared one." << std::endl;
+		delete db;
+		return;
+	}
+
+	connection = db;
+	boost::mutex::scoped_lock lockClass(m_poolLock);
+	m_pool.push_back(db);
+}
+
+bool _Database::hasOwnConnection()
+{
+	return connection != NULL;
+}
+
+bool _Database::isWorkerThread()
+{
+	return worker;
+}
+
+uint32_t _Database::getPoolSize()
+{
+	boost::mutex::scoped_lock lockClass(m_poolLock);
+	return m_pool.size();
+}
+
+void _Database::setRecorder(std::vector<std::string>* _recorder)
+{
+	recorder = _recorder;
+}
+
+std::vector<std::string>* _Database::getRecorder()
+{
+	return recorder;
+}
+
+bool _Database::recordQuery(const std::string& query)
+{
+	if(!recorder)
+		return false;
+
+	recorder->push_back(query);
+	return true;
+}
+
+bool _Database::executeRecorded(Database* db, const std::vector<std::string>& statements)
+{
+	DBQuery query; //lock mutex
+	DBTransaction trans(db);
+	if(!trans.begin())
+		return false;
+
+	for(std::vector<std::string>::const_iterator it = statements.begin(); it != statements.end(); ++it)
+	{
+		if(!db->query(*it))
+			return false;
+	}
+
+	return trans.commit();
+}
+
+void _Database::asyncQuery(const std::string& query, const DBCallback& callback/* = DBCallback()*/)
+{
+	TaskPool::getInstance(TASKPOOL_DATABASE).addTask(createTask(boost::bind(&_Database::runQuery,
+		query, callback, boost::posix_time::microsec_clock::universal_time())));
+}
+
+void _Database::asyncStoreQuery(const std::string& query, const DBResultCallback& callback)
+{
+	TaskPool::getInstance(TASKPOOL_DATABASE).addTask(createTask(boost::bind(&_Database::runStoreQuery,
+		query, callback, boost::posix_time::microsec_clock::universal_time())));
+}
+
+void _Database::asyncTransaction(const DBJob& job, const DBCallback& callback/* = DBCallback()*/)
+{
+	TaskPool::getInstance(TASKPOOL_DATABASE).addTask(createTask(boost::bind(&_Database::runTransaction,
+		job, callback, boost::posix_time::microsec_clock::universal_time())));
+}
+
+void _Database::runQuery(std::string query, DBCallback callback, boost::posix_time::ptime queued)
+{
+	latency[DBLATENCY_QUEUE].add((boost::posix_time::microsec_clock::universal_time() - queued).total_microseconds());
+	bool ret = false;
+	{
+		DBQuery lock; //lock mutex
+		ret = getInstance()->query(query);
+	}
+
+	if(!callback.empty())
+		Dispatcher::getInstance().addTask(createTask(boost::bind(callback, ret)));
+}
+
+void _Database::runStoreQuery(std::string query, DBResultCallback callback, boost::posix_time::ptime queued)
+{
+	latency[DBLATENCY_QUEUE].add((boost::posix_time::microsec_clock::universal_time() - queued).total_microseconds());
+	DBResult* result = NULL;
+	{
+		DBQuery lock; //lock mutex
+		result = getInstance()->storeQuery(query);
+	}
+
+	if(!callback.empty())
+		Dispatcher::getInstance().addTask(createTask(boost::bind(&_Database::deliverResult, callback, result)));
+	else if(result)
+		result->free();
+}
+
+void _Database::runTransaction(DBJob job, DBCallback callback, boost::posix_time::ptime queued)
+{
+	latency[DBLATENCY_QUEUE].add((boost::posix_time::microsec_clock::universal_time() - queued).total_microseconds());
+	bool ret = false;
+	{
+		//the lock (or our own connection) keeps every statement of the job on one connection
+		DBQuery lock;
+		Database* db = getInstance();
+
+		DBTransaction trans(db);
+		ret = trans.begin() && job(db) && trans.commit();
+	}
+
+	if(!callback.empty())
+		Dispatcher::getInstance().addTask(createTask(boost::bind(callback, ret)));
+}
+
+void _Database::deliverResult(DBResultCallback callback, DBResult* result)
+{
+	callback(result);
+	if(result)
+		result->free();
+}
+
 DBResult* _Database::verifyResult(DBResult* result)
 {
 	if(result->next())
@@ -83,7 +251,7 @@ DBInsert::DBInsert(Database* db)
 void DBInsert::setQuery(const std::string& query)
 {
 	m_query = query;
-	m_buf = "";
+	m_buf = m_statement = "";
 	m_rows = 0;
 }
 
@@ -117,6 +285,29 @@ bool DBInsert::addRow(std::stringstream& row)
 	return ret;
 }
 
+bool DBInsert::addRow(DBParams& row)
+{
+	bool ret = false;
+	if(m_multiLine)
+		ret = addRow(row.render(m_db));
+	else
+	{
+		if(m_statement.empty())
+		{
+			m_statement = m_query + "(";
+			for(size_t i = 0; i < row.size(); ++i)
+				m_statement += (i ? ", ?" : "?");
+
+			m_statement += ")";
+		}
+
+		ret = m_db->executeStatement(m_statement, row);
+	}
+
+	row.clear();
+	return ret;
+}
+
 bool DBInsert::execute()
 {
 	if(!m_multiLine || m_buf.length() < 1 || !m_rows) // INSERTs were executed on-fly or there's no rows to execute
@@ -128,3 +319,76 @@ bool DBInsert::execute()
 	m_buf = "";
 	return ret;
 }
+
+DBParams& DBParams::bindInt(int64_t value)
+{
+	m_params.push_back(Param());
+	m_params.back().type = TYPE_INT;
+	m_params.back().number = value;
+	return *this;
+}
+
+DBParams& DBParams::bindString(const std::string& value)
+{
+	m_params.push_back(Param());
+	m_params.back().type = TYPE_STRING;
+	m_params.back().number = 0;
+	m_params.back().data = value;
+	return *this;
+}
+
+DBParams& DBParams::bindBlob(const char* value, uint32_t length)
+{
+	m_params.push_back(Param());
+	m_params.back().type = TYPE_BLOB;
+	m_params.back().number = 0;
+	m_params.back().data.assign(value, length);
+	return *this;
+}
+
+std::string DBParams::render(Database* db, const std::string& query/* = ""*/) const
+{
+	std::stringstream ss;
+	size_t last = 0;
+	for(size_t i = 0; i < m_params.size(); ++i)
+	{
+		if(!query.empty())
+		{
+			size_t pos = query.find('?', last);
+			if(pos == std::string::npos)
+				break;
+
+			ss << query.substr(last, pos - last);
+			last = pos + 1;
+		}
+		else if(i)
+			ss << ", ";
+
+		const Param& param = m_params[i];
+		switch(param.type)
+		{
+			case TYPE_INT:
+				ss << param.number;
+				break;
+			case TYPE_STRING:
+				ss << db->escapeString(param.data);
+				break;
+			case TYPE_BLOB:
+				ss << db->escapeBlob(param.data.data(), param.data.size());
+				break;
+		}
+	}
+
+	if(!query.empty())
+		ss << query.substr(last);
+
+	return ss.str();
+}
+
+bool DBStatement::execute()
+{
+	DBQuery query; //lock mutex
+	bool ret = m_db->executeStatement(m_query, *this);
+	clear();
+	return ret;
+}
@@ -20,6 +20,7 @@
 #include "otsystem.h"
 
 #include "enums.h"
+#include "dispatcher.h"
 #include <sstream>
 
 #ifdef MULTI_SQL_DRIVERS
@@ -63,9 +64,25 @@ typedef RESULT_CLASS DBResult;
 
 enum DBParam_t
 {
-	DBPARAM_MULTIINSERT = 1
+	DBPARAM_MULTIINSERT = 1,
+	DBPARAM_CONCURRENT = 2
 };
 
+enum DBLatency_t
+{
+	DBLATENCY_QUERY = 0,
+	DBLATENCY_STORE,
+	DBLATENCY_STATEMENT,
+	DBLATENCY_QUEUE,
+	DBLATENCY_LAST = DBLATENCY_QUEUE
+};
+
+class DBParams;
+
+typedef boost::function<void (bool)> DBCallback;
+typedef boost::function<void (DBResult*)> DBResultCallback;
+typedef boost::function<bool (Database*)> DBJob;
+
 class _Database
 {
 	public:
@@ -73,11 +90,34 @@ class _Database
 		* Singleton implementation.
 		*
 		* Retruns instance of database handler. Don't create database (or drivers) instances in your code - instead of it use Database::getInstance()-> This method stores static instance of connection class internaly to make sure exacly one instance of connection is created for entire system.
+		* Database worker threads get the connection they opened in connectThread() instead.
 		*
 		* @return database connection handler singletor
 		*/
 		static Database* getInstance();
 
+		/**
+		* Connection pool.
+		*
+		* Called once by each database worker thread, opens a connection owned by that thread. Drivers that can't run concurrent connections keep the workers on the shared one.
+		*/
+		static void connectThread();
+
+		/**
+		* Whether the calling thread queries through a connection of its own, such threads don't take the database lock.
+		*/
+		static bool hasOwnConnection();
+
+		/**
+		* Whether the calling thread is a database worker, set before its connection is opened.
+		*/
+		static bool isWorkerThread();
+
+		/**
+		* Number of connections opened by the database workers.
+		*/
+		static uint32_t getPoolSize();
+
 		/**
 		* Database information.
 		*
@@ -139,6 +179,17 @@ class _Database
 		*/
 		DATABASE_VIRTUAL DBResult* storeQuery(const std::string&) {return 0;}
 
+		/**
+		* Executes prepared statement.
+		*
+		* Executes query with "?" placeholders, binding the given values to them. Drivers prepare each query once per connection and keep it for later calls.
+		*
+		* @param std::string query command
+		* @param DBParams& values for the placeholders, in order
+		* @return true on success, false on error
+		*/
+		DATABASE_VIRTUAL bool executeStatement(const std::string&, const DBParams&) {return 0;}
+
 		/**
 		* Escapes string for query.
 		*
@@ -182,17 +233,73 @@ class _Database
 		*/
 		DATABASE_VIRTUAL DatabaseEngine_t getDatabaseEngine() {return DATABASE_ENGINE_NONE;}
 
+		/**
+		* Statement recording.
+		*
+		* While a list is set for the calling thread, query() appends statements to it instead of executing them, and transactions are left to whoever runs the list later. storeQuery() is not affected.
+		*
+		* @param std::vector<std::string>* list to record into, NULL stops recording
+		*/
+		static void setRecorder(std::vector<std::string>* recorder);
+		static std::vector<std::string>* getRecorder();
+
+		/**
+		* Executes recorded statements.
+		*
+		* Runs the whole list in one transaction while holding the database lock, so either all or none of it is applied.
+		*
+		* @param Database* database wrapper
+		* @param std::vector<std::string>& recorded statements
+		* @return true on success, false on error
+		*/
+		static bool executeRecorded(Database* db, const std::vector<std::string>& statements);
+
+		/**
+		* Asynchronous queries.
+		*
+		* Queued to the database workers, callbacks are handed back to the dispatcher thread. Results passed to the callback are freed once it returns and may be NULL on error.
+		*
+		* @param std::string query
+		* @param DBCallback called with the outcome, may be empty
+		*/
+		static void asyncQuery(const std::string& query, const DBCallback& callback = DBCallback());
+		static void asyncStoreQuery(const std::string& query, const DBResultCallback& callback);
+
+		/**
+		* Asynchronous transaction.
+		*
+		* Runs the job inside one transaction on the connection of a single worker, so statements that belong together never get split across the pool.
+		*
+		* @param DBJob job to run, returning false rolls back
+		* @param DBCallback called with the outcome, may be empty
+		*/
+		static void asyncTransaction(const DBJob& job, const DBCallback& callback = DBCallback());
+
+		/**
+		* Query latency in microseconds, per type. The queue entry measures how long asynchronous queries wait for a worker.
+		*/
+		static LatencyHistogram latency[DBLATENCY_LAST + 1];
+
 	protected:
 		_Database() {m_connected = false;}
 		DATABASE_VIRTUAL ~_Database() {}
 
 		DBResult* verifyResult(DBResult* result);
+		static bool recordQuery(const std::string& query);
 
 		bool m_connected;
 		int64_t m_use;
 
 	private:
+		static Database* create();
+		static void runQuery(std::string query, DBCallback callback, boost::posix_time::ptime queued);
+		static void runStoreQuery(std::string query, DBResultCallback callback, boost::posix_time::ptime queued);
+		static void runTransaction(DBJob job, DBCallback callback, boost::posix_time::ptime queued);
+		static void deliverResult(DBResultCallback callback, DBResult* result);
+
 		static Database* _instance;
+		static std::vector<Database*> m_pool;
+		static boost::mutex m_poolLock;
 };
 
 class _DBResult
@@ -239,17 +346,113 @@ class _DBResult
 /**
  * Thread locking hack.
  *
- * By using this class for your queries you lock and unlock database for threads.
+ * By using this class for your queries you lock and unlock database for threads. Threads with a connection of their own skip the lock.
 */
 class DBQuery : public std::stringstream
 {
 	friend class _Database;
+	friend class DBStatement;
 	public:
-		DBQuery() {databaseLock.lock();}
-		virtual ~DBQuery() {str(""); databaseLock.unlock();}
+		DBQuery(): m_locked(!_Database::hasOwnConnection()) {if(m_locked) databaseLock.lock();}
+		virtual ~DBQuery() {str(""); if(m_locked) databaseLock.unlock();}
 
 	protected:
 		static boost::recursive_mutex databaseLock;
+		bool m_locked;
+};
+
+/**
+ * Latency probe.
+ *
+ * Adds the time between its construction and destruction to the given histogram.
+*/
+class DBTimer
+{
+	public:
+		DBTimer(DBLatency_t type): m_type(type), m_start(boost::posix_time::microsec_clock::universal_time()) {}
+		virtual ~DBTimer()
+		{
+			_Database::latency[m_type].add((boost::posix_time::microsec_clock::universal_time() - m_start).total_microseconds());
+		}
+
+	protected:
+		DBLatency_t m_type;
+		boost::posix_time::ptime m_start;
+};
+
+/**
+ * Statement values.
+ *
+ * Typed values for the "?" placeholders of a statement, bound in order.
+ */
+class DBParams
+{
+	public:
+		enum Type_t
+		{
+			TYPE_INT,
+			TYPE_STRING,
+			TYPE_BLOB
+		};
+
+		struct Param
+		{
+			Type_t type;
+			int64_t number;
+			std::string data;
+		};
+
+		DBParams() {}
+		virtual ~DBParams() {}
+
+		DBParams& bindInt(int64_t value);
+		DBParams& bindString(const std::string& value);
+		DBParams& bindBlob(const char* value, uint32_t length);
+
+		void clear() {m_params.clear();}
+		size_t size() const {return m_params.size();}
+		const Param& operator[](size_t index) const {return m_params[index];}
+
+		/**
+		* Renders values as SQL text.
+		*
+		* Used where values can't be bound, like recorded statements or multiline INSERTs.
+		*
+		* @param Database* database wrapper used to escape the values
+		* @param std::string query with placeholders, if empty values are just separated by commas
+		* @return SQL text
+		*/
+		std::string render(Database* db, const std::string& query = "") const;
+
+	protected:
+		std::vector<Param> m_params;
+};
+
+/**
+ * Prepared statement.
+ *
+ * Holds a query with "?" placeholders, values are bound and the statement executed as many times as needed.
+ */
+class DBStatement : public DBParams
+{
+	public:
+		/**
+		* Associates with given database handler.
+		*
+		* @param Database* database wrapper
+		* @param std::string& query with placeholders
+		*/
+		DBStatement(Database* db, const std::string& query): m_db(db), m_query(query) {}
+		virtual ~DBStatement() {}
+
+		/**
+		* Executes with the values bound so far, then clears them.
+		*/
+		bool execute();
+
+	protected:
+		Database* m_db;
+		std::string m_query;
 };
 
 /**
@@ -287,6 +490,10 @@ class DBInsert
 		* Allows to use addRow() with stringstream as parameter.
 		*/
 		bool addRow(std::stringstream& row);
+		/**
+		* Adds new row from typed values, prepared on databases that doesn't support multiline INSERTs.
+		*/
+		bool addRow(DBParams& row);
 
 		/**
 		* Executes current buffer.
@@ -298,7 +505,7 @@ class DBInsert
 		bool m_multiLine;
 
 		uint32_t m_rows;
-		std::string m_query, m_buf;
+		std::string m_query, m_buf, m_statement;
 };
 
 
@@ -319,17 +526,30 @@ class DBTransaction
 		{
 			m_database = database;
 			m_state = STATE_NO_START;
+			m_recorded = 0;
 		}
 
 		virtual ~DBTransaction()
 		{
-			if(m_state == STATE_START)
+			if(m_state != STATE_START)
+				return;
+
+			if(std::vector<std::string>* recorder = Database::getRecorder())
+				recorder->resize(m_recorded);
+			else
 				m_database->rollback();
 		}
 
 		bool begin()
 		{
 			m_state = STATE_START;
+			if(std::vector<std::string>* recorder = Database::getRecorder())
+			{
+				//recorded lists run in a transaction of their own
+				m_recorded = recorder->size();
+				return true;
+			}
+
 			return m_database->beginTransaction();
 		}
 
@@ -339,11 +559,15 @@ class DBTransaction
 				return false;
 
 			m_state = STEATE_COMMIT;
+			if(Database::getRecorder())
+				return true;
+
 			return m_database->commit();
 		}
 
 	private:
 		Database* m_database;
+		size_t m_recorded;
 		enum TransactionStates_t
 		{
 			STATE_NO_START,
@@ -1264,6 +1264,45 @@ uint32_t DatabaseManager::updateDatabase()
 			return 31;
 		}
 
+		case 31:
+		{
+			std::cout << "> Updating database to version 32..." << std::endl;
+			switch(db->getDatabaseEngine())
+			{
+				case DATABASE_ENGINE_SQLITE:
+				{
+					query << "CREATE TABLE IF NOT EXISTS \"player_depots\" ( \"player_id\" INTEGER NOT NULL, \"depot_id\" INTEGER NOT NULL, \"data\" BLOB NOT NULL, UNIQUE (\"player_id\", \"depot_id\"), FOREIGN KEY (\"player_id\") REFERENCES \"players\" (\"id\") );";
+					db->query(query.str());
+					query.str("");
+
+					//recreated by checkTriggers, now including player_depots
+					query << "DROP TRIGGER IF EXISTS \"ondelete_players\";";
+					break;
+				}
+
+				case DATABASE_ENGINE_MYSQL:
+				{
+					query << "CREATE TABLE IF NOT EXISTS `player_depots` ( `player_id` INT NOT NULL, `depot_id` INT NOT NULL, `data` LONGBLOB NOT NULL, UNIQUE (`player_id`, `depot_id`), FOREIGN KEY (`player_id`) REFERENCES `players` (`id`) ON DELETE CASCADE ) ENGINE = InnoDB;";
+					break;
+				}
+
+				case DATABASE_ENGINE_POSTGRESQL:
+				{
+					query << "CREATE TABLE IF NOT EXISTS \"player_depots\" ( \"player_id\" INT NOT NULL, \"depot_id\" INT NOT NULL, \"data\" BYTEA NOT NULL, UNIQUE (\"player_id\", \"depot_id\"), FOREIGN KEY (\"player_id\") REFERENCES \"players\" (\"id\") ON DELETE CASCADE );";
+					break;
+				}
+
+				default:
+					break;
+			}
+
+			db->query(query.str());
+			query.str("");
+
+			registerDatabaseConfig("db_version", 32);
+			return 32;
+		}
+
 		default:
 			break;
 	}
@@ -1618,6 +1657,8 @@ void DatabaseManager::checkTriggers()
 				"onupdate_house_lists",
 				"oninsert_player_depotitems",
 				"onupdate_player_depotitems",
+				"oninsert_player_depots",
+				"onupdate_player_depots",
 				"oninsert_player_skills",
 				"onupdate_player_skills",
 				"oninsert_player_storage",
@@ -1686,6 +1727,7 @@ BEGIN\
 	DELETE FROM `player_skills` WHERE `player_id` = OLD.`id`;\
 	DELETE FROM `player_items` WHERE `player_id` = OLD.`id`;\
 	DELETE FROM `player_depotitems` WHERE `player_id` = OLD.`id`;\
+	DELETE FROM `player_depots` WHERE `player_id` = OLD.`id`;\
 	DELETE FROM `player_spells` WHERE `player_id` = OLD.`id`;\
 	DELETE FROM `player_killers` WHERE `player_id` = OLD.`id`;\
 	DELETE FROM `player_deaths` WHERE `player_id` = OLD.`id`;\
@@ -1720,6 +1762,8 @@ END;",
 
 				"CREATE TRIGGER `oninsert_player_depotitems` BEFORE INSERT ON `player_depotitems` FOR EACH ROW BEGIN SELECT RAISE(ROLLBACK, 'INSERT on table `player_depotitems` violates foreign: `player_id`') WHERE NEW.`player_id` IS NULL OR (SELECT `id` FROM `players` WHERE `id` = NEW.`player_id`) IS NULL; END;",
 				"CREATE TRIGGER `onupdate_player_depotitems` BEFORE UPDATE ON `player_depotitems` FOR EACH ROW BEGIN SELECT RAISE(ROLLBACK, 'UPDATE on table `player_depotitems` violates foreign: `player_id`') WHERE NEW.`player_id` IS NULL OR (SELECT `id` FROM `players` WHERE `id` = NEW.`player_id`) IS NULL; END;",
+				"CREATE TRIGGER `oninsert_player_depots` BEFORE INSERT ON `player_depots` FOR EACH ROW BEGIN SELECT RAISE(ROLLBACK, 'INSERT on table `player_depots` violates foreign: `player_id`') WHERE NEW.`player_id` IS NULL OR (SELECT `id` FROM `players` WHERE `id` = NEW.`player_id`) IS NULL; END;",
+				"CREATE TRIGGER `onupdate_player_depots` BEFORE UPDATE ON `player_depots` FOR EACH ROW BEGIN SELECT RAISE(ROLLBACK, 'UPDATE on table `player_depots` violates foreign: `player_id`') WHERE NEW.`player_id` IS NULL OR (SELECT `id` FROM `players` WHERE `id` = NEW.`player_id`) IS NULL; END;",
 
 				"CREATE TRIGGER `oninsert_player_skills` BEFORE INSERT ON `player_skills` FOR EACH ROW BEGIN SELECT RAISE(ROLLBACK, 'INSERT on table `player_skills` violates foreign: `player_id`') WHERE NEW.`player_id` IS NULL OR (SELECT `id` FROM `players` WHERE `id` = NEW.`player_id`) IS NULL; END;",
 				"CREATE TRIGGER `onupdate_player_skills` BEFORE UPDATE ON `player_skills` FOR EACH ROW BEGIN SELECT RAISE(ROLLBACK, 'UPDATE on table `player_skills` violates foreign: `player_id`') WHERE NEW.`player_id` IS NULL OR (SELECT `id` FROM `players` WHERE `id` = NEW.`player_id`) IS NULL; END;",
@@ -57,6 +57,10 @@ DatabaseMySQL::DatabaseMySQL() :
 		//Read this http://dev.mysql.com/doc/refman/5.0/en/mysql-options.html for more information.
 		std::clog << std::endl << "> WARNING: Outdated MySQL server detected, consider upgrading to a newer version." << std::endl;
 
+	//worker connections are only ever touched by their own thread, they rely on reconnecting instead
+	if(isWorkerThread())
+		return;
+
 	timeout = g_config.getNumber(ConfigManager::SQL_KEEPALIVE) * 1000;
 	if(timeout)
 		m_timeoutTask = Scheduler::getInstance().addEvent(createSchedulerTask(timeout,
@@ -79,6 +83,7 @@ DatabaseMySQL::DatabaseMySQL() :
 
 DatabaseMySQL::~DatabaseMySQL()
 {
+	clearStatements();
 	mysql_close(&m_handle);
 	if(m_timeoutTask != 0)
 		Scheduler::getInstance().stopEvent(m_timeoutTask);
@@ -88,6 +93,8 @@ bool DatabaseMySQL::connect(bool _reconnect)
 {
 	if(_reconnect)
 	{
+		//prepared statements don't survive the connection
+		clearStatements();
 		std::clog << "WARNING: MYSQL Lost connection, attempting to reconnect..." << std::endl;
 		if(++m_attempts > MAX_RECONNECT_ATTEMPTS)
 		{
@@ -113,6 +120,7 @@ bool DatabaseMySQL::getParam(DBParam_t param)
 	switch(param)
 	{
 		case DBPARAM_MULTIINSERT:
+		case DBPARAM_CONCURRENT:
 			return true;
 		default:
 			break;
@@ -151,6 +159,10 @@ bool DatabaseMySQL::commit()
 
 bool DatabaseMySQL::query(const std::string &query)
 {
+	if(recordQuery(query))
+		return true;
+
+	DBTimer timer(DBLATENCY_QUERY);
 	if(!m_connected && !connect(true))
 		return false;
 
@@ -178,6 +190,7 @@ bool DatabaseMySQL::query(const std::string &query)
 
 DBResult* DatabaseMySQL::storeQuery(const std::string &query)
 {
+	DBTimer timer(DBLATENCY_STORE);
 	if(!m_connected && !connect(true))
 		return NULL;
 
@@ -209,6 +222,100 @@ DBResult* DatabaseMySQL::storeQuery(const std::string &query)
 	return NULL;
 }
 
+bool DatabaseMySQL::executeStatement(const std::string& query, const DBParams& params)
+{
+	if(getRecorder())
+		return recordQuery(params.render(this, query));
+
+	DBTimer timer(DBLATENCY_STATEMENT);
+	if(!m_connected && !connect(true))
+		return false;
+
+	MYSQL_STMT* stmt = getStatement(query);
+	if(!stmt)
+		return false;
+
+	// values are sent in the binary protocol, nothing has to be escaped
+	size_t count = params.size();
+	std::vector<MYSQL_BIND> binds(count);
+	std::vector<unsigned long> lengths(count);
+	for(size_t i = 0; i < count; ++i)
+	{
+		const DBParams::Param& param = params[i];
+		MYSQL_BIND& bind = binds[i];
+
+		memset(&bind, 0, sizeof(MYSQL_BIND));
+		if(param.type == DBParams::TYPE_INT)
+		{
+			bind.buffer_type = MYSQL_TYPE_LONGLONG;
+			bind.buffer = (void*)&param.number;
+			continue;
+		}
+
+		lengths[i] = param.data.size();
+		bind.buffer_type = param.type == DBParams::TYPE_BLOB ? MYSQL_TYPE_BLOB : MYSQL_TYPE_STRING;
+		bind.buffer = (void*)param.data.data();
+		bind.buffer_length = lengths[i];
+		bind.length = &lengths[i];
+	}
+
+	if(mysql_stmt_bind_param(stmt, count ? &binds[0] : NULL) || mysql_stmt_execute(stmt))
+	{
+		int32_t error = mysql_stmt_errno(stmt);
+		std::clog << "mysql_stmt_execute(): " << query << " - MYSQL ERROR: " << mysql_stmt_error(stmt) << " (" << error << ")" << std::endl;
+
+		//prepare it again next time, the handle may be gone with a reconnect
+		m_statements.erase(query);
+		mysql_stmt_close(stmt);
+		if(error == CR_SERVER_LOST || error == CR_SERVER_GONE_ERROR)
+			m_connected = false;
+
+		return false;
+	}
+
+	return true;
+}
+
+MYSQL_STMT* DatabaseMySQL::getStatement(const std::string& query)
+{
+	StatementMap::iterator it = m_statements.find(query);
+	if(it != m_statements.end())
+		return it->second;
+
+#ifdef __SQL_QUERY_DEBUG__
+	std::clog << "MYSQL DEBUG, prepare: " << query.c_str() << std::endl;
+#endif
+	MYSQL_STMT* stmt = mysql_stmt_init(&m_handle);
+	if(!stmt)
+	{
+		std::clog << "mysql_stmt_init(): " << query << " - MYSQL ERROR: " << mysql_error(&m_handle) << std::endl;
+		return NULL;
+	}
+
+	if(mysql_stmt_prepare(stmt, query.c_str(), query.length()))
+	{
+		int32_t error = mysql_stmt_errno(stmt);
+		std::clog << "mysql_stmt_prepare(): " << query << " - MYSQL ERROR: " << mysql_stmt_error(stmt) << " (" << error << ")" << std::endl;
+
+		mysql_stmt_close(stmt);
+		if(error == CR_SERVER_LOST || error == CR_SERVER_GONE_ERROR)
+			m_connected = false;
+
+		return NULL;
+	}
+
+	m_statements[query] = stmt;
+	return stmt;
+}
+
+void DatabaseMySQL::clearStatements()
+{
+	for(StatementMap::iterator it = m_statements.begin(); it != m_statements.end(); ++it)
+		mysql_stmt_close(it->second);
+
+	m_statements.clear();
+}
+
 std::string DatabaseMySQL::escapeBlob(const char* s, uint32_t length)
 {
 	if(*s == '\0')
@@ -45,6 +45,7 @@ class DatabaseMySQL : public _Database
 
 		DATABASE_VIRTUAL bool query(const std::string& query);
 		DATABASE_VIRTUAL DBResult* storeQuery(const std::string& query);
+		DATABASE_VIRTUAL bool executeStatement(const std::string& query, const DBParams& params);
 
 		DATABASE_VIRTUAL std::string escapeString(const std::string &s) {return escapeBlob(s.c_str(), s.length());}
 		DATABASE_VIRTUAL std::string escapeBlob(const char* s, uint32_t length);
@@ -55,9 +56,15 @@ class DatabaseMySQL : public _Database
 	protected:
 		DATABASE_VIRTUAL void keepAlive();
 
+		MYSQL_STMT* getStatement(const std::string& query);
+		void clearStatements();
+
 		MYSQL m_handle;
 		uint16_t m_attempts;
 		uint32_t m_timeoutTask;
+
+		typedef std::map<std::string, MYSQL_STMT*> StatementMap;
+		StatementMap m_statements;
 };
 
 class MySQLResult : public _DBResult
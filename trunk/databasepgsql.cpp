@@ -39,6 +39,7 @@ bool DatabasePgSQL::getParam(DBParam_t param)
 	switch(param)
 	{
 		case DBPARAM_MULTIINSERT:
+		case DBPARAM_CONCURRENT:
 			return true;
 
 		default:
@@ -50,6 +51,10 @@ bool DatabasePgSQL::getParam(DBParam_t param)
 
 bool DatabasePgSQL::query(const std::string& query)
 {
+	if(recordQuery(query))
+		return true;
+
+	DBTimer timer(DBLATENCY_QUERY);
 	if(!m_connected)
 		return false;
 
@@ -70,6 +75,7 @@ bool DatabasePgSQL::query(const std::string& query)
 
 DBResult* DatabasePgSQL::storeQuery(const std::string& query)
 {
+	DBTimer timer(DBLATENCY_STORE);
 	if(!m_connected)
 		return NULL;
 
@@ -88,6 +94,74 @@ DBResult* DatabasePgSQL::storeQuery(const std::string& query)
 	return verifyResult(result);
 }
 
+bool DatabasePgSQL::executeStatement(const std::string& query, const DBParams& params)
+{
+	if(getRecorder())
+		return recordQuery(params.render(this, query));
+
+	DBTimer timer(DBLATENCY_STATEMENT);
+	if(!m_connected)
+		return false;
+
+	std::string name;
+	StatementMap::iterator it = m_statements.find(query);
+	if(it == m_statements.end())
+	{
+		std::stringstream ss;
+		ss << "statement" << m_statements.size();
+		name = ss.str();
+
+		PGresult* res = PQprepare(m_handle, name.c_str(), _parse(query, true).c_str(), 0, NULL);
+		if(PQresultStatus(res) != PGRES_COMMAND_OK)
+		{
+			std::clog << "PQprepare(): " << query << ": " << PQresultErrorMessage(res) << std::endl;
+			PQclear(res);
+			return false;
+		}
+
+		PQclear(res);
+		m_statements[query] = name;
+	}
+	else
+		name = it->second;
+
+	// numbers and strings go as text, blobs in binary format so they don't need escaping
+	int32_t count = params.size();
+	std::vector<std::string> numbers(count);
+	std::vector<const char*> values(count);
+	std::vector<int32_t> lengths(count), formats(count);
+	for(int32_t i = 0; i < count; ++i)
+	{
+		const DBParams::Param& param = params[i];
+		if(param.type == DBParams::TYPE_INT)
+		{
+			std::stringstream ss;
+			ss << param.number;
+
+			numbers[i] = ss.str();
+			values[i] = numbers[i].c_str();
+		}
+		else
+			values[i] = param.data.c_str();
+
+		lengths[i] = param.type == DBParams::TYPE_BLOB ? param.data.size() : 0;
+		formats[i] = param.type == DBParams::TYPE_BLOB ? 1 : 0;
+	}
+
+	PGresult* res = PQexecPrepared(m_handle, name.c_str(), count, count ? &values[0] : NULL,
+		count ? (const int*)&lengths[0] : NULL, count ? (const int*)&formats[0] : NULL, 0);
+	ExecStatusType stat = PQresultStatus(res);
+	if(stat != PGRES_COMMAND_OK && stat != PGRES_TUPLES_OK)
+	{
+		std::clog << "PQexecPrepared(): " << query << ": " << PQresultErrorMessage(res) << std::endl;
+		PQclear(res);
+		return false;
+	}
+
+	PQclear(res);
+	return true;
+}
+
 std::string DatabasePgSQL::escapeString(const std::string& s)
 {
 	// remember to quote even empty string!
@@ -145,10 +219,11 @@ uint64_t DatabasePgSQL::getLastInsertId()
 	return id;
 }
 
-std::string DatabasePgSQL::_parse(const std::string& s)
+std::string DatabasePgSQL::_parse(const std::string& s, bool placeholders/* = false*/)
 {
 	std::string query = "";
 	bool inString = false;
+	uint32_t param = 0;
 	for(uint32_t a = 0; a < s.length(); a++)
 	{
 		uint8_t ch = s[a];
@@ -162,6 +237,15 @@ std::string DatabasePgSQL::_parse(const std::string& s)
 
 		if(ch == '`' && !inString)
 			ch = '"';
+		else if(ch == '?' && placeholders && !inString)
+		{
+			// PostgreSQL numbers its placeholders
+			std::stringstream ss;
+			ss << "$" << ++param;
+
+			query += ss.str();
+			continue;
+		}
 
 		query += ch;
 	}
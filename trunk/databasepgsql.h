@@ -37,6 +37,7 @@ class DatabasePgSQL : public _Database
 
 		DATABASE_VIRTUAL bool query(const std::string& query);
 		DATABASE_VIRTUAL DBResult* storeQuery(const std::string& query);
+		DATABASE_VIRTUAL bool executeStatement(const std::string& query, const DBParams& params);
 
 		DATABASE_VIRTUAL std::string escapeString(const std::string& s);
 		DATABASE_VIRTUAL std::string escapeBlob(const char *s, uint32_t length);
@@ -45,8 +46,11 @@ class DatabasePgSQL : public _Database
 		DATABASE_VIRTUAL DatabaseEngine_t getDatabaseEngine() {return DATABASE_ENGINE_POSTGRESQL;}
 
 	protected:
-		std::string _parse(const std::string& s);
+		std::string _parse(const std::string& s, bool placeholders = false);
 		PGconn* m_handle;
+
+		typedef std::map<std::string, std::string> StatementMap;
+		StatementMap m_statements;
 };
 
 class PgSQLResult : public _DBResult
@@ -51,6 +51,15 @@ DatabaseSQLite::DatabaseSQLite()
 	m_connected = true;
 }
 
+DatabaseSQLite::~DatabaseSQLite()
+{
+	for(StatementMap::iterator it = m_statements.begin(); it != m_statements.end(); ++it)
+		sqlite3_finalize(it->second);
+
+	m_statements.clear();
+	sqlite3_close(m_handle);
+}
+
 bool DatabaseSQLite::getParam(DBParam_t param)
 {
 	switch(param)
@@ -91,6 +100,10 @@ std::string DatabaseSQLite::_parse(const std::string& s)
 
 bool DatabaseSQLite::query(const std::string& query)
 {
+	if(recordQuery(query))
+		return true;
+
+	DBTimer timer(DBLATENCY_QUERY);
 	boost::recursive_mutex::scoped_lock lockClass(sqliteLock);
 	if(!m_connected)
 		return false;
@@ -125,6 +138,7 @@ bool DatabaseSQLite::query(const std::string& query)
 
 DBResult* DatabaseSQLite::storeQuery(const std::string& query)
 {
+	DBTimer timer(DBLATENCY_STORE);
 	boost::recursive_mutex::scoped_lock lockClass(sqliteLock);
 	if(!m_connected)
 		return NULL;
@@ -146,6 +160,64 @@ DBResult* DatabaseSQLite::storeQuery(const std::string& query)
 	return verifyResult(result);
 }
 
+bool DatabaseSQLite::executeStatement(const std::string& query, const DBParams& params)
+{
+	if(getRecorder())
+		return recordQuery(params.render(this, query));
+
+	DBTimer timer(DBLATENCY_STATEMENT);
+	boost::recursive_mutex::scoped_lock lockClass(sqliteLock);
+	if(!m_connected)
+		return false;
+
+	sqlite3_stmt* stmt = NULL;
+	StatementMap::iterator it = m_statements.find(query);
+	if(it == m_statements.end())
+	{
+		std::string buf = _parse(query);
+#ifdef __SQL_QUERY_DEBUG__
+		std::clog << "SQLLITE DEBUG, prepare: " << buf << std::endl;
+#endif
+		if(OTSYS_SQLITE3_PREPARE(m_handle, buf.c_str(), buf.length(), &stmt, NULL) != SQLITE_OK)
+		{
+			sqlite3_finalize(stmt);
+			std::clog << "OTSYS_SQLITE3_PREPARE(): SQLITE ERROR: " << sqlite3_errmsg(m_handle)  << " (" << buf << ")" << std::endl;
+			return false;
+		}
+
+		m_statements[query] = stmt;
+	}
+	else
+		stmt = it->second;
+
+	for(size_t i = 0; i < params.size(); ++i)
+	{
+		const DBParams::Param& param = params[i];
+		switch(param.type)
+		{
+			case DBParams::TYPE_INT:
+				sqlite3_bind_int64(stmt, i + 1, param.number);
+				break;
+			case DBParams::TYPE_STRING:
+				sqlite3_bind_text(stmt, i + 1, param.data.data(), param.data.size(), SQLITE_STATIC);
+				break;
+			case DBParams::TYPE_BLOB:
+				sqlite3_bind_blob(stmt, i + 1, param.data.data(), param.data.size(), SQLITE_STATIC);
+				break;
+		}
+	}
+
+	// executes it, the statement stays prepared for the next call
+	int32_t ret = sqlite3_step(stmt);
+	bool success = ret == SQLITE_OK || ret == SQLITE_DONE || ret == SQLITE_ROW;
+	if(!success)
+		std::clog << "sqlite3_step(): SQLITE ERROR: " << sqlite3_errmsg(m_handle) << std::endl;
+
+	sqlite3_reset(stmt);
+	sqlite3_clear_bindings(stmt);
+	return success;
+}
+
 std::string DatabaseSQLite::escapeString(const std::string& s)
 {
 	// remember about quoiting even an empty string!
@@ -155,7 +227,7 @@ std::string DatabaseSQLite::escapeString(const std::string& s)
 	// the worst case is 2n + 3
 	char* output = new char[s.length() * 2 + 3];
 	// quotes escaped string and frees temporary buffer
-	sqlite3_snprintf(s.length() * 2 + 1, output, "%Q", s.c_str());
+	sqlite3_snprintf(s.length() * 2 + 3, output, "%Q", s.c_str());
 
 	std::string r(output);
 	delete[] output;
@@ -30,7 +30,7 @@ class DatabaseSQLite : public _Database
 {
 	public:
 		DatabaseSQLite();
-		DATABASE_VIRTUAL ~DatabaseSQLite() {sqlite3_close(m_handle);}
+		DATABASE_VIRTUAL ~DatabaseSQLite();
 
 		DATABASE_VIRTUAL bool getParam(DBParam_t param);
 
@@ -40,6 +40,7 @@ class DatabaseSQLite : public _Database
 
 		DATABASE_VIRTUAL bool query(const std::string& query);
 		DATABASE_VIRTUAL DBResult* storeQuery(const std::string& query);
+		DATABASE_VIRTUAL bool executeStatement(const std::string& query, const DBParams& params);
 
 		DATABASE_VIRTUAL std::string escapeString(const std::string& s);
 		DATABASE_VIRTUAL std::string escapeBlob(const char* s, uint32_t length);
@@ -55,6 +56,9 @@ class DatabaseSQLite : public _Database
 
 		boost::recursive_mutex sqliteLock;
 		sqlite3* m_handle;
+
+		typedef std::map<std::string, sqlite3_stmt*> StatementMap;
+		StatementMap m_statements;
 };
 
 class SQLiteResult : public _DBResult
@@ -31,7 +31,7 @@
 #define VERSION_PATCH 0
 #define VERSION_TIMESTAMP 1299857798
 #define VERSION_BUILD 0
-#define VERSION_DATABASE 30
+#define VERSION_DATABASE 32
 
 #undef MULTI_SQL_DRIVERS
 #define SQL_DRIVERS __USE_SQLITE__+__USE_MYSQL__+__USE_PGSQL__
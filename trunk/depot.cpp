@@ -23,6 +23,7 @@ Depot::Depot(uint16_t type):
 {
 	maxSize = 30;
 	depotLimit = 1000;
+	changed = false;
 }
 
 Attr_ReadValue Depot::readAttr(AttrTypes_t attr, PropStream& propStream)
@@ -75,6 +76,7 @@ ReturnValue Depot::__queryMaxCount(int32_t index, const Thing* thing, uint32_t c
 void Depot::postAddNotification(Creature* actor, Thing* thing, const Cylinder* oldParent,
 	int32_t index, cylinderlink_t /*link = LINK_OWNER*/)
 {
+	changed = true;
 	if(getParent())
 		getParent()->postAddNotification(actor, thing, oldParent, index, LINK_PARENT);
 }
@@ -82,6 +84,7 @@ void Depot::postAddNotification(Creature* actor, Thing* thing, const Cylinder* o
 void Depot::postRemoveNotification(Creature* actor, Thing* thing, const Cylinder* newParent,
 	int32_t index, bool isCompleteRemoval, cylinderlink_t /*link = LINK_OWNER*/)
 {
+	changed = true;
 	if(getParent())
 		getParent()->postRemoveNotification(actor, thing, newParent,
 			index, isCompleteRemoval, LINK_PARENT);
@@ -35,6 +35,10 @@ class Depot : public Container
 
 		void setMaxDepotLimit(uint32_t count) {depotLimit = count;}
 
+		//anything added, removed or transformed below the depot, only changed depots are saved
+		void setChanged(bool value) {changed = value;}
+		bool isChanged() const {return changed;}
+
 		//cylinder implementations
 		virtual Cylinder* getParent() {return Item::getParent();}
 		virtual const Cylinder* getParent() const {return Item::getParent();}
@@ -63,6 +67,7 @@ class Depot : public Container
 
 	private:
 		uint32_t depotLimit;
+		bool changed;
 };
 
 inline uint32_t Depot::getDepotId() const
@@ -140,3 +140,118 @@ void Dispatcher::shutdown()
 	flush();
 	m_taskLock.unlock();
 }
+
+void TaskPool::start(uint32_t threads, const boost::function<void (void)>& init/* = boost::function<void (void)>()*/)
+{
+	if(!threads)
+		threads = std::max((uint32_t)1, (uint32_t)boost::thread::hardware_concurrency());
+
+	boost::mutex::scoped_lock lockClass(m_taskLock);
+	if(m_threadState == STATE_RUNNING)
+		return;
+
+	m_init = init;
+	m_threadState = STATE_RUNNING;
+	for(m_threads = 0; m_threads < threads; ++m_threads)
+		boost::thread(boost::bind(&TaskPool::poolThread, (void*)this));
+}
+
+void TaskPool::stop()
+{
+	m_taskLock.lock();
+	m_threadState = STATE_TERMINATED;
+	for(std::list<Task*>::iterator it = m_taskList.begin(); it != m_taskList.end(); ++it)
+		delete (*it);
+
+	m_taskList.clear();
+	m_taskLock.unlock();
+	m_taskSignal.notify_all();
+}
+
+void TaskPool::poolThread(void* p)
+{
+	TaskPool* pool = (TaskPool*)p;
+	#if defined __EXCEPTION_TRACER__
+	ExceptionHandler poolExceptionHandler;
+	poolExceptionHandler.InstallHandler();
+	#endif
+
+	if(!pool->m_init.empty())
+		pool->m_init();
+
+	boost::unique_lock<boost::mutex> taskLockUnique(pool->m_taskLock, boost::defer_lock);
+	while(true)
+	{
+		taskLockUnique.lock();
+		while(pool->m_taskList.empty() && pool->m_threadState == STATE_RUNNING)
+			pool->m_taskSignal.wait(taskLockUnique);
+
+		if(pool->m_threadState != STATE_RUNNING)
+		{
+			taskLockUnique.unlock();
+			break;
+		}
+
+		Task* task = pool->m_taskList.front();
+		pool->m_taskList.pop_front();
+		taskLockUnique.unlock();
+
+		if(!task->hasExpired())
+			(*task)();
+
+		delete task;
+	}
+
+	#if defined __EXCEPTION_TRACER__
+	poolExceptionHandler.RemoveHandler();
+	#endif
+}
+
+void TaskPool::addTask(Task* task)
+{
+	m_taskLock.lock();
+	if(m_threadState != STATE_RUNNING)
+	{
+		m_taskLock.unlock();
+		// not started (or gone already), do the job on the calling thread
+		(*task)();
+		delete task;
+		return;
+	}
+
+	m_taskList.push_back(task);
+	m_taskLock.unlock();
+	m_taskSignal.notify_one();
+}
+
+void LatencyHistogram::add(uint64_t micro)
+{
+	uint32_t bucket = 0;
+	for(uint64_t tmp = micro; tmp && bucket < LATENCY_BUCKETS - 1; tmp >>= 1)
+		++bucket;
+
+	boost::mutex::scoped_lock lockClass(m_lock);
+	m_buckets[bucket]++;
+	m_count++;
+
+	m_total += micro;
+	if(micro > m_max)
+		m_max = micro;
+}
+
+uint64_t LatencyHistogram::getPercentile(uint32_t percent)
+{
+	boost::mutex::scoped_lock lockClass(m_lock);
+	if(!m_count)
+		return 0;
+
+	uint64_t target = std::max((uint64_t)1, (m_count * percent + 99) / 100), seen = 0;
+	for(uint32_t i = 0; i < LATENCY_BUCKETS; ++i)
+	{
+		seen += m_buckets[i];
+		if(seen >= target) //upper bound of the bucket
+			return std::min(m_max, ((uint64_t)1 << i) - 1);
+	}
+
+	return m_max;
+}
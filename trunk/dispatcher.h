@@ -90,4 +90,73 @@ class Dispatcher
 		std::list<Task*> m_taskList;
 		static DispatcherState m_threadState;
 };
+
+enum TaskPool_t
+{
+	TASKPOOL_CPU = 0,
+	TASKPOOL_DATABASE,
+	TASKPOOL_LAST = TASKPOOL_DATABASE
+};
+
+// workers for jobs that would otherwise block the network or dispatcher
+// threads, anything touching game state must be handed back to the dispatcher
+class TaskPool
+{
+	public:
+		virtual ~TaskPool() {}
+		static TaskPool& getInstance(TaskPool_t type)
+		{
+			static TaskPool pools[TASKPOOL_LAST + 1];
+			return pools[type];
+		}
+
+		// init runs once on every worker before it takes any task
+		void start(uint32_t threads, const boost::function<void (void)>& init = boost::function<void (void)>());
+		void stop();
+
+		void addTask(Task* task);
+		uint32_t getThreadCount() const {return m_threads;}
+		size_t getPendingCount() const {return m_taskList.size();}
+
+		static void poolThread(void* p);
+
+	protected:
+		TaskPool(): m_threads(0), m_threadState(STATE_TERMINATED) {}
+		enum PoolState
+		{
+			STATE_RUNNING,
+			STATE_TERMINATED
+		};
+
+		boost::mutex m_taskLock;
+		boost::condition_variable m_taskSignal;
+
+		std::list<Task*> m_taskList;
+		boost::function<void (void)> m_init;
+
+		uint32_t m_threads;
+		PoolState m_threadState;
+};
+
+#define LATENCY_BUCKETS 25
+class LatencyHistogram
+{
+	public:
+		LatencyHistogram(): m_count(0), m_total(0), m_max(0)
+		{
+			memset(m_buckets, 0, sizeof(m_buckets));
+		}
+		virtual ~LatencyHistogram() {}
+
+		void add(uint64_t micro);
+		uint64_t getPercentile(uint32_t percent);
+
+		uint64_t getCount() const {return m_count;}
+		uint64_t getAverage() const {return m_count ? m_total / m_count : 0;}
+		uint64_t getMax() const {return m_max;}
+
+	protected:
+		boost::mutex m_lock;
+		uint64_t m_buckets[LATENCY_BUCKETS], m_count, m_total, m_max;
+};
 #endif
@@ -17,19 +17,37 @@
 #include "otpch.h"
 #include "fileloader.h"
 
+#ifndef WINDOWS
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#endif
+
 FileLoader::FileLoader()
 {
 	m_file = NULL;
-	m_root = NULL;
+	m_data = m_end = NULL;
+	m_mapped = m_shared = false;
+
+	m_root = NO_NODE;
 	m_buffer = new uint8_t[1024];
 	m_buffer_size = 1024;
 	m_lastError = ERROR_NONE;
+}
+
+FileLoader::FileLoader(const FileLoader& source)
+{
+	m_file = NULL;
+	m_data = source.m_data;
+	m_end = source.m_end;
+
+	m_mapped = false;
+	m_shared = true;
 
-	//cache
-	m_use_cache = false;
-	m_cache_size = 0;
-	m_cache_index = m_cache_offset = NO_VALID_CACHE;
-	memset(m_cached_data, 0, sizeof(m_cached_data));
+	m_root = source.m_root;
+	m_buffer = new uint8_t[1024];
+	m_buffer_size = 1024;
+	m_lastError = ERROR_NONE;
 }
 
 FileLoader::~FileLoader()
@@ -44,16 +62,11 @@ FileLoader::~FileLoader()
 		m_file = NULL;
 	}
 
-	NodeStruct::clearNet(m_root);
+	closeData();
 	delete[] m_buffer;
-	for(int32_t i = 0; i < CACHE_BLOCKS; i++)
-	{
-		if(m_cached_data[i].data)
-			delete[] m_cached_data[i].data;
-	}
 }
 
-bool FileLoader::openFile(std::string name, bool write, bool caching/* = false*/)
+bool FileLoader::openFile(std::string name, bool write)
 {
 	uint32_t version = 0;
 	if(write)
@@ -83,177 +96,192 @@ bool FileLoader::openFile(std::string name, bool write, bool caching/* = false*/
 		}
 	}
 
-#ifdef __USE_ZLIB__
-	m_file = gzopen(name.c_str(), "rb");
+	//compressed files can't be mapped, they are inflated into memory instead
+	if(!mapFile(name) && !readFile(name) && !readFile(name + ".gz"))
+	{
+		m_lastError = ERROR_CAN_NOT_OPEN;
+		return false;
+	}
+
+	if(m_end - m_data < (int32_t)sizeof(version) + 2)
+	{
+		m_lastError = ERROR_EOF;
+		return false;
+	}
+
+	memcpy(&version, m_data, sizeof(version));
+	if(version > 0)
+	{
+		m_lastError = ERROR_INVALID_FILE_VERSION;
+		return false;
+	}
+
+	if(m_data[sizeof(version)] != NODE_START)
+	{
+		m_lastError = ERROR_INVALID_FORMAT;
+		return false;
+	}
+
+	m_root = m_data + sizeof(version);
+	return true;
+}
+
+bool FileLoader::mapFile(const std::string& name)
+{
+#ifdef WINDOWS
+	HANDLE file = CreateFileA(name.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+		FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if(file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if(!GetFileSizeEx(file, &size) || !size.QuadPart)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if(!mapping)
+		return false;
+
+	//the view keeps the mapping alive on its own
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if(!view)
+		return false;
+
+	m_data = (const uint8_t*)view;
+	m_end = m_data + size.QuadPart;
 #else
-	m_file = fopen(name.c_str(), "rb");
+	int32_t file = open(name.c_str(), O_RDONLY);
+	if(file < 0)
+		return false;
+
+	struct stat st;
+	if(fstat(file, &st) || !st.st_size)
+	{
+		close(file);
+		return false;
+	}
+
+	void* view = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if(view == MAP_FAILED)
+		return false;
+
+	madvise(view, st.st_size, MADV_SEQUENTIAL);
+	m_data = (const uint8_t*)view;
+	m_end = m_data + st.st_size;
 #endif
-	if(!m_file)
-		name += ".gz";
 
+	m_mapped = true;
+	if(m_end - m_data < 2 || m_data[0] != 0x1F || m_data[1] != 0x8B)
+		return true;
+
+	//gzip header
+	closeData();
+	return false;
+}
+
+bool FileLoader::readFile(const std::string& name)
+{
 #ifdef __USE_ZLIB__
-        m_file = gzopen(name.c_str(), "rb");
+	gzFile file = gzopen(name.c_str(), "rb");
 #else
-        m_file = fopen(name.c_str(), "rb");
+	FILE* file = fopen(name.c_str(), "rb");
 #endif
-	if(m_file)
+	if(!file)
+		return false;
+
+	std::vector<uint8_t> data;
+	uint8_t chunk[65536];
+	while(true)
 	{
 #ifdef __USE_ZLIB__
-		if(gzread(m_file, &version, sizeof(version)))
+		int32_t size = gzread(file, chunk, sizeof(chunk));
 #else
-		if(fread(&version, sizeof(version), 1, m_file))
+		int32_t size = fread(chunk, 1, sizeof(chunk), file);
 #endif
-		{
-			if(version > 0)
-			{
+		if(size <= 0)
+			break;
+
+		data.insert(data.end(), chunk, chunk + size);
+	}
+
 #ifdef __USE_ZLIB__
-				gzclose(m_file);
+	gzclose(file);
 #else
-				fclose(m_file);
+	fclose(file);
 #endif
-				m_file = NULL;
-				m_lastError = ERROR_INVALID_FILE_VERSION;
-				return false;
-			}
-
-			if(caching)
-			{
-				m_use_cache = true;
-#ifdef __USE_ZLIB__
-				gzseek(m_file, 0, SEEK_END);
-				int32_t fileSize = gztell(m_file);
+	if(data.empty())
+		return false;
+
+	uint8_t* buffer = new uint8_t[data.size()];
+	memcpy(buffer, &data[0], data.size());
+
+	m_data = buffer;
+	m_end = buffer + data.size();
+	m_mapped = false;
+	return true;
+}
+
+void FileLoader::closeData()
+{
+	if(!m_data)
+		return;
+
+	if(m_shared)
+		m_shared = false;
+	else if(m_mapped)
+	{
+#ifdef WINDOWS
+		UnmapViewOfFile((void*)m_data);
 #else
-				fseek(m_file, 0, SEEK_END);
-				int32_t fileSize = ftell(m_file);
+		munmap((void*)m_data, m_end - m_data);
 #endif
-				m_use_cache = true;
-				m_cache_size = std::min(32768, std::max(fileSize / 20, 8192)) & ~0x1FFF;
-			}
-
-			if(safeSeek(4))
-			{
-				delete m_root;
-				m_root = new NodeStruct();
-				m_root->start = 4;
-
-				int32_t byte;
-				if(safeSeek(4) && readByte(byte) && byte == NODE_START)
-					return parseNode(m_root);
-			}
-			else
-				m_lastError = ERROR_INVALID_FORMAT;
-		}
-		else
-			m_lastError = ERROR_EOF;
 	}
 	else
-		m_lastError = ERROR_CAN_NOT_OPEN;
+		delete[] m_data;
 
-	return false;
+	m_data = m_end = NULL;
+	m_root = NO_NODE;
+	m_mapped = false;
 }
 
-bool FileLoader::parseNode(NODE node)
+const uint8_t* FileLoader::skipProps(const uint8_t* pos) const
 {
-	int32_t byte, pos;
-	NODE currentNode = node;
-	while(true)
+	for(; pos < m_end; ++pos)
 	{
-		//read node type
-		if(!readByte(byte))
-			return false;
+		if(*pos == ESCAPE_CHAR)
+			++pos;
+		else if(*pos == NODE_START || *pos == NODE_END)
+			return pos;
+	}
+
+	m_lastError = ERROR_INVALID_FORMAT;
+	return NULL;
+}
 
-		currentNode->type = byte;
-		bool setPropsSize = false;
-		while(true)
+const uint8_t* FileLoader::skipNode(NODE node) const
+{
+	uint32_t depth = 0;
+	for(const uint8_t* pos = node + 2; (pos = skipProps(pos)); )
+	{
+		if(*pos == NODE_START)
 		{
-			if(!readByte(byte))
-				return false;
-
-			bool skipNode = false;
-			switch(byte)
-			{
-				case NODE_START:
-				{
-					//child node start
-					if(!safeTell(pos))
-						return false;
-
-					if(NODE childNode = new NodeStruct())
-					{
-						childNode->start = pos;
-						currentNode->propsSize = pos - currentNode->start - 2;
-						currentNode->child = childNode;
-
-						setPropsSize = true;
-						if(!parseNode(childNode))
-							return false;
-					}
-
-					break;
-				}
-
-				case NODE_END:
-				{
-					//current node end
-					if(!setPropsSize)
-					{
-						if(!safeTell(pos))
-							return false;
-
-						currentNode->propsSize = pos - currentNode->start - 2;
-					}
-
-					if(!readByte(byte))
-						return true;
-
-					switch(byte)
-					{
-						case NODE_START:
-						{
-							//starts next node
-							if(!safeTell(pos))
-								return false;
-
-							skipNode = true;
-							if(NODE nextNode = new NodeStruct())
-							{
-								nextNode->start = pos;
-								currentNode->next = nextNode;
-								currentNode = nextNode;
-							}
-
-							break;
-						}
-
-						case NODE_END:
-							return safeTell(pos) && safeSeek(pos);
-
-						default:
-							m_lastError = ERROR_INVALID_FORMAT;
-							return false;
-					}
-
-					break;
-				}
-
-				case ESCAPE_CHAR:
-				{
-					if(!readByte(byte))
-						return false;
-
-					break;
-				}
-
-				default:
-					break;
-			}
-
-			if(skipNode)
-				break;
+			//skip the child type as well
+			++depth;
+			pos += 2;
 		}
+		else if(!depth--)
+			return pos + 1;
+		else
+			++pos;
 	}
 
-	return false;
+	return NULL;
 }
 
 const uint8_t* FileLoader::getProps(const NODE node, uint32_t &size)
@@ -261,32 +289,50 @@ const uint8_t* FileLoader::getProps(const NODE node, uint32_t &size)
 	if(!node)
 		return NULL;
 
-	if(node->propsSize >= m_buffer_size)
+	const uint8_t* begin = node + 2;
+	const uint8_t* escape = NULL;
+
+	const uint8_t* pos = begin;
+	for(; pos < m_end && *pos != NODE_START && *pos != NODE_END; ++pos)
 	{
-		delete[] m_buffer;
-		m_buffer = new uint8_t[m_buffer_size + 1024];
-		m_buffer_size = m_buffer_size + 1024;
+		if(*pos != ESCAPE_CHAR)
+			continue;
+
+		if(!escape)
+			escape = pos;
+
+		++pos;
 	}
 
-	//get buffer
-	if(!readBytes(m_buffer, node->propsSize, node->start + 2))
+	if(pos >= m_end)
+	{
+		m_lastError = ERROR_INVALID_FORMAT;
 		return NULL;
+	}
 
-	//unscape buffer
-	uint32_t j = 0;
-	bool escaped = false;
-	for(uint32_t i = 0; i < node->propsSize; ++i, ++j)
+	if(!escape)
 	{
-		if(m_buffer[i] == ESCAPE_CHAR)
-		{
-			//escape char found, skip it and write next
-			++i;
-			m_buffer[j] = m_buffer[i];
-			//is neede a displacement for next bytes
-			escaped = true;
-		}
-		else if(escaped) //perform that displacement
-			m_buffer[j] = m_buffer[i];
+		//nothing to unescape, hand out the file data itself
+		size = pos - begin;
+		return begin;
+	}
+
+	uint32_t length = pos - begin;
+	if(length > m_buffer_size)
+	{
+		delete[] m_buffer;
+		m_buffer_size = (length + 1023) & ~1023;
+		m_buffer = new uint8_t[m_buffer_size];
+	}
+
+	uint32_t j = escape - begin;
+	memcpy(m_buffer, begin, j);
+	for(const uint8_t* it = escape; it < pos; ++it, ++j)
+	{
+		if(*it == ESCAPE_CHAR)
+			++it;
+
+		m_buffer[j] = *it;
 	}
 
 	size = j;
@@ -332,14 +378,17 @@ NODE FileLoader::getChildNode(const NODE& parent, uint32_t &type) const
 {
 	if(!parent)
 	{
-		type = m_root->type;
+		if(m_root)
+			type = m_root[1];
+
 		return m_root;
 	}
 
-	NODE child = parent->child;
-	if(child)
-		type = child->type;
+	const uint8_t* child = skipProps(parent + 2);
+	if(!child || *child != NODE_START || child + 1 >= m_end)
+		return NO_NODE;
 
+	type = child[1];
 	return child;
 }
 
@@ -348,247 +397,10 @@ NODE FileLoader::getNextNode(const NODE& prev, uint32_t &type) const
 	if(!prev)
 		return NO_NODE;
 
-	NODE next = prev->next;
-	if(next)
-		type = next->type;
+	const uint8_t* next = skipNode(prev);
+	if(!next || next + 1 >= m_end || *next != NODE_START)
+		return NO_NODE;
 
+	type = next[1];
 	return next;
 }
-
-inline bool FileLoader::readByte(int32_t &value)
-{
-	if(m_use_cache)
-	{
-		if(m_cache_index == NO_VALID_CACHE)
-		{
-			m_lastError = ERROR_CACHE_ERROR;
-			return false;
-		}
-
-		if(m_cache_offset >= m_cached_data[m_cache_index].size)
-		{
-			int32_t pos = m_cache_offset + m_cached_data[m_cache_index].base, tmp = getCacheBlock(pos);
-			if(tmp < 0)
-				return false;
-
-			m_cache_index = tmp;
-			m_cache_offset = pos - m_cached_data[m_cache_index].base;
-			if(m_cache_offset >= m_cached_data[m_cache_index].size)
-				return false;
-		}
-
-		value = m_cached_data[m_cache_index].data[m_cache_offset];
-		m_cache_offset++;
-		return true;
-	}
-
-#ifdef __USE_ZLIB__
-	value = gzgetc(m_file);
-#else
-	value = fgetc(m_file);
-#endif
-	if(value != EOF)
-		return true;
-
-	m_lastError = ERROR_EOF;
-	return false;
-}
-
-inline bool FileLoader::readBytes(uint8_t* buffer, int32_t size, int32_t pos)
-{
-	if(m_use_cache)
-	{
-		//seek at pos
-		uint32_t reading, remain = size, bufferPos = 0;
-		do
-		{
-			//prepare cache
-			uint32_t i = getCacheBlock(pos);
-			if(i == NO_VALID_CACHE)
-				return false;
-
-			m_cache_index = i;
-			m_cache_offset = pos - m_cached_data[i].base;
-
-			//get maximum read block size and calculate remaining bytes
-			reading = std::min(remain, (uint32_t)m_cached_data[i].size - m_cache_offset);
-			remain = remain - reading;
-
-			//read it
-			memcpy(buffer + bufferPos, m_cached_data[m_cache_index].data + m_cache_offset, reading);
-
-			//update variables
-			m_cache_offset = m_cache_offset + reading;
-			bufferPos = bufferPos + reading;
-			pos = pos + reading;
-		}
-		while(remain > 0);
-		return true;
-	}
-
-#ifdef __USE_ZLIB__
-	if(gzseek(m_file, pos, SEEK_SET) < 0)
-#else
-	if(fseek(m_file, pos, SEEK_SET))
-#endif
-	{
-		m_lastError = ERROR_SEEK_ERROR;
-		return false;
-	}
-
-#ifdef __USE_ZLIB__
-	if(gzread(m_file, buffer, size) == size)
-#else
-	if(fread(buffer, 1, size, m_file) == (uint32_t)size)
-#endif
-		return true;
-
-	m_lastError = ERROR_EOF;
-	return false;
-}
-
-inline bool FileLoader::checks(const NODE& node)
-{
-	if(!m_file)
-	{
-		m_lastError = ERROR_NOT_OPEN;
-		return false;
-	}
-
-	if(!node)
-	{
-		m_lastError = ERROR_INVALID_NODE;
-		return false;
-	}
-
-	return true;
-}
-
-inline bool FileLoader::safeSeek(uint32_t pos)
-{
-	if(m_use_cache)
-	{
-		uint32_t i = getCacheBlock(pos);
-		if(i == NO_VALID_CACHE)
-			return false;
-
-		m_cache_index = i;
-		m_cache_offset = pos - m_cached_data[i].base;
-	}
-#ifdef __USE_ZLIB__
-	else if(gzseek(m_file, pos, SEEK_SET) < 0)
-#else
-	else if(fseek(m_file, pos, SEEK_SET))
-#endif
-	{
-		m_lastError = ERROR_SEEK_ERROR;
-		return false;
-	}
-
-	return true;
-}
-
-inline bool FileLoader::safeTell(int32_t &pos)
-{
-	if(m_use_cache)
-	{
-		if(m_cache_index == NO_VALID_CACHE)
-		{
-			m_lastError = ERROR_CACHE_ERROR;
-			return false;
-		}
-
-		pos = m_cached_data[m_cache_index].base + m_cache_offset - 1;
-		return true;
-	}
-
-#ifdef __USE_ZLIB__
-	pos = gztell(m_file);
-#else
-	pos = ftell(m_file);
-#endif
-	if(pos == -1)
-	{
-		m_lastError = ERROR_TELL_ERROR;
-		return false;
-	}
-
-	pos = pos - 1;
-	return true;
-}
-
-inline uint32_t FileLoader::getCacheBlock(uint32_t pos)
-{
-	bool found = false;
-	uint32_t i, base_pos = pos & ~(m_cache_size - 1);
-	for(i = 0; i < CACHE_BLOCKS; i++)
-	{
-		if(!m_cached_data[i].loaded || m_cached_data[i].base != base_pos)
-			continue;
-
-		found = true;
-		break;
-	}
-
-	if(!found)
-		i = loadCacheBlock(pos);
-
-	return i;
-}
-
-int32_t FileLoader::loadCacheBlock(uint32_t pos)
-{
-	int32_t i, loading_cache = -1, base_pos = pos & ~(m_cache_size - 1);
-	for(i = 0; i < CACHE_BLOCKS; i++)
-	{
-		if(m_cached_data[i].loaded)
-			continue;
-
-		loading_cache = i;
-		break;
-	}
-
-	if(loading_cache == -1)
-	{
-		for(i = 0; i < CACHE_BLOCKS; i++)
-		{
-			if((long)(std::abs((long)m_cached_data[i].base - base_pos)) <= (long)(2 * m_cache_size))
-				continue;
-
-			loading_cache = i;
-			break;
-		}
-
-		if(loading_cache == -1)
-			loading_cache = 0;
-	}
-
-	if(m_cached_data[loading_cache].data == NULL)
-		m_cached_data[loading_cache].data = new uint8_t[m_cache_size];
-
-	m_cached_data[loading_cache].base = base_pos;
-#ifdef __USE_ZLIB__
-	if(gzseek(m_file, m_cached_data[loading_cache].base, SEEK_SET) < 0)
-#else
-	if(fseek(m_file, m_cached_data[loading_cache].base, SEEK_SET))
-#endif
-	{
-		m_lastError = ERROR_SEEK_ERROR;
-		return -1;
-	}
-
-#ifdef __USE_ZLIB__
-	uint32_t size = gzread(m_file, m_cached_data[loading_cache].data, m_cache_size);
-#else
-	uint32_t size = fread(m_cached_data[loading_cache].data, 1, m_cache_size, m_file);
-#endif
-	m_cached_data[loading_cache].size = size;
-	if(size < (pos - m_cached_data[loading_cache].base))
-	{
-		m_lastError = ERROR_SEEK_ERROR;
-		return -1;
-	}
-
-	m_cached_data[loading_cache].loaded = 1;
-	return loading_cache;
-}
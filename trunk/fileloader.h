@@ -23,50 +23,9 @@
 #include <zlib.h>
 #endif
 
-struct NodeStruct;
-typedef NodeStruct* NODE;
-
-struct NodeStruct
-{
-	NodeStruct()
-	{
-		start = propsSize = type = 0;
-		next = child = 0;
-	}
-	virtual ~NodeStruct() {}
-
-	uint32_t start, propsSize, type;
-	NodeStruct* next;
-	NodeStruct* child;
-
-	static void clearNet(NodeStruct* root) {if(root) clearChild(root); }
-	private:
-		static void clearNext(NodeStruct* node)
-		{
-			NodeStruct* deleteNode = node;
-			NodeStruct* nextNode;
-			while(deleteNode)
-			{
-				if(deleteNode->child)
-					clearChild(deleteNode->child);
-
-				nextNode = deleteNode->next;
-				delete deleteNode;
-				deleteNode = nextNode;
-			}
-		}
-
-		static void clearChild(NodeStruct* node)
-		{
-			if(node->child)
-				clearChild(node->child);
-
-			if(node->next)
-				clearNext(node->next);
-
-			delete node;
-		}
-};
+// a node is the position of its NODE_START byte in the loaded file, children
+// and siblings are found by walking the data, no node tree is ever built
+typedef const uint8_t* NODE;
 
 #define NO_NODE 0
 enum FILELOADER_ERRORS
@@ -90,9 +49,12 @@ class FileLoader
 {
 	public:
 		FileLoader();
+		// reads the data of an open loader, which must outlive it; readers have
+		// their own buffer, so each thread can walk the same file with its own
+		explicit FileLoader(const FileLoader& source);
 		virtual ~FileLoader();
 
-		bool openFile(std::string name, bool write, bool caching = false);
+		bool openFile(std::string name, bool write);
 		const uint8_t* getProps(const NODE, uint32_t &size);
 		bool getProps(const NODE, PropStream& props);
 		NODE getChildNode(const NODE& parent, uint32_t &type) const;
@@ -112,13 +74,13 @@ class FileLoader
 			NODE_END = 0xFF,
 			ESCAPE_CHAR = 0xFD,
 		};
-		bool parseNode(NODE node);
 
-		inline bool readByte(int32_t &value);
-		inline bool readBytes(unsigned char* buffer, int32_t size, int32_t pos);
-		inline bool checks(const NODE& node);
-		inline bool safeSeek(uint32_t pos);
-		inline bool safeTell(int32_t &pos);
+		bool mapFile(const std::string& name);
+		bool readFile(const std::string& name);
+		void closeData();
+
+		const uint8_t* skipProps(const uint8_t* pos) const;
+		const uint8_t* skipNode(NODE node) const;
 
 	public:
 		inline bool writeData(const void* data, int32_t size, bool unescape)
@@ -157,34 +119,22 @@ class FileLoader
 		}
 
 	protected:
-		FILELOADER_ERRORS m_lastError;
+		mutable FILELOADER_ERRORS m_lastError;
 #ifdef __USE_ZLIB__
 		gzFile m_file;
 #else
 		FILE* m_file;
 #endif
 
+		// the whole file, either mapped straight from disk or, for compressed
+		// maps, inflated into memory
+		const uint8_t* m_data;
+		const uint8_t* m_end;
+		bool m_mapped, m_shared;
+
 		NODE m_root;
 		uint32_t m_buffer_size;
 		uint8_t* m_buffer;
-
-		bool m_use_cache;
-		struct _cache
-		{
-			uint32_t loaded, base;
-			uint8_t* data;
-			size_t size;
-		};
-
-		#define CACHE_BLOCKS 3
-		uint32_t m_cache_size;
-		_cache m_cached_data[CACHE_BLOCKS];
-
-		#define NO_VALID_CACHE 0xFFFFFFFF
-		uint32_t m_cache_index, m_cache_offset;
-
-		inline uint32_t getCacheBlock(uint32_t pos);
-		int32_t loadCacheBlock(uint32_t pos);
 };
 
 class PropStream
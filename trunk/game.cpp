@@ -22,6 +22,7 @@
 #include "gameservers.h"
 #endif
 #include "server.h"
+#include "status.h"
 #include "chat.h"
 
 #include "luascript.h"
@@ -59,6 +60,7 @@
 #include "exception.h"
 #endif
 
+extern Game g_game;
 extern ConfigManager g_config;
 extern Actions* g_actions;
 extern Monsters g_monsters;
@@ -76,6 +78,7 @@ Game::Game()
 	gameState = GAMESTATE_NORMAL;
 	worldType = WORLDTYPE_OPEN;
 	map = NULL;
+	saveSnapshot = NULL;
 	playersRecord = lastStageLevel = 0;
 
 	//(1440 minutes/day) * 10 seconds event interval / (3600 seconds/day)
@@ -221,6 +224,7 @@ void Game::setGameState(GameState_t newState)
 				Quests::getInstance()->loadFromXml();
 
 				loadStatuslist();
+				Status::getInstance()->startup();
 
 				loadGameState();
 				g_globalEvents->startup();
@@ -247,6 +251,8 @@ void Game::setGameState(GameState_t newState)
 
 				Houses::getInstance()->payHouses();
 				saveGameState(false);
+				waitSave();
+
 				Dispatcher::getInstance().addTask(createTask(boost::bind(&Game::shutdown, this)));
 
 				Scheduler::getInstance().stop();
@@ -282,6 +288,22 @@ void Game::setGameState(GameState_t newState)
 	}
 }
 
+static void markHousesUnsaved()
+{
+	for(HouseMap::iterator it = Houses::getInstance()->getHouseBegin(); it != Houses::getInstance()->getHouseEnd(); ++it)
+		it->second->setSyncFlag(House::HOUSE_SYNC_ITEMS);
+}
+
+static void markDepotsUnsaved(uint32_t guid)
+{
+	Player* player = g_game.getPlayerByGuid(guid);
+	if(!player)
+		return;
+
+	for(DepotMap::iterator it = player->depots.begin(); it != player->depots.end(); ++it)
+		it->second.first->setChanged(true);
+}
+
 void Game::saveGameState(bool shallow)
 {
 	std::clog << "> Saving server..." << std::endl;
@@ -289,21 +311,156 @@ void Game::saveGameState(bool shallow)
 	if(gameState == GAMESTATE_NORMAL)
 		setGameState(GAMESTATE_MAINTAIN);
 
+	//the previous snapshot has to be written before we take a new one
+	waitSave();
+
+	//everything is recorded into memory here, the database threads do the writing
+	SaveSnapshot* snapshot = new SaveSnapshot(start);
 	IOLoginData* io = IOLoginData::getInstance();
 	for(AutoList<Player>::iterator it = Player::autoList.begin(); it != Player::autoList.end(); ++it)
 	{
 		it->second->loginPosition = it->second->getPosition();
+		snapshot->units.push_back(SaveUnit(SAVEUNIT_PLAYER, it->second->getGUID()));
+
+		SaveUnit& unit = snapshot->units.back();
+		snapshot->players[unit.guid] = &unit;
+
+		Database::setRecorder(&unit.statements);
 		io->savePlayer(it->second, false, shallow);
+		Database::setRecorder(NULL);
 	}
 
-	map->saveMap();
+	snapshot->units.push_back(SaveUnit(SAVEUNIT_HOUSES));
+	Database::setRecorder(&snapshot->units.back().statements);
+	if(!map->saveMap())
+		markHousesUnsaved();
+
+	snapshot->units.push_back(SaveUnit(SAVEUNIT_GLOBAL));
+	Database::setRecorder(&snapshot->units.back().statements);
 	ScriptEnviroment::saveGameState();
+	Database::setRecorder(NULL);
+
+	snapshot->paused = OTSYS_TIME() - start;
+	std::clog << "> SAVE: Snapshot of " << snapshot->players.size() << " players taken in "
+		<< snapshot->paused << " ms." << std::endl;
+
+	{
+		boost::mutex::scoped_lock lockClass(saveLock);
+		saveSnapshot = snapshot;
+	}
+
 	if(gameState == GAMESTATE_MAINTAIN)
 		setGameState(GAMESTATE_NORMAL);
 
-	std::clog << "> SAVE: Complete in " << (OTSYS_TIME() - start) / (1000.) << " seconds using "
-		<< asLowerCaseString(g_config.getString(ConfigManager::HOUSE_STORAGE))
-		<< " house storage." << std::endl;
+	if(g_config.getBool(ConfigManager::BACKGROUND_SAVE))
+		TaskPool::getInstance(TASKPOOL_DATABASE).addTask(createTask(boost::bind(&Game::writeSnapshot, this, snapshot)));
+	else
+		writeSnapshot(snapshot);
+}
+
+void Game::writeSnapshot(SaveSnapshot* snapshot)
+{
+	Database* db = Database::getInstance();
+	uint32_t done = 0, skipped = 0, failed = 0, total = snapshot->units.size(), step = std::max((uint32_t)1, total / 10);
+	for(std::list<SaveUnit>::iterator it = snapshot->units.begin(); it != snapshot->units.end(); ++it)
+	{
+		{
+			//both held until the unit is written, so cancelSave() returns only once the older copy
+			//is in and the game thread's own write lands after it, whichever connection we are on
+			DBQuery query;
+			boost::mutex::scoped_lock lockClass(saveLock);
+
+			//each unit is a transaction of its own, a crash leaves whole players and houses behind
+			if(it->cancelled)
+				++skipped;
+			else if(Database::executeRecorded(db, it->statements))
+				it->written = true;
+			else
+			{
+				++failed;
+				if(it->type == SAVEUNIT_PLAYER)
+				{
+					std::clog << "[Error - Game::writeSnapshot] Could not write player " << it->guid << std::endl;
+					Dispatcher::getInstance().addTask(createTask(boost::bind(&markDepotsUnsaved, it->guid)));
+				}
+				else if(it->type == SAVEUNIT_HOUSES)
+				{
+					std::clog << "[Error - Game::writeSnapshot] Could not write houses" << std::endl;
+					Dispatcher::getInstance().addTask(createTask(boost::bind(&markHousesUnsaved)));
+				}
+				else
+					std::clog << "[Error - Game::writeSnapshot] Could not write global storage" << std::endl;
+			}
+		}
+
+		if(!(++done % step) && done < total)
+			std::clog << "> SAVE: " << (done * 100 / total) << "% (" << done << "/" << total << ")" << std::endl;
+	}
+
+	std::clog << "> SAVE: Complete in " << (OTSYS_TIME() - snapshot->start) / (1000.) << " seconds using "
+		<< asLowerCaseString(g_config.getString(ConfigManager::HOUSE_STORAGE)) << " house storage, game paused for "
+		<< snapshot->paused << " ms (" << skipped << " superseded, " << failed << " failed)." << std::endl;
+
+	boost::mutex::scoped_lock lockClass(saveLock);
+	saveSnapshot = NULL;
+	delete snapshot;
+	saveSignal.notify_all();
+}
+
+void Game::waitSave()
+{
+	boost::mutex::scoped_lock lockClass(saveLock);
+	while(saveSnapshot)
+		saveSignal.wait(lockClass);
+}
+
+bool Game::cancelSave(SaveUnit_t type, uint32_t guid/* = 0*/)
+{
+	//called before the game thread writes the same data itself, the snapshot copy would be older;
+	//returns whether the snapshot still held data of that kind that never reached the database
+	boost::mutex::scoped_lock lockClass(saveLock);
+	if(!saveSnapshot)
+		return false;
+
+	if(type == SAVEUNIT_PLAYER)
+	{
+		std::map<uint32_t, SaveUnit*>::iterator it = saveSnapshot->players.find(guid);
+		if(it == saveSnapshot->players.end() || it->second->cancelled)
+			return false; //an earlier save of ours already replaced it
+
+		it->second->cancelled = true;
+		return !it->second->written;
+	}
+
+	bool ret = false;
+	for(std::list<SaveUnit>::iterator it = saveSnapshot->units.begin(); it != saveSnapshot->units.end(); ++it)
+	{
+		if(it->type != type || it->cancelled)
+			continue;
+
+		it->cancelled = true;
+		if(it->written)
+			continue;
+
+		ret = true;
+		if(type == SAVEUNIT_HOUSES)
+			markHousesUnsaved();
+	}
+
+	return ret;
+}
+
+void Game::markItemChanged(Item* item)
+{
+	//for changes that don't go through cylinder notifications, like text or script attributes
+	if(Tile* tile = item->getTile())
+	{
+		if(HouseTile* houseTile = tile->getHouseTile())
+			houseTile->getHouse()->setSyncFlag(House::HOUSE_SYNC_ITEMS);
+	}
+
+	if(Depot* depot = dynamic_cast<Depot*>(item->getTopParent()))
+		depot->setChanged(true);
 }
 
 int32_t Game::loadMap(std::string filename)
@@ -590,7 +747,7 @@ Thing* Game::internalGetThing(Player* player, const Position& pos, int32_t index
 			return NULL;
 
 		if(type == STACKPOS_LOOK)
-			return tile->getTopVisibleThing(player);
+			return tile->unshareThing(tile->getTopVisibleThing(player));
 
 		Thing* thing = NULL;
 		switch(type)
@@ -651,7 +808,7 @@ Thing* Game::internalGetThing(Player* player, const Position& pos, int32_t index
 				thing = NULL;
 		}
 
-		return thing;
+		return tile->unshareThing(thing);
 	}
 	else if(pos.y & 0x40)
 	{
@@ -710,9 +867,9 @@ Creature* Game::getCreatureByID(uint32_t id)
 	if(!id)
 		return NULL;
 
-	AutoList<Creature>::iterator it = autoList.find(id);
-	if(it != autoList.end() && !it->second->isRemoved())
-		return it->second;
+	Creature* creature = autoIndex.get(id);
+	if(creature && !creature->isRemoved())
+		return creature;
 
 	return NULL; //just in case the player doesnt exist
 }
@@ -722,9 +879,9 @@ Player* Game::getPlayerByID(uint32_t id)
 	if(!id)
 		return NULL;
 
-	AutoList<Player>::iterator it = Player::autoList.find(id);
-	if(it != Player::autoList.end() && !it->second->isRemoved())
-		return it->second;
+	Creature* creature = autoIndex.get(id);
+	if(creature && !creature->isRemoved())
+		return creature->getPlayer();
 
 	return NULL; //just in case the player doesnt exist
 }
@@ -750,13 +907,16 @@ Player* Game::getPlayerByName(std::string s)
 		return NULL;
 
 	toLowerCaseString(s);
-	for(AutoList<Player>::iterator it = Player::autoList.begin(); it != Player::autoList.end(); ++it)
+	std::pair<PlayerNameIndex::iterator, PlayerNameIndex::iterator> range = playerNames.equal_range(s);
+
+	Player* player = NULL; //with clones allowed, keep returning the oldest one
+	for(PlayerNameIndex::iterator it = range.first; it != range.second; ++it)
 	{
-		if(!it->second->isRemoved() && asLowerCaseString(it->second->getName()) == s)
-			return it->second;
+		if(!it->second->isRemoved() && (!player || it->second->getID() < player->getID()))
+			player = it->second;
 	}
 
-	return NULL;
+	return player;
 }
 
 Player* Game::getPlayerByNameEx(const std::string& s)
@@ -917,6 +1077,10 @@ bool Game::internalPlaceCreature(Creature* creature, const Position& pos, bool e
 	creature->setID();
 
 	autoList[creature->getID()] = creature;
+	autoIndex.set(creature->getID(), creature);
+	if(Player* player = creature->getPlayer())
+		playerNames.insert(std::make_pair(asLowerCaseString(player->getName()), player));
+
 	creature->addList();
 	return true;
 }
@@ -1028,6 +1192,20 @@ bool Game::removeCreature(Creature* creature, bool isLogout /*= true*/)
 	creature->onRemovedCreature();
 
 	autoList.erase(creature->getID());
+	autoIndex.erase(creature->getID());
+	if(Player* player = creature->getPlayer())
+	{
+		std::pair<PlayerNameIndex::iterator, PlayerNameIndex::iterator> range = playerNames.equal_range(asLowerCaseString(player->getName()));
+		for(PlayerNameIndex::iterator it = range.first; it != range.second; ++it)
+		{
+			if(it->second != player)
+				continue;
+
+			playerNames.erase(it);
+			break;
+		}
+	}
+
 	freeThing(creature);
 
 	removeCreatureCheck(creature);
@@ -1691,6 +1869,7 @@ ReturnValue Game::internalAddItem(Creature* actor, Cylinder* toCylinder, Item* i
 		{
 			n = std::min((uint32_t)100 - toItem->getItemCount(), m);
 			toCylinder->__updateThing(toItem, toItem->getID(), toItem->getItemCount() + n);
+			markItemChanged(toItem); //no notification for a merged stack
 		}
 
 		uint32_t count = m - n;
@@ -2843,6 +3022,7 @@ bool Game::playerWriteItem(uint32_t playerId, uint32_t windowTextId, const std::
 		writeItem->resetDate();
 	}
 
+	markItemChanged(writeItem);
 	uint16_t newId = Item::items[writeItem->getID()].writeOnceItemId;
 	if(newId != 0)
 		transformItem(writeItem, newId);
@@ -5762,11 +5942,18 @@ bool Game::reloadHighscores()
 {
 	lastHighscoreCheck = time(NULL);
 	for(int16_t i = 0; i < 9; ++i)
-		highscoreStorage[i] = getHighscore(i);
+		Database::asyncStoreQuery(getHighscoreQuery(i), boost::bind(&Game::loadHighscore, this, i, _1));
 
 	return true;
 }
 
+void Game::loadHighscore(uint16_t skill, DBResult* result)
+{
+	//keep the old list if the query failed
+	if(result)
+		highscoreStorage[skill] = parseHighscore(skill, result);
+}
+
 void Game::checkHighscores()
 {
 	reloadHighscores();
@@ -5791,53 +5978,47 @@ std::string Game::getHighscoreString(uint16_t skill)
 
 Highscore Game::getHighscore(uint16_t skill)
 {
-	Highscore hs;
-
 	Database* db = Database::getInstance();
 	DBResult* result;
 
 	DBQuery query;
-	if(skill >= SKILL__MAGLEVEL)
-	{
-		if(skill == SKILL__MAGLEVEL)
-			query << "SELECT `maglevel`, `name` FROM `players` ORDER BY `maglevel` DESC, `manaspent` DESC LIMIT " << g_config.getNumber(ConfigManager::HIGHSCORES_TOP);
-		else
-			query << "SELECT `level`, `name` FROM `players` ORDER BY `level` DESC, `experience` DESC LIMIT " << g_config.getNumber(ConfigManager::HIGHSCORES_TOP);
-
-		if(!(result = db->storeQuery(query.str())))
-			return hs;
+	if(!(result = db->storeQuery(getHighscoreQuery(skill))))
+		return Highscore();
 
-		do
-		{
-			uint32_t level;
-			if(skill == SKILL__MAGLEVEL)
-				level = result->getDataInt("maglevel");
-			else
-				level = result->getDataInt("level");
+	Highscore hs = parseHighscore(skill, result);
+	result->free();
+	return hs;
+}
 
-			std::string name = result->getDataString("name");
-			if(name.length() > 0)
-				hs.push_back(std::make_pair(name, level));
-		}
-		while(result->next());
-		result->free();
-	}
+std::string Game::getHighscoreQuery(uint16_t skill)
+{
+	std::stringstream query;
+	if(skill == SKILL__MAGLEVEL)
+		query << "SELECT `maglevel`, `name` FROM `players` ORDER BY `maglevel` DESC, `manaspent` DESC LIMIT " << g_config.getNumber(ConfigManager::HIGHSCORES_TOP);
+	else if(skill > SKILL__MAGLEVEL)
+		query << "SELECT `level`, `name` FROM `players` ORDER BY `level` DESC, `experience` DESC LIMIT " << g_config.getNumber(ConfigManager::HIGHSCORES_TOP);
 	else
-	{
 		query << "SELECT `player_skills`.`value`, `players`.`name` FROM `player_skills`,`players` WHERE `player_skills`.`skillid`=" << skill << " AND `player_skills`.`player_id`=`players`.`id` ORDER BY `player_skills`.`value` DESC, `player_skills`.`count` DESC LIMIT " << g_config.getNumber(ConfigManager::HIGHSCORES_TOP);
-		if(!(result = db->storeQuery(query.str())))
-			return hs;
 
-		do
-		{
-			std::string name = result->getDataString("name");
-			if(name.length() > 0)
-				hs.push_back(std::make_pair(name, result->getDataInt("value")));
-		}
-		while(result->next());
-		result->free();
-	}
+	return query.str();
+}
 
+Highscore Game::parseHighscore(uint16_t skill, DBResult* result)
+{
+	std::string field = "value";
+	if(skill == SKILL__MAGLEVEL)
+		field = "maglevel";
+	else if(skill > SKILL__MAGLEVEL)
+		field = "level";
+
+	Highscore hs;
+	do
+	{
+		std::string name = result->getDataString("name");
+		if(name.length() > 0)
+			hs.push_back(std::make_pair(name, result->getDataInt(field)));
+	}
+	while(result->next());
 	return hs;
 }
 
@@ -5934,7 +6115,10 @@ bool Game::reloadInfo(ReloadInfo_t reload, uint32_t playerId/* = 0*/)
 		case RELOAD_CONFIG:
 		{
 			if(g_config.reload())
+			{
+				g_monsters.compileLoot();
 				done = true;
+			}
 			else
 				std::clog << "[Error - Game::reloadInfo] Failed to reload config." << std::endl;
 
@@ -6245,6 +6429,8 @@ void Game::shutdown()
 {
 	std::clog << "Preparing";
 	Scheduler::getInstance().shutdown();
+	TaskPool::getInstance(TASKPOOL_CPU).stop();
+	TaskPool::getInstance(TASKPOOL_DATABASE).stop();
 	std::clog << " to";
 	Dispatcher::getInstance().shutdown();
 	std::clog << " shutdown";
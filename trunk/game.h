@@ -18,11 +18,17 @@
 #ifndef __GAME__
 #define __GAME__
 #include "otsystem.h"
+#if defined __GNUC__ && __GNUC__ >= 4
+#include <tr1/unordered_map>
+#else
+#include <boost/tr1/unordered_map.hpp>
+#endif
 
 #include "enums.h"
 #include "templates.h"
 #include "server.h"
 #include "scheduler.h"
+#include "database.h"
 
 #include "map.h"
 #include "spawn.h"
@@ -38,6 +44,33 @@ class Monster;
 class Npc;
 class CombatInfo;
 
+enum SaveUnit_t
+{
+	SAVEUNIT_PLAYER,
+	SAVEUNIT_HOUSES,
+	SAVEUNIT_GLOBAL
+};
+
+struct SaveUnit
+{
+	SaveUnit(SaveUnit_t _type, uint32_t _guid = 0): type(_type), guid(_guid), cancelled(false), written(false) {}
+
+	SaveUnit_t type;
+	uint32_t guid;
+	bool cancelled, written;
+
+	StringVec statements;
+};
+
+struct SaveSnapshot
+{
+	SaveSnapshot(uint64_t _start): start(_start), paused(0) {}
+
+	uint64_t start, paused;
+	std::list<SaveUnit> units;
+	std::map<uint32_t, SaveUnit*> players;
+};
+
 enum stackposType_t
 {
 	STACKPOS_NORMAL,
@@ -118,6 +151,7 @@ typedef std::vector< std::pair<std::string, uint32_t> > Highscore;
 typedef std::list<Position> Trash;
 typedef std::map<int32_t, float> StageList;
 typedef std::vector<std::string> StatusList;
+typedef std::tr1::unordered_multimap<std::string, Player*> PlayerNameIndex;
 
 #define EVENT_LIGHTINTERVAL 10000
 #define EVENT_DECAYINTERVAL 1000
@@ -140,6 +174,7 @@ class Game
 		void start(ServiceManager* servicer);
 
 		Highscore getHighscore(uint16_t skill);
+		void loadHighscore(uint16_t skill, DBResult* result);
 		std::string getHighscoreString(uint16_t skill);
 		void checkHighscores();
 		bool reloadHighscores();
@@ -155,6 +190,7 @@ class Game
 		  * \returns int32_t 0 built-in spawns, 1 needs xml spawns, 2 needs sql spawns, -1 if got error
 		  */
 		int32_t loadMap(std::string filename);
+		bool loadMapData() {return map->loadMapData();}
 
 		/**
 		  * Get the map size - info purpose only
@@ -329,6 +365,9 @@ class Game
 			int32_t minRangeY = 0, int32_t maxRangeY = 0)
 			{map->getSpectators(list, centerPos, checkforduplicate, multifloor, minRangeX, maxRangeX, minRangeY, maxRangeY);}
 		const SpectatorVec& getSpectators(const Position& centerPos) {return map->getSpectators(centerPos);}
+		bool isPlayerNearby(const Position& centerPos) {return map->isPlayerNearby(centerPos);}
+		void getStepSpectators(SpectatorVec& list, const Position& fromPos, const Position& toPos)
+			{map->getStepSpectators(list, fromPos, toPos);}
 		void clearSpectatorCache() {if(map) map->clearSpectatorCache();}
 
 		ReturnValue internalMoveCreature(Creature* creature, Direction direction, uint32_t flags = 0);
@@ -554,6 +593,10 @@ class Game
 		void saveGameState(bool shallow);
 		void loadGameState();
 
+		void waitSave();
+		bool cancelSave(SaveUnit_t type, uint32_t guid = 0);
+		void markItemChanged(Item* item);
+
 		void cleanMapEx(uint32_t& count);
 		void cleanMap();
 
@@ -611,6 +654,8 @@ class Game
 
 		bool isInBlacklist(std::string ip) const { return std::find(blacklist.begin(), blacklist.end(), ip) != blacklist.end(); }
 		bool isInWhitelist(std::string ip) const { return std::find(whitelist.begin(), whitelist.end(), ip) != whitelist.end(); }
+		const StatusList& getBlacklist() const {return blacklist;}
+		const StatusList& getWhitelist() const {return whitelist;}
 
 	protected:
 		bool playerWhisper(Player* player, const std::string& text);
@@ -629,6 +674,8 @@ class Game
 		std::vector<Thing*> releaseThings;
 		std::map<Item*, uint32_t> tradeItems;
 		AutoList<Creature> autoList;
+		AutoIndex<Creature> autoIndex;
+		PlayerNameIndex playerNames;
 
 		size_t checkCreatureLastIndex;
 		std::vector<Creature*> checkCreatureVectors[EVENT_CREATURECOUNT];
@@ -637,6 +684,15 @@ class Game
 		void checkDecay();
 		void internalDecayItem(Item* item);
 
+		void writeSnapshot(SaveSnapshot* snapshot);
+		SaveSnapshot* saveSnapshot;
+
+		boost::mutex saveLock;
+		boost::condition_variable saveSignal;
+
+		static std::string getHighscoreQuery(uint16_t skill);
+		static Highscore parseHighscore(uint16_t skill, DBResult* result);
+
 		typedef std::list<Item*> DecayList;
 		DecayList decayItems[EVENT_DECAYBUCKETS];
 		DecayList toDecayItems;
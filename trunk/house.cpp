@@ -39,7 +39,7 @@ House::House(uint32_t houseId)
 	entry = Position();
 	id = houseId;
 	rent = price = townId = paidUntil = owner = rentWarnings = lastWarning = 0;
-	syncFlags = HOUSE_SYNC_NAME | HOUSE_SYNC_TOWN | HOUSE_SYNC_SIZE | HOUSE_SYNC_PRICE | HOUSE_SYNC_RENT | HOUSE_SYNC_GUILD;
+	syncFlags = HOUSE_SYNC_NAME | HOUSE_SYNC_TOWN | HOUSE_SYNC_SIZE | HOUSE_SYNC_PRICE | HOUSE_SYNC_RENT | HOUSE_SYNC_GUILD | HOUSE_SYNC_ITEMS;
 }
 
 void House::addTile(HouseTile* tile)
@@ -446,7 +446,12 @@ bool AccessList::parseList(const std::string& _list)
 	playerList.clear();
 	guildList.clear();
 	expressionList.clear();
-	regexList.clear();
+
+	deniedNames.clear();
+	allowedNames.clear();
+	deniedPatterns.clear();
+	allowedPatterns.clear();
+	verdicts.clear();
 
 	list = _list;
 	if(_list.empty())
@@ -482,29 +487,96 @@ bool AccessList::parseList(const std::string& _list)
 
 bool AccessList::isInList(const Player* player)
 {
-	std::string name = player->getName();
-	boost::cmatch what;
-	try
+	VerdictCache::iterator it = verdicts.find(player->getGUID());
+	if(it != verdicts.end() && it->second.guildId == player->getGuildId()
+		&& it->second.rankId == player->getRankId() && it->second.name == player->getName())
+		return it->second.allowed;
+
+	if(verdicts.size() >= ACCESSLIST_CACHE_SIZE)
+		verdicts.clear();
+
+	Verdict& verdict = verdicts[player->getGUID()];
+	verdict.name = player->getName();
+	verdict.guildId = player->getGuildId();
+	verdict.rankId = player->getRankId();
+
+	verdict.allowed = checkList(player);
+	return verdict.allowed;
+}
+
+bool AccessList::checkList(const Player* player) const
+{
+	if(!deniedNames.empty() || !allowedNames.empty() || !deniedPatterns.empty() || !allowedPatterns.empty())
 	{
-		toLowerCaseString(name);
-		for(RegexList::iterator it = regexList.begin(); it != regexList.end(); ++it)
+		std::string name = asLowerCaseString(player->getName());
+		if(deniedNames.find(name) != deniedNames.end())
+			return false;
+
+		for(PatternList::const_iterator it = deniedPatterns.begin(); it != deniedPatterns.end(); ++it)
+		{
+			if(matchPattern(it->c_str(), name.c_str()))
+				return false;
+		}
+
+		if(allowedNames.find(name) != allowedNames.end())
+			return true;
+
+		for(PatternList::const_iterator it = allowedPatterns.begin(); it != allowedPatterns.end(); ++it)
 		{
-			if(boost::regex_match(name.c_str(), what, it->first))
-				return it->second;
+			if(matchPattern(it->c_str(), name.c_str()))
+				return true;
 		}
 	}
-	catch(...) {}
 
 	if(playerList.find(player->getGUID()) != playerList.end())
 		return true;
 
-	for(GuildList::iterator git = guildList.begin(); git != guildList.end(); ++git)
+	if(!player->getGuildId())
+		return false;
+
+	uint64_t guild = (uint64_t)player->getGuildId() << 32;
+	return guildList.find(guild | player->getRankId()) != guildList.end()
+		|| guildList.find(guild | (uint32_t)-1) != guildList.end();
+}
+
+bool AccessList::matchPattern(const char* pattern, const char* name)
+{
+	// '*' matches any run of characters and '?' at most one
+	for(; *pattern; ++pattern)
 	{
-		if(git->first == player->getGuildId() && ((uint32_t)git->second == player->getRankId() || git->second == -1))
-			return true;
+		if(*pattern == '*')
+		{
+			while(*(pattern + 1) == '*')
+				++pattern;
+
+			if(!*(pattern + 1))
+				return true;
+
+			for(const char* tmp = name; ; ++tmp)
+			{
+				if(matchPattern(pattern + 1, tmp))
+					return true;
+
+				if(!*tmp)
+					return false;
+			}
+		}
+
+		if(*pattern == '?')
+		{
+			if(matchPattern(pattern + 1, name))
+				return true;
+
+			if(!*name)
+				return false;
+		}
+		else if(*name != *pattern)
+			return false;
+
+		++name;
 	}
 
-	return false;
+	return !*name;
 }
 
 bool AccessList::addPlayer(std::string& name)
@@ -515,6 +587,7 @@ bool AccessList::addPlayer(std::string& name)
 		return false;
 
 	playerList.insert(guid);
+	verdicts.clear();
 	return true;
 }
 
@@ -532,52 +605,43 @@ bool AccessList::addGuild(const std::string& guildName, const std::string& rankN
 	if(!rankId)
 		return false;
 
-	for(GuildList::iterator git = guildList.begin(); git != guildList.end(); ++git)
-	{
-		if(git->first == guildId && git->second == rankId)
-			return true;
-	}
-
-	guildList.push_back(std::make_pair(guildId, rankId));
+	guildList.insert(((uint64_t)guildId << 32) | (uint32_t)rankId);
+	verdicts.clear();
 	return true;
 }
 
 bool AccessList::addExpression(const std::string& expression)
 {
-	for(ExpressionList::iterator it = expressionList.begin(); it != expressionList.end(); ++it)
-	{
-		if((*it) == expression)
-			return false;
-	}
+	if(expressionList.find(expression) != expressionList.end())
+		return false;
 
-	std::string out, meta = ".[{}()\\+|^$";
-	for(std::string::const_iterator it = expression.begin(); it != expression.end(); ++it)
-	{
-		if(meta.find(*it) != std::string::npos)
-			out += "\\";
+	expressionList.insert(expression);
+	std::string out = expression;
+	replaceString(out, "**", "");
 
-		out += (*it);
+	bool allow = true;
+	if(out.substr(0, 1) == "!")
+	{
+		allow = false;
+		out.erase(0, 1);
 	}
 
-	replaceString(out, "**", "");
-	replaceString(out, "*", ".*");
-	replaceString(out, "?", ".?");
+	if(out.empty())
+		return true;
 
-	try
+	if(out.find_first_of("*?") == std::string::npos)
 	{
-		if(out.length() > 0)
-		{
-			expressionList.push_back(out);
-			if(out.substr(0, 1) == "!")
-			{
-				if(out.length() > 1)
-					regexList.push_front(std::make_pair(boost::regex(out.substr(1)), false));
-			}
-			else
-				regexList.push_back(std::make_pair(boost::regex(out), true));
-		}
+		if(allow)
+			allowedNames.insert(out);
+		else
+			deniedNames.insert(out);
 	}
-	catch(...) {}
+	else if(allow)
+		allowedPatterns.push_back(out);
+	else
+		deniedPatterns.push_back(out);
+
+	verdicts.clear();
 	return true;
 }
 
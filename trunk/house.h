@@ -19,11 +19,12 @@
 #define __HOUSE__
 #include "otsystem.h"
 
-#include <boost/regex.hpp>
 #if defined __GNUC__ && __GNUC__ >= 4
 #include <tr1/unordered_set>
+#include <tr1/unordered_map>
 #else
 #include <boost/tr1/unordered_set.hpp>
+#include <boost/tr1/unordered_map.hpp>
 #endif
 
 #include "position.h"
@@ -61,6 +62,7 @@ typedef std::list<Door*> HouseDoorList;
 typedef std::list<BedItem*> HouseBedList;
 typedef std::map<uint32_t, House*> HouseMap;
 
+#define ACCESSLIST_CACHE_SIZE 1000
 class AccessList
 {
 	public:
@@ -77,16 +79,33 @@ class AccessList
 		void getList(std::string& _list) const;
 
 	private:
+		bool checkList(const Player* player) const;
+		static bool matchPattern(const char* pattern, const char* name);
+
 		typedef std::tr1::unordered_set<uint32_t> PlayerList;
-		typedef std::list<std::pair<uint32_t, int32_t> > GuildList;
-		typedef std::list<std::string> ExpressionList;
-		typedef std::list<std::pair<boost::regex, bool> > RegexList;
+		typedef std::tr1::unordered_set<uint64_t> GuildList;
+		typedef std::tr1::unordered_set<std::string> ExpressionList;
+		typedef std::tr1::unordered_set<std::string> NameList;
+		typedef std::vector<std::string> PatternList;
+
+		struct Verdict
+		{
+			std::string name;
+			uint32_t guildId, rankId;
+			bool allowed;
+		};
+		typedef std::tr1::unordered_map<uint32_t, Verdict> VerdictCache;
 
 		std::string list;
 		PlayerList playerList;
 		GuildList guildList;
 		ExpressionList expressionList;
-		RegexList regexList;
+
+		// wildcard-free expressions are looked up by name, the rest is matched
+		// in order; denials always win over allowances, as they used to
+		NameList deniedNames, allowedNames;
+		PatternList deniedPatterns, allowedPatterns;
+		VerdictCache verdicts;
 };
 
 class Door : public Item
@@ -160,7 +179,8 @@ class House
 			HOUSE_SYNC_GUILD = 1 << 3,
 			HOUSE_SYNC_PRICE = 1 << 4,
 			HOUSE_SYNC_RENT = 1 << 5,
-			HOUSE_SYNC_UPDATE = 1 << 6
+			HOUSE_SYNC_UPDATE = 1 << 6,
+			HOUSE_SYNC_ITEMS = 1 << 7
 		};
 
 		House(uint32_t houseId);
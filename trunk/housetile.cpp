@@ -51,6 +51,25 @@ void HouseTile::__internalAddThing(uint32_t index, Thing* thing)
 		updateHouse(item);
 }
 
+void HouseTile::postAddNotification(Creature* actor, Thing* thing, const Cylinder* oldParent,
+	int32_t index, cylinderlink_t link/* = LINK_OWNER*/)
+{
+	//containers forward their changes here as well, so this covers the whole house contents
+	if(thing->getItem())
+		house->setSyncFlag(House::HOUSE_SYNC_ITEMS);
+
+	Tile::postAddNotification(actor, thing, oldParent, index, link);
+}
+
+void HouseTile::postRemoveNotification(Creature* actor, Thing* thing, const Cylinder* newParent,
+	int32_t index, bool isCompleteRemoval, cylinderlink_t link/* = LINK_OWNER*/)
+{
+	if(thing->getItem())
+		house->setSyncFlag(House::HOUSE_SYNC_ITEMS);
+
+	Tile::postRemoveNotification(actor, thing, newParent, index, isCompleteRemoval, link);
+}
+
 void HouseTile::updateHouse(Item* item)
 {
 	if(item->getTile() != this)
@@ -17,6 +17,7 @@
 #include "otpch.h"
 #include <iostream>
 #include <iomanip>
+#include <zlib.h>
 
 #include "iologindata.h"
 #include "tools.h"
@@ -402,8 +403,12 @@ bool IOLoginData::loadPlayer(Player* player, const std::string& name, bool preLo
 	player->setGUID(result->getDataInt("id"));
 	player->premiumDays = account.premiumDays;
 
-	nameCacheMap[player->getGUID()] = name;
-	guidCacheMap[name] = player->getGUID();
+	{
+		boost::mutex::scoped_lock lockClass(cacheLock);
+		nameCacheMap[player->getGUID()] = name;
+		guidCacheMap[name] = player->getGUID();
+	}
+
 	if(preLoad)
 	{
 		//only loading basic info
@@ -666,11 +671,33 @@ bool IOLoginData::loadPlayer(Player* player, const std::string& name, bool preLo
 		itemMap.clear();
 	}
 
-	//load depot items
+	//load depots
+	query.str("");
+	query << "SELECT `depot_id`, `data` FROM `player_depots` WHERE `player_id` = " << player->getGUID();
+	if((result = db->storeQuery(query.str())))
+	{
+		do
+		{
+			uint64_t size = 0;
+			const char* data = result->getDataStream("data", size);
+
+			uint32_t depotId = result->getDataInt("depot_id");
+			if(!loadDepot(player, depotId, data, size))
+			{
+				std::clog << "[Error - IOLoginData::loadPlayer] Cannot load depot " << depotId << " for player " << name << ", it will not be saved" << std::endl;
+				player->brokenDepots.insert(depotId);
+			}
+		}
+		while(result->next());
+		result->free();
+	}
+
+	//load depot items of players not saved since depots became blobs, the next save converts them
 	query.str("");
 	query << "SELECT `pid`, `sid`, `itemtype`, `count`, `attributes` FROM `player_depotitems` WHERE `player_id` = " << player->getGUID() << " ORDER BY `sid` DESC";
 	if((result = db->storeQuery(query.str())))
 	{
+		player->legacyDepots = true;
 		loadItems(itemMap, result);
 		for(ItemMap::reverse_iterator rit = itemMap.rbegin(); rit != itemMap.rend(); ++rit)
 		{
@@ -681,7 +708,10 @@ bool IOLoginData::loadPlayer(Player* player, const std::string& name, bool preLo
 				if(Container* c = item->getContainer())
 				{
 					if(Depot* depot = c->getDepot())
-						player->addDepot(depot, pid);
+					{
+						if(player->addDepot(depot, pid))
+							depot->setChanged(true);
+					}
 					else
 						std::clog << "[Error - IOLoginData::loadPlayer] Cannot load depot " << pid << " for player " << name << std::endl;
 				}
@@ -809,6 +839,18 @@ void IOLoginData::loadItems(ItemMap& itemMap, DBResult* result)
 
 bool IOLoginData::savePlayer(Player* player, bool preSave/* = true*/, bool shallow/* = false*/)
 {
+	//a copy of this player still pending in the snapshot is older than this save and
+	//gets dropped, so only a full save may do that; a shallow one has to become full
+	bool fullSave = player->isSaving() && g_config.getBool(ConfigManager::SAVE_PLAYER_DATA);
+	if(fullSave && !Database::getRecorder() && g_game.cancelSave(SAVEUNIT_PLAYER, player->getGUID()))
+	{
+		//the copy had cleared the depot flags already, they stay set until a commit
+		for(DepotMap::iterator it = player->depots.begin(); it != player->depots.end(); ++it)
+			it->second.first->setChanged(true);
+
+		shallow = false;
+	}
+
 	if(preSave && player->health <= 0)
 	{
 		if(player->getSkull() == SKULL_BLACK)
@@ -831,7 +873,7 @@ bool IOLoginData::savePlayer(Player* player, bool preSave/* = true*/, bool shall
 
 	query.str("");
 	query << "UPDATE `players` SET `lastlogin` = " << player->lastLogin << ", `lastip` = " << player->lastIP;
-	if(!player->isSaving() || !g_config.getBool(ConfigManager::SAVE_PLAYER_DATA))
+	if(!fullSave)
 	{
 		query << " WHERE `id` = " << player->getGUID() << db->getUpdateLimiter();
 		if(!db->query(query.str()))
@@ -931,11 +973,11 @@ bool IOLoginData::savePlayer(Player* player, bool preSave/* = true*/, bool shall
 		return false;
 
 	// skills
+	DBStatement skills(db, "UPDATE `player_skills` SET `value` = ?, `count` = ? WHERE `player_id` = ? AND `skillid` = ?" + db->getUpdateLimiter());
 	for(int32_t i = SKILL_FIRST; i <= SKILL_LAST; ++i)
 	{
-		query.str("");
-		query << "UPDATE `player_skills` SET `value` = " << player->skills[i][SKILL_LEVEL] << ", `count` = " << player->skills[i][SKILL_TRIES] << " WHERE `player_id` = " << player->getGUID() << " AND `skillid` = " << i << db->getUpdateLimiter();
-		if(!db->query(query.str()))
+		skills.bindInt(player->skills[i][SKILL_LEVEL]).bindInt(player->skills[i][SKILL_TRIES]).bindInt(player->getGUID()).bindInt(i);
+		if(!skills.execute())
 			return false;
 	}
 
@@ -949,14 +991,15 @@ bool IOLoginData::savePlayer(Player* player, bool preSave/* = true*/, bool shall
 		return false;
 
 	char buffer[280];
+	DBParams row;
 	DBInsert query_insert(db);
 	if(player->learnedInstantSpellList.size())
 	{
 		query_insert.setQuery("INSERT INTO `player_spells` (`player_id`, `name`) VALUES ");
 		for(LearnedInstantSpellList::const_iterator it = player->learnedInstantSpellList.begin(); it != player->learnedInstantSpellList.end(); ++it)
 		{
-			sprintf(buffer, "%d, %s", player->getGUID(), db->escapeString(*it).c_str());
-			if(!query_insert.addRow(buffer))
+			row.bindInt(player->getGUID()).bindString(*it);
+			if(!query_insert.addRow(row))
 				return false;
 		}
 
@@ -982,38 +1025,44 @@ bool IOLoginData::savePlayer(Player* player, bool preSave/* = true*/, bool shall
 		return false;
 
 	itemList.clear();
-	//save depot items
-	//std::stringstream ss;
-	for(DepotMap::iterator it = player->depots.begin(); it != player->depots.end(); ++it)
+	//save depots, one blob each and only those that changed; rows from before blobs
+	//mean all of them have to go
+	if(player->legacyDepots)
 	{
-		/*if(it->second.second)
-		{
-			it->second.second = false;
-			ss << it->first << ",";*/
-			itemList.push_back(itemBlock(it->first, it->second.first));
-		//}
-	}
-
-	/*std::string s = ss.str();
-	size_t size = s.length();
-	if(size > 0)
-	{*/
-	
 		query.str("");
-		query << "DELETE FROM `player_depotitems` WHERE `player_id` = " << player->getGUID();// << " AND `pid` IN (" << s.substr(0, --size) << ")";
+		query << "DELETE FROM `player_depotitems` WHERE `player_id` = " << player->getGUID();
 		if(!db->query(query.str()))
 			return false;
+	}
 
-		if(itemList.size()) {
-			query_insert.setQuery("INSERT INTO `player_depotitems` (`player_id`, `pid`, `sid`, `itemtype`, `count`, `attributes`) VALUES ");
-			if(!saveItems(player, itemList, query_insert))
-				return false;
+	DBStatement deleteDepot(db, "DELETE FROM `player_depots` WHERE `player_id` = ? AND `depot_id` = ?");
+	DBStatement insertDepot(db, "INSERT INTO `player_depots` (`player_id`, `depot_id`, `data`) VALUES (?, ?, ?)");
 
-			itemList.clear();
+	std::vector<Depot*> savedDepots;
+	std::string data;
+	for(DepotMap::iterator it = player->depots.begin(); it != player->depots.end(); ++it)
+	{
+		Depot* depot = it->second.first;
+		if(!player->legacyDepots && !depot->isChanged())
+			continue;
+
+		if(player->brokenDepots.count(it->first))
+		{
+			std::clog << "[Warning - IOLoginData::savePlayer] Not saving depot " << it->first << " of player " << player->getName() << ", the stored one failed to load" << std::endl;
+			continue;
 		}
-		
-	
-	//}
+
+		saveDepot(depot, data);
+		deleteDepot.bindInt(player->getGUID()).bindInt(it->first);
+		if(!deleteDepot.execute())
+			return false;
+
+		insertDepot.bindInt(player->getGUID()).bindInt(it->first).bindBlob(data.data(), data.size());
+		if(!insertDepot.execute())
+			return false;
+
+		savedDepots.push_back(depot);
+	}
 
 	query.str("");
 	query << "DELETE FROM `player_storage` WHERE `player_id` = " << player->getGUID();
@@ -1024,8 +1073,8 @@ bool IOLoginData::savePlayer(Player* player, bool preSave/* = true*/, bool shall
 	query_insert.setQuery("INSERT INTO `player_storage` (`player_id`, `key`, `value`) VALUES ");
 	for(StorageMap::const_iterator cit = player->getStorageBegin(); cit != player->getStorageEnd(); ++cit)
 	{
-		sprintf(buffer, "%u, %s, %s", player->getGUID(), db->escapeString(cit->first).c_str(), db->escapeString(cit->second).c_str());
-		if(!query_insert.addRow(buffer))
+		row.bindInt(player->getGUID()).bindString(cit->first).bindString(cit->second);
+		if(!query_insert.addRow(row))
 			return false;
 	}
 
@@ -1091,12 +1140,157 @@ bool IOLoginData::savePlayer(Player* player, bool preSave/* = true*/, bool shall
 		return false;
 
 	//End the transaction
-	return trans.commit();
+	if(!trans.commit())
+		return false;
+
+	//only now, a failed transaction leaves the flags for the next try
+	for(std::vector<Depot*>::iterator it = savedDepots.begin(); it != savedDepots.end(); ++it)
+		(*it)->setChanged(false);
+
+	player->legacyDepots = false;
+	return true;
+}
+
+bool IOLoginData::loadDepot(Player* player, uint32_t depotId, const char* data, uint64_t size)
+{
+	if(!size)
+		return false;
+
+	std::string buffer;
+	const char* stream = data + 1;
+	uint64_t length = size - 1;
+	if(data[0] == DEPOT_FORMAT_ZLIB)
+	{
+		uint32_t rawSize = 0;
+		if(size < 5)
+			return false;
+
+		memcpy(&rawSize, data + 1, 4);
+		if(rawSize > (size - 5) * 1032) //beyond what deflate can reach, don't trust it
+			return false;
+
+		buffer.resize(rawSize);
+
+		uLongf inflated = rawSize;
+		if(uncompress((Bytef*)&buffer[0], &inflated, (const Bytef*)(data + 5), size - 5) != Z_OK || inflated != rawSize)
+			return false;
+
+		stream = buffer.data();
+		length = rawSize;
+	}
+	else if(data[0] != DEPOT_FORMAT_RAW)
+		return false;
+
+	PropStream propStream;
+	propStream.init(stream, length);
+
+	Item* item = loadDepotItem(propStream);
+	if(!item)
+		return false;
+
+	Depot* depot = NULL;
+	if(Container* container = item->getContainer())
+		depot = container->getDepot();
+
+	if(!depot || !player->addDepot(depot, depotId))
+	{
+		delete item;
+		return false;
+	}
+
+	depot->setChanged(false);
+	return true;
+}
+
+Item* IOLoginData::loadDepotItem(PropStream& propStream)
+{
+	uint16_t id = 0;
+	if(!propStream.getShort(id))
+		return NULL;
+
+	//an unknown item can't be skipped, its attributes have no known length
+	Item* item = Item::CreateItem(id);
+	if(!item)
+	{
+		std::clog << "[Warning - IOLoginData::loadDepotItem] Unknown item type " << id << std::endl;
+		return NULL;
+	}
+
+	if(!item->unserializeAttr(propStream))
+	{
+		std::clog << "[Warning - IOLoginData::loadDepotItem] Unserialize error for item with id " << id << std::endl;
+		delete item;
+		return NULL;
+	}
+
+	if(Container* container = item->getContainer())
+	{
+		for(; container->serializationCount > 0; --container->serializationCount)
+		{
+			Item* child = loadDepotItem(propStream);
+			if(!child)
+			{
+				delete item;
+				return NULL;
+			}
+
+			container->__internalAddThing(child);
+		}
+
+		uint8_t endAttr = ATTR_END;
+		if(!propStream.getByte(endAttr) || endAttr != ATTR_END)
+		{
+			delete item;
+			return NULL;
+		}
+	}
+
+	return item;
+}
+
+void IOLoginData::saveDepot(Depot* depot, std::string& data)
+{
+	PropWriteStream stream;
+	saveDepotItem(stream, depot);
+
+	uint32_t size = 0;
+	const char* buffer = stream.getStream(size);
+	if(g_config.getBool(ConfigManager::DEPOT_COMPRESSION))
+	{
+		uLongf length = compressBound(size);
+		data.resize(length + 5);
+		data[0] = DEPOT_FORMAT_ZLIB;
+		memcpy(&data[1], &size, 4);
+		if(compress2((Bytef*)&data[5], &length, (const Bytef*)buffer, size, Z_BEST_SPEED) == Z_OK)
+		{
+			data.resize(length + 5);
+			return;
+		}
+	}
+
+	data.assign(1, (char)DEPOT_FORMAT_RAW);
+	data.append(buffer, size);
+}
+
+void IOLoginData::saveDepotItem(PropWriteStream& stream, const Item* item)
+{
+	//same layout as binary house storage, containers list their items in reverse
+	stream.addShort(item->getID());
+	item->serializeAttr(stream);
+	if(const Container* container = item->getContainer())
+	{
+		stream.addByte(ATTR_CONTAINER_ITEMS);
+		stream.addLong(container->size());
+		for(ItemList::const_reverse_iterator rit = container->getReversedItems(); rit != container->getReversedEnd(); ++rit)
+			saveDepotItem(stream, (*rit));
+	}
+
+	stream.addByte(ATTR_END);
 }
 
 bool IOLoginData::saveItems(const Player* player, const ItemBlockList& itemList, DBInsert& query_insert)
 {
-	Database* db = Database::getInstance();
+	DBParams row;
 	typedef std::pair<Container*, uint32_t> Stack;
 	std::list<Stack> stackList;
 
@@ -1112,11 +1306,9 @@ bool IOLoginData::saveItems(const Player* player, const ItemBlockList& itemList,
 		uint32_t attributesSize = 0;
 		const char* attributes = propWriteStream.getStream(attributesSize);
 
-		std::stringstream buffer;
-		buffer << player->getGUID() << ", " << it->first << ", " << runningId << ", " << item->getID() << ", "
-			   << (int32_t)item->getSubType() << ", " << db->escapeBlob(attributes, attributesSize).c_str();
-
-		if(!query_insert.addRow(buffer))
+		row.bindInt(player->getGUID()).bindInt(it->first).bindInt(runningId).bindInt(item->getID())
+			.bindInt(item->getSubType()).bindBlob(attributes, attributesSize);
+		if(!query_insert.addRow(row))
 			return false;
 
 		if(Container* container = item->getContainer())
@@ -1141,11 +1333,9 @@ bool IOLoginData::saveItems(const Player* player, const ItemBlockList& itemList,
 			uint32_t attributesSize = 0;
 			const char* attributes = propWriteStream.getStream(attributesSize);
 
-			std::stringstream buffer;
-			buffer << player->getGUID() << ", " << stack.second << ", " << runningId << ", " << item->getID() << ", "
-				   << (int32_t)item->getSubType() << ", " << db->escapeBlob(attributes, attributesSize).c_str();
-
-			if(!query_insert.addRow(buffer))
+			row.bindInt(player->getGUID()).bindInt(stack.second).bindInt(runningId).bindInt(item->getID())
+				.bindInt(item->getSubType()).bindBlob(attributes, attributesSize);
+			if(!query_insert.addRow(row))
 				return false;
 		}
 	}
@@ -1399,8 +1589,8 @@ bool IOLoginData::playerExists(uint32_t guid, bool multiworld /*= false*/, bool
 {
 	if(checkCache)
 	{
-		NameCacheMap::iterator it = nameCacheMap.find(guid);
-		if(it != nameCacheMap.end())
+		boost::mutex::scoped_lock lockClass(cacheLock);
+		if(nameCacheMap.find(guid) != nameCacheMap.end())
 			return true;
 	}
 
@@ -1419,6 +1609,7 @@ bool IOLoginData::playerExists(uint32_t guid, bool multiworld /*= false*/, bool
 	const std::string name = result->getDataString("name");
 	result->free();
 
+	boost::mutex::scoped_lock lockClass(cacheLock);
 	nameCacheMap[guid] = name;
 	return true;
 }
@@ -1427,6 +1618,7 @@ bool IOLoginData::playerExists(std::string& name, bool multiworld /*= false*/, b
 {
 	if(checkCache)
 	{
+		boost::mutex::scoped_lock lockClass(cacheLock);
 		GuidCacheMap::iterator it = guidCacheMap.find(name);
 		if(it != guidCacheMap.end())
 		{
@@ -1448,19 +1640,24 @@ bool IOLoginData::playerExists(std::string& name, bool multiworld /*= false*/, b
 		return false;
 
 	name = result->getDataString("name");
-	guidCacheMap[name] = result->getDataInt("id");
-
+	uint32_t guid = result->getDataInt("id");
 	result->free();
+
+	boost::mutex::scoped_lock lockClass(cacheLock);
+	guidCacheMap[name] = guid;
 	return true;
 }
 
 bool IOLoginData::getNameByGuid(uint32_t guid, std::string& name, bool multiworld /*= false*/)
 {
-	NameCacheMap::iterator it = nameCacheMap.find(guid);
-	if(it != nameCacheMap.end())
 	{
-		name = it->second;
-		return true;
+		boost::mutex::scoped_lock lockClass(cacheLock);
+		NameCacheMap::iterator it = nameCacheMap.find(guid);
+		if(it != nameCacheMap.end())
+		{
+			name = it->second;
+			return true;
+		}
 	}
 
 	Database* db = Database::getInstance();
@@ -1478,15 +1675,18 @@ bool IOLoginData::getNameByGuid(uint32_t guid, std::string& name, bool multiworl
 	name = result->getDataString("name");
 	result->free();
 
+	boost::mutex::scoped_lock lockClass(cacheLock);
 	nameCacheMap[guid] = name;
 	return true;
 }
 
 bool IOLoginData::storeNameByGuid(uint32_t guid)
 {
-	NameCacheMap::iterator it = nameCacheMap.find(guid);
-	if(it != nameCacheMap.end())
-		return true;
+	{
+		boost::mutex::scoped_lock lockClass(cacheLock);
+		if(nameCacheMap.find(guid) != nameCacheMap.end())
+			return true;
+	}
 
 	Database* db = Database::getInstance();
 	DBQuery query;
@@ -1496,19 +1696,25 @@ bool IOLoginData::storeNameByGuid(uint32_t guid)
 	if(!(result = db->storeQuery(query.str())))
 		return false;
 
-	nameCacheMap[guid] = result->getDataString("name");
+	const std::string name = result->getDataString("name");
 	result->free();
+
+	boost::mutex::scoped_lock lockClass(cacheLock);
+	nameCacheMap[guid] = name;
 	return true;
 }
 
 bool IOLoginData::getGuidByName(uint32_t& guid, std::string& name, bool multiworld /*= false*/)
 {
-	GuidCacheMap::iterator it = guidCacheMap.find(name);
-	if(it != guidCacheMap.end())
 	{
-		name = it->first;
-		guid = it->second;
-		return true;
+		boost::mutex::scoped_lock lockClass(cacheLock);
+		GuidCacheMap::iterator it = guidCacheMap.find(name);
+		if(it != guidCacheMap.end())
+		{
+			name = it->first;
+			guid = it->second;
+			return true;
+		}
 	}
 
 	Database* db = Database::getInstance();
@@ -1525,9 +1731,10 @@ bool IOLoginData::getGuidByName(uint32_t& guid, std::string& name, bool multiwor
 
 	name = result->getDataString("name");
 	guid = result->getDataInt("id");
+	result->free();
 
+	boost::mutex::scoped_lock lockClass(cacheLock);
 	guidCacheMap[name] = guid;
-	result->free();
 	return true;
 }
 
@@ -1565,6 +1772,7 @@ bool IOLoginData::changeName(uint32_t guid, std::string newName, std::string old
 	if(!db->query(query.str()))
 		return false;
 
+	boost::mutex::scoped_lock lockClass(cacheLock);
 	GuidCacheMap::iterator it = guidCacheMap.find(oldName);
 	if(it != guidCacheMap.end())
 	{
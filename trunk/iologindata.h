@@ -34,6 +34,12 @@ enum DeleteCharacter_t
 	DELETE_SUCCESS
 };
 
+enum DepotFormat_t
+{
+	DEPOT_FORMAT_RAW = 0,
+	DEPOT_FORMAT_ZLIB = 1 //followed by the inflated size
+};
+
 typedef std::pair<int32_t, Item*> itemBlock;
 typedef std::list<itemBlock> ItemBlockList;
 
@@ -123,11 +129,20 @@ class IOLoginData
 		typedef std::map<uint32_t, std::string> NameCacheMap;
 		NameCacheMap nameCacheMap;
 
+		//the login stages look names up on the database workers too
+		boost::mutex cacheLock;
+
 		typedef std::map<int32_t, std::pair<Item*, int32_t> > ItemMap;
 
 		bool saveItems(const Player* player, const ItemBlockList& itemList, DBInsert& query_insert);
 		void loadItems(ItemMap& itemMap, DBResult* result);
 
+		bool loadDepot(Player* player, uint32_t depotId, const char* data, uint64_t size);
+		Item* loadDepotItem(PropStream& propStream);
+
+		void saveDepot(Depot* depot, std::string& data);
+		void saveDepotItem(PropWriteStream& stream, const Item* item);
+
 		bool storeNameByGuid(uint32_t guid);
 };
 #endif
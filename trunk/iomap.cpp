@@ -33,9 +33,6 @@
 
 extern ConfigManager g_config;
 extern Game g_game;
-#ifdef __GROUND_CACHE__
-extern std::map<Item*, int32_t> g_grounds;
-#endif
 
 typedef uint8_t attribute_t;
 typedef uint32_t flags_t;
@@ -64,15 +61,87 @@ typedef uint32_t flags_t;
 	|--- OTBM_ITEM_DEF (not implemented)
 */
 
-Tile* IOMap::createTile(Item*& ground, Item* item, uint16_t px, uint16_t py, uint16_t pz)
+struct MapTile
+{
+	uint16_t x, y, z;
+	uint32_t houseId, flags;
+	uint32_t firstItem, itemCount;
+	bool isHouse;
+};
+
+struct MapArea
+{
+	MapArea(NODE _node): node(_node), done(false) {}
+
+	NODE node;
+	bool done;
+
+	std::vector<MapTile> tiles;
+	ItemVector items;
+
+	std::vector<Thing*> uniqueThings;
+	std::string error;
+};
+
+struct MapAreaQueue
+{
+	MapAreaQueue(): next(0), stop(false) {}
+
+	std::vector<MapArea> areas;
+	uint32_t next;
+	bool stop;
+
+	boost::mutex lock;
+	boost::condition_variable signal;
+};
+
+static std::string getTileError(uint16_t x, uint16_t y, uint16_t z, const std::string& error)
+{
+	std::stringstream ss;
+	ss << "[x:" << x << ", y:" << y << ", z:" << z << "] " << error;
+	return ss.str();
+}
+
+#ifdef __GROUND_CACHE__
+Item* IOMap::shareItem(SharedItemMap& sharedItems, Item* item)
+{
+	if(!item->isShareable())
+		return item;
+
+	SharedItemMap::iterator it = sharedItems.find(item->getID());
+	if(it == sharedItems.end())
+	{
+		item->setShared(true);
+		sharedItems[item->getID()] = item;
+		return item;
+	}
+
+	if(it->second->getItemCount() != item->getItemCount())
+		return item;
+
+	delete item;
+	return it->second;
+}
+
+#endif
+void* IOMap::allocateTile(Map* map, uint16_t px, uint16_t py, size_t bytes)
+{
+	if(map)
+		return map->allocate(px, py, bytes);
+
+	//tiles created while the server runs stay on the heap
+	return ::operator new(bytes);
+}
+
+Tile* IOMap::createTile(Item*& ground, Item* item, uint16_t px, uint16_t py, uint16_t pz, Map* map/* = NULL*/)
 {
 	Tile* tile = NULL;
 	if(ground)
 	{
 		if((item && item->isBlocking(NULL)) || ground->isBlocking(NULL)) //tile is blocking with possibly some decoration, should be static
-			tile = new StaticTile(px, py, pz);
+			tile = new(allocateTile(map, px, py, sizeof(StaticTile))) StaticTile(px, py, pz);
 		else //tile is not blocking with possibly multiple items, use dynamic
-			tile = new DynamicTile(px, py, pz);
+			tile = new(allocateTile(map, px, py, sizeof(DynamicTile))) DynamicTile(px, py, pz);
 
 		tile->__internalAddThing(ground);
 		if(ground->getDecaying() != DECAYING_TRUE)
@@ -84,7 +153,7 @@ Tile* IOMap::createTile(Item*& ground, Item* item, uint16_t px, uint16_t py, uin
 		ground = NULL;
 	}
 	else //no ground on this tile, so it will always block
-		tile = new StaticTile(px, py, pz);
+		tile = new(allocateTile(map, px, py, sizeof(StaticTile))) StaticTile(px, py, pz);
 
 	return tile;
 }
@@ -92,7 +161,7 @@ Tile* IOMap::createTile(Item*& ground, Item* item, uint16_t px, uint16_t py, uin
 bool IOMap::loadMap(Map* map, const std::string& identifier)
 {
 	FileLoader f;
-	if(!f.openFile(identifier.c_str(), false, true))
+	if(!f.openFile(identifier.c_str(), false))
 	{
 		std::stringstream ss;
 		ss << "Could not open the file " << identifier << ".";
@@ -226,11 +295,7 @@ bool IOMap::loadMap(Map* map, const std::string& identifier)
 	for(StringVec::iterator it = map->descriptions.begin(); it != map->descriptions.end(); ++it)
 		std::clog << "\"" << (*it) << "\"" << std::endl;
 
-#ifdef __GROUND_CACHE__
-	typedef std::map<uint16_t, std::pair<Item*, int32_t> > CacheMap;
-	CacheMap groundCache;
-
-#endif
+	std::vector<NODE> areas;
 	NODE nodeMapData = f.getChildNode(nodeMap, type);
 	while(nodeMapData != NO_NODE)
 	{
@@ -241,348 +306,7 @@ bool IOMap::loadMap(Map* map, const std::string& identifier)
 		}
 
 		if(type == OTBM_TILE_AREA)
-		{
-			if(!f.getProps(nodeMapData, propStream))
-			{
-				setLastErrorString("Invalid map node.");
-				return false;
-			}
-
-			OTBM_Destination_coords* areaCoord;
-			if(!propStream.getStruct(areaCoord))
-			{
-				setLastErrorString("Invalid map node.");
-				return false;
-			}
-
-			int32_t baseX = areaCoord->_x, baseY = areaCoord->_y, baseZ = areaCoord->_z;
-			NODE nodeTile = f.getChildNode(nodeMapData, type);
-			while(nodeTile != NO_NODE)
-			{
-				if(f.getError() != ERROR_NONE)
-				{
-					setLastErrorString("Could not read node data.");
-					return false;
-				}
-
-				if(type == OTBM_TILE || type == OTBM_HOUSETILE)
-				{
-					if(!f.getProps(nodeTile, propStream))
-					{
-						setLastErrorString("Could not read node data.");
-						return false;
-					}
-
-					OTBM_Tile_coords* tileCoord;
-					if(!propStream.getStruct(tileCoord))
-					{
-						setLastErrorString("Could not read tile position.");
-						return false;
-					}
-
-					Tile* tile = NULL;
-					Item* ground = NULL;
-					uint32_t flags = 0;
-
-					uint16_t px = baseX + tileCoord->_x, py = baseY + tileCoord->_y, pz = baseZ;
-					House* house = NULL;
-					if(type == OTBM_HOUSETILE)
-					{
-						uint32_t houseId;
-						if(!propStream.getLong(houseId))
-						{
-							std::stringstream ss;
-							ss << "[x:" << px << ", y:" << py << ", z:" << pz << "] Could not read house id.";
-
-							setLastErrorString(ss.str());
-							return false;
-						}
-
-						house = Houses::getInstance()->getHouse(houseId, true);
-						if(!house)
-						{
-							std::stringstream ss;
-							ss << "[x:" << px << ", y:" << py << ", z:" << pz << "] Could not create house id: " << houseId;
-
-							setLastErrorString(ss.str());
-							return false;
-						}
-
-						tile = new HouseTile(px, py, pz, house);
-						house->addTile(static_cast<HouseTile*>(tile));
-					}
-
-					//read tile attributes
-					uint8_t attribute = 0;
-					while(propStream.getByte(attribute))
-					{
-						switch(attribute)
-						{
-							case OTBM_ATTR_TILE_FLAGS:
-							{
-								uint32_t _flags;
-								if(!propStream.getLong(_flags))
-								{
-									std::stringstream ss;
-									ss << "[x:" << px << ", y:" << py << ", z:" << pz << "] Failed to read tile flags.";
-
-									setLastErrorString(ss.str());
-									return false;
-								}
-
-								if((_flags & TILESTATE_PROTECTIONZONE) == TILESTATE_PROTECTIONZONE)
-									flags |= TILESTATE_PROTECTIONZONE;
-								else if((_flags & TILESTATE_OPTIONALZONE) == TILESTATE_OPTIONALZONE)
-									flags |= TILESTATE_OPTIONALZONE;
-								else if((_flags & TILESTATE_HARDCOREZONE) == TILESTATE_HARDCOREZONE)
-									flags |= TILESTATE_HARDCOREZONE;
-
-								if((_flags & TILESTATE_NOLOGOUT) == TILESTATE_NOLOGOUT)
-									flags |= TILESTATE_NOLOGOUT;
-
-								if((_flags & TILESTATE_REFRESH) == TILESTATE_REFRESH)
-								{
-									if(house)
-										std::clog << "[x:" << px << ", y:" << py << ", z:" << pz << "] House tile flagged as refreshing!";
-
-									flags |= TILESTATE_REFRESH;
-								}
-
-								break;
-							}
-
-							case OTBM_ATTR_ITEM:
-							{
-								Item* item = Item::CreateItem(propStream);
-								if(!item)
-								{
-									std::stringstream ss;
-									ss << "[x:" << px << ", y:" << py << ", z:" << pz << "] Failed to create item.";
-
-									setLastErrorString(ss.str());
-									return false;
-								}
-
-								if(item->getItemCount() <= 0)
-									item->setItemCount(1);
-
-								if(house && item->isMovable())
-								{
-									std::clog << "[Warning - IOMap::loadMap] Movable item in house: " << house->getId()
-										<< ", item type: " << item->getID() << ", at position " << px << "/" << py << "/"
-										<< pz << std::endl;
-
-									delete item;
-									item = NULL;
-								}
-								else if(tile)
-								{
-									tile->__internalAddThing(item);
-									if(item->getDecaying() != DECAYING_TRUE)
-									{
-										item->__startDecaying();
-										item->setLoadedFromMap(true);
-									}
-								}
-								else if(item->isGroundTile())
-								{
-									if(ground)
-									{
-#ifdef __GROUND_CACHE__
-										CacheMap::iterator it = groundCache.find(ground->getID());
-										bool erase = it == groundCache.end();
-										if(!erase)
-										{
-											it->second.second--;
-											erase = it->second.second < 1;
-											if(erase)
-												groundCache.erase(it);
-										}
-
-										if(erase)
-#endif
-											delete ground;
-									}
-
-#ifdef __GROUND_CACHE__
-									const ItemType& tit = Item::items[item->getID()];
-									if(!(item->floorChange() || tit.magicEffect != MAGIC_EFFECT_NONE || !tit.walkStack
-										|| item->canDecay() || item->getActionId() > 0 || item->getUniqueId() > 0
-										|| item->getID() == 293 || item->getID() == 294 || item->getID() == 461
-										|| item->getID() == 468 || item->getID() == 481 || item->getID() == 483
-										|| item->getID() == 670 || item->getID() == 7932 || item->getID() == 8579
-										|| item->getID() == 8714)) //TODO: export to items.xml
-									{
-										CacheMap::iterator it = groundCache.find(item->getID());
-										if(it != groundCache.end())
-										{
-											delete item;
-											item = it->second.first;
-											it->second.second++;
-										}
-										else
-											groundCache[item->getID()] = std::make_pair(item, 1);
-									}
-
-#endif
-									ground = item;
-								}
-								else
-								{
-									tile = createTile(ground, item, px, py, pz);
-									tile->__internalAddThing(item);
-									if(item->getDecaying() != DECAYING_TRUE)
-									{
-										item->__startDecaying();
-										item->setLoadedFromMap(true);
-									}
-								}
-
-								break;
-							}
-
-							default:
-							{
-								std::stringstream ss;
-								ss << "[x:" << px << ", y:" << py << ", z:" << pz << "] Unknown tile attribute.";
-
-								setLastErrorString(ss.str());
-								return false;
-							}
-						}
-					}
-
-					NODE nodeItem = f.getChildNode(nodeTile, type);
-					while(nodeItem)
-					{
-						if(type == OTBM_ITEM)
-						{
-							PropStream propStream;
-							f.getProps(nodeItem, propStream);
-
-							Item* item = Item::CreateItem(propStream);
-							if(!item)
-							{
-								std::stringstream ss;
-								ss << "[x:" << px << ", y:" << py << ", z:" << pz << "] Failed to create item.";
-
-								setLastErrorString(ss.str());
-								return false;
-							}
-
-							if(item->unserializeItemNode(f, nodeItem, propStream))
-							{
-								if(item->getItemCount() <= 0)
-									item->setItemCount(1);
-
-								if(house && item->isMovable())
-								{
-									std::clog << "[Warning - IOMap::loadMap] Movable item in house: "
-										<< house->getId() << ", item type: " << item->getID()
-										<< ", pos " << px << "/" << py << "/" << pz << std::endl;
-
-									delete item;
-									item = NULL;
-								}
-								else if(tile)
-								{
-									tile->__internalAddThing(item);
-									if(item->getDecaying() != DECAYING_TRUE)
-									{
-										item->__startDecaying();
-										item->setLoadedFromMap(true);
-									}
-								}
-								else if(item->isGroundTile())
-								{
-									if(ground)
-									{
-#ifdef __GROUND_CACHE__
-										CacheMap::iterator it = groundCache.find(ground->getID());
-										bool erase = it == groundCache.end();
-										if(!erase)
-										{
-											it->second.second--;
-											erase = it->second.second < 1;
-											if(erase)
-												groundCache.erase(it);
-										}
-
-										if(erase)
-#endif
-											delete ground;
-									}
-
-#ifdef __GROUND_CACHE__
-									const ItemType& tit = Item::items[item->getID()];
-									if(!(item->floorChange() || tit.magicEffect != MAGIC_EFFECT_NONE || !tit.walkStack
-										|| item->canDecay() || item->getActionId() > 0 || item->getUniqueId() > 0
-										|| item->getID() == 293 || item->getID() == 294 || item->getID() == 461
-										|| item->getID() == 468 || item->getID() == 481 || item->getID() == 483
-										|| item->getID() == 670 || item->getID() == 7932 || item->getID() == 8579
-										|| item->getID() == 8714)) //TODO: export to items.xml
-									{
-										CacheMap::iterator it = groundCache.find(item->getID());
-										if(it != groundCache.end())
-										{
-											delete item;
-											item = it->second.first;
-											it->second.second++;
-										}
-										else
-											groundCache[item->getID()] = std::make_pair(item, 1);
-									}
-
-#endif
-									ground = item;
-								}
-								else
-								{
-									tile = createTile(ground, item, px, py, pz);
-									tile->__internalAddThing(item);
-									if(item->getDecaying() != DECAYING_TRUE)
-									{
-										item->__startDecaying();
-										item->setLoadedFromMap(true);
-									}
-								}
-							}
-							else
-							{
-								std::stringstream ss;
-								ss << "[x:" << px << ", y:" << py << ", z:" << pz << "] Failed to load item " << item->getID() << ".";
-								setLastErrorString(ss.str());
-
-								delete item;
-								item = NULL;
-								return false;
-							}
-						}
-						else
-						{
-							std::stringstream ss;
-							ss << "[x:" << px << ", y:" << py << ", z:" << pz << "] Unknown node type.";
-							setLastErrorString(ss.str());
-						}
-
-						nodeItem = f.getNextNode(nodeItem, type);
-					}
-
-					if(!tile)
-						tile = createTile(ground, NULL, px, py, pz);
-
-					tile->setFlag((tileflags_t)flags);
-					map->setTile(px, py, pz, tile);
-				}
-				else
-				{
-					setLastErrorString("Unknown tile node.");
-					return false;
-				}
-
-				nodeTile = f.getNextNode(nodeTile, type);
-			}
-		}
+			areas.push_back(nodeMapData);
 		else if(type == OTBM_TOWNS)
 		{
 			NODE nodeTown = f.getChildNode(nodeMapData, type);
@@ -684,15 +408,353 @@ bool IOMap::loadMap(Map* map, const std::string& identifier)
 		nodeMapData = f.getNextNode(nodeMapData, type);
 	}
 
+	SharedItemMap sharedItems;
+	if(!loadTileAreas(map, f, areas, sharedItems))
+		return false;
+
 #ifdef __GROUND_CACHE__
-	for(CacheMap::iterator it = groundCache.begin(); it != groundCache.end(); ++it)
+	std::clog << "> Shared item types: " << sharedItems.size() << std::endl;
+#endif
+	return true;
+}
+
+bool IOMap::loadTileAreas(Map* map, FileLoader& f, const std::vector<NODE>& nodes, SharedItemMap& sharedItems)
+{
+	MapAreaQueue queue;
+	queue.areas.reserve(nodes.size());
+	for(std::vector<NODE>::const_iterator it = nodes.begin(); it != nodes.end(); ++it)
+		queue.areas.push_back(MapArea(*it));
+
+	uint32_t threads = g_config.getNumber(ConfigManager::MAP_LOAD_THREADS);
+	if(!threads)
+		threads = std::max((uint32_t)1, (uint32_t)boost::thread::hardware_concurrency());
+
+	threads = std::min(threads, (uint32_t)nodes.size());
+	std::clog << "> Decoding " << nodes.size() << " tile areas on " << threads << " thread(s)." << std::endl;
+
+	boost::thread_group workers;
+	for(uint32_t i = 0; i < threads; ++i)
+		workers.create_thread(boost::bind(&IOMap::decodeTileAreas, &queue, &f));
+
+	//areas are merged in file order, so houses, unique ids and the arena come out as if loaded serially
+	bool result = true;
+	for(std::vector<MapArea>::iterator it = queue.areas.begin(); it != queue.areas.end(); ++it)
+	{
+		{
+			boost::mutex::scoped_lock lockClass(queue.lock);
+			while(!it->done)
+				queue.signal.wait(lockClass);
+		}
+
+		if(!it->error.empty())
+		{
+			setLastErrorString(it->error);
+			result = false;
+			break;
+		}
+
+		if(!mergeTileArea(map, *it, sharedItems))
+		{
+			result = false;
+			break;
+		}
+	}
+
+	if(!result)
+	{
+		boost::mutex::scoped_lock lockClass(queue.lock);
+		queue.stop = true;
+	}
+
+	workers.join_all();
+	return result;
+}
+
+void IOMap::decodeTileAreas(MapAreaQueue* queue, const FileLoader* source)
+{
+	FileLoader f(*source);
+	BedItem::setDeferSleepers(true);
+	while(true)
+	{
+		MapArea* area = NULL;
+		{
+			boost::mutex::scoped_lock lockClass(queue->lock);
+			if(queue->stop || queue->next >= queue->areas.size())
+				return;
+
+			area = &queue->areas[queue->next++];
+		}
+
+		ScriptEnviroment::setUniqueQueue(&area->uniqueThings);
+		bool result = decodeTileArea(f, *area);
+		ScriptEnviroment::setUniqueQueue(NULL);
+
+		boost::mutex::scoped_lock lockClass(queue->lock);
+		area->done = true;
+		if(!result) //areas before this one are already claimed, so they still finish
+			queue->stop = true;
+
+		queue->signal.notify_all();
+	}
+}
+
+bool IOMap::decodeTileArea(FileLoader& f, MapArea& area)
+{
+	PropStream propStream;
+	if(!f.getProps(area.node, propStream))
+	{
+		area.error = "Invalid map node.";
+		return false;
+	}
+
+	OTBM_Destination_coords* areaCoord;
+	if(!propStream.getStruct(areaCoord))
 	{
-		//it->second.first->setParent(NULL);
-		g_grounds[it->second.first] = it->second.second;
+		area.error = "Invalid map node.";
+		return false;
 	}
 
-	groundCache.clear();
+	int32_t baseX = areaCoord->_x, baseY = areaCoord->_y, baseZ = areaCoord->_z;
+	uint32_t type = 0;
+
+	NODE nodeTile = f.getChildNode(area.node, type);
+	while(nodeTile != NO_NODE)
+	{
+		if(f.getError() != ERROR_NONE)
+		{
+			area.error = "Could not read node data.";
+			return false;
+		}
+
+		if(type != OTBM_TILE && type != OTBM_HOUSETILE)
+		{
+			area.error = "Unknown tile node.";
+			return false;
+		}
+
+		if(!f.getProps(nodeTile, propStream))
+		{
+			area.error = "Could not read node data.";
+			return false;
+		}
+
+		OTBM_Tile_coords* tileCoord;
+		if(!propStream.getStruct(tileCoord))
+		{
+			area.error = "Could not read tile position.";
+			return false;
+		}
+
+		MapTile tile;
+		tile.x = baseX + tileCoord->_x;
+		tile.y = baseY + tileCoord->_y;
+		tile.z = baseZ;
+
+		tile.houseId = tile.flags = 0;
+		tile.firstItem = area.items.size();
+		tile.itemCount = 0;
+
+		tile.isHouse = type == OTBM_HOUSETILE;
+		if(tile.isHouse && !propStream.getLong(tile.houseId))
+		{
+			area.error = getTileError(tile.x, tile.y, tile.z, "Could not read house id.");
+			return false;
+		}
+
+		//read tile attributes
+		uint8_t attribute = 0;
+		while(propStream.getByte(attribute))
+		{
+			switch(attribute)
+			{
+				case OTBM_ATTR_TILE_FLAGS:
+				{
+					uint32_t _flags;
+					if(!propStream.getLong(_flags))
+					{
+						area.error = getTileError(tile.x, tile.y, tile.z, "Failed to read tile flags.");
+						return false;
+					}
+
+					if((_flags & TILESTATE_PROTECTIONZONE) == TILESTATE_PROTECTIONZONE)
+						tile.flags |= TILESTATE_PROTECTIONZONE;
+					else if((_flags & TILESTATE_OPTIONALZONE) == TILESTATE_OPTIONALZONE)
+						tile.flags |= TILESTATE_OPTIONALZONE;
+					else if((_flags & TILESTATE_HARDCOREZONE) == TILESTATE_HARDCOREZONE)
+						tile.flags |= TILESTATE_HARDCOREZONE;
+
+					if((_flags & TILESTATE_NOLOGOUT) == TILESTATE_NOLOGOUT)
+						tile.flags |= TILESTATE_NOLOGOUT;
+
+					if((_flags & TILESTATE_REFRESH) == TILESTATE_REFRESH)
+						tile.flags |= TILESTATE_REFRESH;
+
+					break;
+				}
+
+				case OTBM_ATTR_ITEM:
+				{
+					Item* item = Item::CreateItem(propStream);
+					if(!item)
+					{
+						area.error = getTileError(tile.x, tile.y, tile.z, "Failed to create item.");
+						return false;
+					}
+
+					if(item->getItemCount() <= 0)
+						item->setItemCount(1);
+
+					area.items.push_back(item);
+					break;
+				}
+
+				default:
+				{
+					area.error = getTileError(tile.x, tile.y, tile.z, "Unknown tile attribute.");
+					return false;
+				}
+			}
+		}
+
+		NODE nodeItem = f.getChildNode(nodeTile, type);
+		while(nodeItem)
+		{
+			if(type == OTBM_ITEM)
+			{
+				PropStream propStream;
+				f.getProps(nodeItem, propStream);
+
+				Item* item = Item::CreateItem(propStream);
+				if(!item)
+				{
+					area.error = getTileError(tile.x, tile.y, tile.z, "Failed to create item.");
+					return false;
+				}
+
+				if(!item->unserializeItemNode(f, nodeItem, propStream))
+				{
+					std::stringstream ss;
+					ss << "Failed to load item " << item->getID() << ".";
+					area.error = getTileError(tile.x, tile.y, tile.z, ss.str());
+
+					delete item;
+					return false;
+				}
+
+				if(item->getItemCount() <= 0)
+					item->setItemCount(1);
+
+				area.items.push_back(item);
+			}
+
+			nodeItem = f.getNextNode(nodeItem, type);
+		}
+
+		tile.itemCount = area.items.size() - tile.firstItem;
+		area.tiles.push_back(tile);
+		nodeTile = f.getNextNode(nodeTile, type);
+	}
+
+	if(f.getError() != ERROR_NONE)
+	{
+		area.error = "Could not read node data.";
+		return false;
+	}
+
+	return true;
+}
+
+bool IOMap::mergeTileArea(Map* map, MapArea& area, SharedItemMap&
+#ifdef __GROUND_CACHE__
+	sharedItems
 #endif
+	)
+{
+	for(std::vector<Thing*>::iterator it = area.uniqueThings.begin(); it != area.uniqueThings.end(); ++it)
+		ScriptEnviroment::addUniqueThing(*it);
+
+	for(std::vector<MapTile>::iterator it = area.tiles.begin(); it != area.tiles.end(); ++it)
+	{
+		Tile* tile = NULL;
+		Item* ground = NULL;
+
+		House* house = NULL;
+		if(it->isHouse)
+		{
+			if(!(house = Houses::getInstance()->getHouse(it->houseId, true)))
+			{
+				std::stringstream ss;
+				ss << "Could not create house id: " << it->houseId;
+
+				setLastErrorString(getTileError(it->x, it->y, it->z, ss.str()));
+				return false;
+			}
+
+			tile = new(allocateTile(map, it->x, it->y, sizeof(HouseTile))) HouseTile(it->x, it->y, it->z, house);
+			house->addTile(static_cast<HouseTile*>(tile));
+			if((it->flags & TILESTATE_REFRESH) == TILESTATE_REFRESH)
+				std::clog << "[x:" << it->x << ", y:" << it->y << ", z:" << it->z << "] House tile flagged as refreshing!";
+		}
+
+		for(uint32_t i = it->firstItem; i < it->firstItem + it->itemCount; ++i)
+		{
+			Item* item = area.items[i];
+#ifdef __GROUND_CACHE__
+			//refreshing removes and re-adds the down items, they must stay on their own
+			if((it->flags & TILESTATE_REFRESH) != TILESTATE_REFRESH)
+				item = shareItem(sharedItems, item);
+#endif
+			if(house && item->isMovable())
+			{
+				std::clog << "[Warning - IOMap::loadMap] Movable item in house: " << house->getId()
+					<< ", item type: " << item->getID() << ", at position " << it->x << "/" << it->y << "/"
+					<< it->z << std::endl;
+
+				delete item;
+				item = NULL;
+			}
+			else if(tile)
+			{
+				tile->__internalAddThing(item);
+				if(item->getDecaying() != DECAYING_TRUE)
+				{
+					item->__startDecaying();
+					item->setLoadedFromMap(true);
+				}
+			}
+			else if(item->isGroundTile())
+			{
+				if(ground && !ground->isShared())
+					delete ground;
+
+				ground = item;
+			}
+			else
+			{
+				tile = createTile(ground, item, it->x, it->y, it->z, map);
+				tile->__internalAddThing(item);
+				if(item->getDecaying() != DECAYING_TRUE)
+				{
+					item->__startDecaying();
+					item->setLoadedFromMap(true);
+				}
+			}
+
+			if(item && item->getBed()) //deferred by the decode thread
+				item->getBed()->loadSleeper();
+		}
+
+		if(!tile)
+			tile = createTile(ground, NULL, it->x, it->y, it->z, map);
+
+		tile->setFlag((tileflags_t)it->flags);
+		map->setTile(it->x, it->y, it->z, tile);
+	}
+
+	//release the decode buffers as soon as the area is in place
+	std::vector<MapTile>().swap(area.tiles);
+	ItemVector().swap(area.items);
+	std::vector<Thing*>().swap(area.uniqueThings);
 	return true;
 }
 
@@ -99,13 +99,16 @@ struct OTBM_HouseTile_coords
 };
 #pragma pack()
 
+struct MapArea;
+struct MapAreaQueue;
+
 class IOMap
 {
 	public:
 		IOMap() {}
 		virtual ~IOMap() {}
 
-		static Tile* createTile(Item*& ground, Item* item, uint16_t px, uint16_t py, uint16_t pz);
+		static Tile* createTile(Item*& ground, Item* item, uint16_t px, uint16_t py, uint16_t pz, Map* map = NULL);
 		bool loadMap(Map* map, const std::string& identifier);
 
 		/* Load the spawns
@@ -124,6 +127,19 @@ class IOMap
 		void setLastErrorString(const std::string& _errorString) {errorString = _errorString;}
 
 	protected:
+		static void* allocateTile(Map* map, uint16_t px, uint16_t py, size_t bytes);
+
+		typedef std::map<uint16_t, Item*> SharedItemMap;
+#ifdef __GROUND_CACHE__
+		static Item* shareItem(SharedItemMap& sharedItems, Item* item);
+#endif
+
+		bool loadTileAreas(Map* map, FileLoader& f, const std::vector<NODE>& nodes, SharedItemMap& sharedItems);
+		bool mergeTileArea(Map* map, MapArea& area, SharedItemMap& sharedItems);
+
+		static void decodeTileAreas(MapAreaQueue* queue, const FileLoader* source);
+		static bool decodeTileArea(FileLoader& f, MapArea& area);
+
 		std::string errorString;
 };
 #endif
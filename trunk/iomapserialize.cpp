@@ -26,6 +26,20 @@
 extern ConfigManager g_config;
 extern Game g_game;
 
+static std::string getHouseIds(const HouseVector& houses)
+{
+	std::stringstream ss;
+	for(HouseVector::const_iterator it = houses.begin(); it != houses.end(); ++it)
+	{
+		if(it != houses.begin())
+			ss << ", ";
+
+		ss << (*it)->getId();
+	}
+
+	return ss.str();
+}
+
 bool IOMapSerialize::loadMap(Map* map)
 {
 	std::string config = asLowerCaseString(g_config.getString(ConfigManager::HOUSE_STORAGE));
@@ -43,6 +57,10 @@ bool IOMapSerialize::loadMap(Map* map)
 	for(HouseMap::iterator it = Houses::getInstance()->getHouseBegin();
 		it != Houses::getInstance()->getHouseEnd(); ++it)
 	{
+		//stored rows match the tiles now, unless the items went to the owner's depot instead
+		if(!it->second->hasPendingTransfer())
+			it->second->resetSyncFlag(House::HOUSE_SYNC_ITEMS);
+
 		if(!it->second->hasSyncFlag(House::HOUSE_SYNC_UPDATE))
 			continue;
 
@@ -52,15 +70,42 @@ bool IOMapSerialize::loadMap(Map* map)
 	return true;
 }
 
-bool IOMapSerialize::saveMap(Map* map)
+bool IOMapSerialize::saveMap(Map*)
 {
-	std::string config = asLowerCaseString(g_config.getString(ConfigManager::HOUSE_STORAGE));
-	if(config == "binary-tilebased")
-		return saveMapBinaryTileBased(map);
-	else if(config == "binary")
-		return saveMapBinary(map);
+	//houses are marked whenever their items change, a full save every few rounds catches anything missed
+	uint32_t interval = g_config.getNumber(ConfigManager::HOUSE_FULL_SAVE_INTERVAL), total = 0;
+	bool full = interval && !((m_saves + 1) % interval);
+
+	HouseVector houses;
+	for(HouseMap::iterator it = Houses::getInstance()->getHouseBegin(); it != Houses::getInstance()->getHouseEnd(); ++it, ++total)
+	{
+		if(full || it->second->hasSyncFlag(House::HOUSE_SYNC_ITEMS))
+			houses.push_back(it->second);
+	}
+
+	m_savedRows = m_savedBytes = 0;
+	if(full || !houses.empty())
+	{
+		bool result = false;
+		std::string config = asLowerCaseString(g_config.getString(ConfigManager::HOUSE_STORAGE));
+		if(config == "binary-tilebased")
+			result = saveMapBinaryTileBased(houses, full);
+		else if(config == "binary")
+			result = saveMapBinary(houses, full);
+		else
+			result = saveMapRelational(houses, full);
 
-	return saveMapRelational(map);
+		if(!result)
+			return false;
+	}
+
+	for(HouseVector::iterator it = houses.begin(); it != houses.end(); ++it)
+		(*it)->resetSyncFlag(House::HOUSE_SYNC_ITEMS);
+
+	++m_saves;
+	std::clog << "> Saved " << houses.size() << " of " << total << " houses (" << (full ? "full" : "incremental")
+		<< "), " << m_savedRows << " rows, " << m_savedBytes << " bytes." << std::endl;
+	return true;
 }
 
 bool IOMapSerialize::updateAuctions()
@@ -227,18 +272,20 @@ bool IOMapSerialize::saveHouses()
 
 bool IOMapSerialize::saveHouse(Database* db, House* house)
 {
+	if(!Database::getRecorder())
+		g_game.cancelSave(SAVEUNIT_HOUSES);
+
 	DBQuery query;
-	query << "UPDATE `houses` SET `owner` = " << house->getOwner() << ", `paid` = "
-		<< house->getPaidUntil() << ", `warnings` = " << house->getRentWarnings() << ", `lastwarning` = "
-		<< house->getLastWarning() << ", `clear` = 0 WHERE `id` = " << house->getId() << " AND `world_id` = "
-		<< g_config.getNumber(ConfigManager::WORLD_ID) << db->getUpdateLimiter();
-	if(!db->query(query.str()))
+	DBStatement update(db, "UPDATE `houses` SET `owner` = ?, `paid` = ?, `warnings` = ?, `lastwarning` = ?, `clear` = 0"
+		" WHERE `id` = ? AND `world_id` = ?" + db->getUpdateLimiter());
+	update.bindInt(house->getOwner()).bindInt(house->getPaidUntil()).bindInt(house->getRentWarnings())
+		.bindInt(house->getLastWarning()).bindInt(house->getId()).bindInt(g_config.getNumber(ConfigManager::WORLD_ID));
+	if(!update.execute())
 		return false;
 
-	query.str("");
-	query << "DELETE FROM `house_lists` WHERE `house_id` = " << house->getId() << " AND `world_id` = "
-		<< g_config.getNumber(ConfigManager::WORLD_ID);
-	if(!db->query(query.str()))
+	DBStatement clear(db, "DELETE FROM `house_lists` WHERE `house_id` = ? AND `world_id` = ?");
+	clear.bindInt(house->getId()).bindInt(g_config.getNumber(ConfigManager::WORLD_ID));
+	if(!clear.execute())
 		return false;
 
 	DBInsert queryInsert(db);
@@ -377,7 +424,7 @@ bool IOMapSerialize::loadMapRelational(Map* map)
 	return true;
 }
 
-bool IOMapSerialize::saveMapRelational(Map*)
+bool IOMapSerialize::saveMapRelational(const HouseVector& houses, bool full)
 {
 	Database* db = Database::getInstance();
 	//Start the transaction
@@ -387,21 +434,46 @@ bool IOMapSerialize::saveMapRelational(Map*)
 
 	//clear old tile data
 	DBQuery query;
-	query << "DELETE FROM `tile_items` WHERE `world_id` = " << g_config.getNumber(ConfigManager::WORLD_ID);
-	if(!db->query(query.str()))
-		return false;
+	uint32_t tileId = 0;
+	if(full)
+	{
+		query << "DELETE FROM `tile_items` WHERE `world_id` = " << g_config.getNumber(ConfigManager::WORLD_ID);
+		if(!db->query(query.str()))
+			return false;
 
-	query.str("");
-	query << "DELETE FROM `tiles` WHERE `world_id` = " << g_config.getNumber(ConfigManager::WORLD_ID);
-	if(!db->query(query.str()))
-		return false;
+		query.str("");
+		query << "DELETE FROM `tiles` WHERE `world_id` = " << g_config.getNumber(ConfigManager::WORLD_ID);
+		if(!db->query(query.str()))
+			return false;
+	}
+	else
+	{
+		query << "SELECT MAX(`id`) AS `id` FROM `tiles` WHERE `world_id` = " << g_config.getNumber(ConfigManager::WORLD_ID);
+		if(DBResult* result = db->storeQuery(query.str()))
+		{
+			tileId = result->getDataInt("id") + 1;
+			result->free();
+		}
 
-	uint32_t tileId = 0;
-	for(HouseMap::iterator it = Houses::getInstance()->getHouseBegin(); it != Houses::getInstance()->getHouseEnd(); ++it)
+		query.str("");
+		query << "DELETE FROM `tile_items` WHERE `world_id` = " << g_config.getNumber(ConfigManager::WORLD_ID)
+			<< " AND `tile_id` IN (SELECT `id` FROM `tiles` WHERE `world_id` = " << g_config.getNumber(ConfigManager::WORLD_ID)
+			<< " AND `house_id` IN (" << getHouseIds(houses) << "))";
+		if(!db->query(query.str()))
+			return false;
+
+		query.str("");
+		query << "DELETE FROM `tiles` WHERE `world_id` = " << g_config.getNumber(ConfigManager::WORLD_ID)
+			<< " AND `house_id` IN (" << getHouseIds(houses) << ")";
+		if(!db->query(query.str()))
+			return false;
+	}
+
+	for(HouseVector::const_iterator it = houses.begin(); it != houses.end(); ++it)
 	{
 		//save house items
-		for(HouseTileList::iterator tit = it->second->getHouseTileBegin(); tit != it->second->getHouseTileEnd(); ++tit)
-			saveItems(db, tileId, it->second->getId(), (*tit));
+		for(HouseTileList::iterator tit = (*it)->getHouseTileBegin(); tit != (*it)->getHouseTileEnd(); ++tit)
+			saveItems(db, tileId, (*it)->getId(), (*tit));
 	}
 
 	//End the transaction
@@ -475,7 +547,7 @@ bool IOMapSerialize::loadMapBinary(Map* map)
  	return true;
 }
 
-bool IOMapSerialize::saveMapBinary(Map*)
+bool IOMapSerialize::saveMapBinary(const HouseVector& houses, bool full)
 {
  	Database* db = Database::getInstance();
 	//Start the transaction
@@ -485,16 +557,20 @@ bool IOMapSerialize::saveMapBinary(Map*)
 
 	DBQuery query;
 	query << "DELETE FROM `house_data` WHERE `world_id` = " << g_config.getNumber(ConfigManager::WORLD_ID);
+	if(!full)
+		query << " AND `house_id` IN (" << getHouseIds(houses) << ")";
+
 	if(!db->query(query.str()))
  		return false;
 
+	DBParams row;
 	DBInsert stmt(db);
 	stmt.setQuery("INSERT INTO `house_data` (`house_id`, `world_id`, `data`) VALUES ");
- 	for(HouseMap::iterator it = Houses::getInstance()->getHouseBegin(); it != Houses::getInstance()->getHouseEnd(); ++it)
+ 	for(HouseVector::const_iterator it = houses.begin(); it != houses.end(); ++it)
 	{
  		//save house items
 		PropWriteStream stream;
-		for(HouseTileList::iterator tit = it->second->getHouseTileBegin(); tit != it->second->getHouseTileEnd(); ++tit)
+		for(HouseTileList::iterator tit = (*it)->getHouseTileBegin(); tit != (*it)->getHouseTileEnd(); ++tit)
 		{
 			if(!saveTile(stream, *tit))
  				return false;
@@ -502,12 +578,13 @@ bool IOMapSerialize::saveMapBinary(Map*)
 
 		uint32_t attributesSize = 0;
 		const char* attributes = stream.getStream(attributesSize);
-		query.str("");
 
-		query << it->second->getId() << ", " << g_config.getNumber(ConfigManager::WORLD_ID)
-			<< ", " << db->escapeBlob(attributes, attributesSize);
-		if(!stmt.addRow(query))
+		row.bindInt((*it)->getId()).bindInt(g_config.getNumber(ConfigManager::WORLD_ID)).bindBlob(attributes, attributesSize);
+		if(!stmt.addRow(row))
 			return false;
+
+		++m_savedRows;
+		m_savedBytes += attributesSize;
  	}
 
 	query.str("");
@@ -585,7 +662,7 @@ bool IOMapSerialize::loadMapBinaryTileBased(Map* map)
  	return true;
 }
 
-bool IOMapSerialize::saveMapBinaryTileBased(Map*)
+bool IOMapSerialize::saveMapBinaryTileBased(const HouseVector& houses, bool full)
 {
  	Database* db = Database::getInstance();
 	//Start the transaction
@@ -595,15 +672,19 @@ bool IOMapSerialize::saveMapBinaryTileBased(Map*)
 
 	DBQuery query;
 	query << "DELETE FROM `tile_store` WHERE `world_id` = " << g_config.getNumber(ConfigManager::WORLD_ID);
+	if(!full)
+		query << " AND `house_id` IN (" << getHouseIds(houses) << ")";
+
 	if(!db->query(query.str()))
  		return false;
 
+	DBParams row;
 	DBInsert stmt(db);
 	stmt.setQuery("INSERT INTO `tile_store` (`house_id`, `world_id`, `data`) VALUES ");
- 	for(HouseMap::iterator it = Houses::getInstance()->getHouseBegin(); it != Houses::getInstance()->getHouseEnd(); ++it)
+ 	for(HouseVector::const_iterator it = houses.begin(); it != houses.end(); ++it)
 	{
  		//save house items
-		House* house = it->second;
+		House* house = *it;
 		for(HouseTileList::iterator tit = house->getHouseTileBegin(); tit != house->getHouseTileEnd(); ++tit)
 		{
 			PropWriteStream stream;
@@ -612,14 +693,14 @@ bool IOMapSerialize::saveMapBinaryTileBased(Map*)
 			uint32_t attributesSize = 0;
 			const char* attributes = stream.getStream(attributesSize);
 
-			query.str("");
 			if(attributesSize > 0)
 			{
-				query << it->second->getId() << ", " << g_config.getNumber(ConfigManager::WORLD_ID)
-					<< ", " << db->escapeBlob(attributes, attributesSize);
-
-				if(!stmt.addRow(query))
+				row.bindInt(house->getId()).bindInt(g_config.getNumber(ConfigManager::WORLD_ID)).bindBlob(attributes, attributesSize);
+				if(!stmt.addRow(row))
 					return false;
+
+				++m_savedRows;
+				m_savedBytes += attributesSize;
 			}
  		}
  	}
@@ -759,6 +840,7 @@ bool IOMapSerialize::saveItems(Database* db, uint32_t& tileId, uint32_t houseId,
 	ContainerStackList containerStackList;
 
 	bool stored = false;
+	DBParams row;
 	DBInsert query_insert(db);
 	query_insert.setQuery("INSERT INTO `tile_items` (`tile_id`, `world_id`, `sid`, `pid`, `itemtype`, `count`, `attributes`) VALUES ");
 
@@ -778,6 +860,7 @@ bool IOMapSerialize::saveItems(Database* db, uint32_t& tileId, uint32_t houseId,
 				return false;
 
 			stored = true;
+			++m_savedRows;
 			query.str("");
 		}
 
@@ -787,12 +870,13 @@ bool IOMapSerialize::saveItems(Database* db, uint32_t& tileId, uint32_t houseId,
 		uint32_t attributesSize = 0;
 		const char* attributes = propWriteStream.getStream(attributesSize);
 
-		query << tileId << ", " << g_config.getNumber(ConfigManager::WORLD_ID) << ", " << ++runningId << ", " << parentId << ", "
-			<< item->getID() << ", " << (int32_t)item->getSubType() << ", " << db->escapeBlob(attributes, attributesSize);
-		if(!query_insert.addRow(query.str()))
+		row.bindInt(tileId).bindInt(g_config.getNumber(ConfigManager::WORLD_ID)).bindInt(++runningId).bindInt(parentId)
+			.bindInt(item->getID()).bindInt(item->getSubType()).bindBlob(attributes, attributesSize);
+		if(!query_insert.addRow(row))
 			return false;
 
-		query.str("");
+		++m_savedRows;
+		m_savedBytes += attributesSize;
 		if(item->getContainer())
 			containerStackList.push_back(std::make_pair(item->getContainer(), runningId));
 	}
@@ -813,12 +897,13 @@ bool IOMapSerialize::saveItems(Database* db, uint32_t& tileId, uint32_t houseId,
 			uint32_t attributesSize = 0;
 			const char* attributes = propWriteStream.getStream(attributesSize);
 
-			query << tileId << ", " << g_config.getNumber(ConfigManager::WORLD_ID) << ", " << ++runningId << ", " << parentId << ", "
-				<< item->getID() << ", " << (int32_t)item->getSubType() << ", " << db->escapeBlob(attributes, attributesSize);
-			if(!query_insert.addRow(query.str()))
+			row.bindInt(tileId).bindInt(g_config.getNumber(ConfigManager::WORLD_ID)).bindInt(++runningId).bindInt(parentId)
+				.bindInt(item->getID()).bindInt(item->getSubType()).bindBlob(attributes, attributesSize);
+			if(!query_insert.addRow(row))
 				return false;
 
-			query.str("");
+			++m_savedRows;
+			m_savedBytes += attributesSize;
 			if(item->getContainer())
 				containerStackList.push_back(std::make_pair(item->getContainer(), runningId));
 		}
@@ -26,6 +26,8 @@ typedef std::map<int32_t, std::pair<Item*, int32_t> > ItemMap;
 typedef std::list<std::pair<Container*, int32_t> > ContainerStackList;
 
 class House;
+typedef std::vector<House*> HouseVector;
+
 class IOMapSerialize
 {
 	public:
@@ -48,19 +50,19 @@ class IOMapSerialize
 		bool saveHouse(Database* db, House* house);
 
 	protected:
-		IOMapSerialize() {}
+		IOMapSerialize(): m_saves(0), m_savedRows(0), m_savedBytes(0) {}
 
 		// Relational storage uses a row for each item/tile
 		bool loadMapRelational(Map* map);
-		bool saveMapRelational(Map* map);
+		bool saveMapRelational(const HouseVector& houses, bool full);
 
 		// Binary storage uses a giant BLOB field for storing everything
 		bool loadMapBinary(Map* map);
-		bool saveMapBinary(Map* map);
+		bool saveMapBinary(const HouseVector& houses, bool full);
 
 		// Binary-tilebased storage uses a BLOB field for each tile in houses, so that corrupt blobs will only wipe tiles instead of entire houses
 		bool loadMapBinaryTileBased(Map* map);
-		bool saveMapBinaryTileBased(Map* map);
+		bool saveMapBinaryTileBased(const HouseVector& houses, bool full);
 
 		bool loadItems(Database* db, DBResult* result, Cylinder* parent, bool depotTransfer);
 		bool saveItems(Database* db, uint32_t& tileId, uint32_t houseId, const Tile* tile);
@@ -70,5 +72,8 @@ class IOMapSerialize
 
 		bool saveTile(PropWriteStream& stream, const Tile* tile);
 		bool saveItem(PropWriteStream& stream, const Item* item);
+
+		uint32_t m_saves;
+		uint64_t m_savedRows, m_savedBytes;
 };
 #endif
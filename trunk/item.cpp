@@ -178,7 +178,7 @@ Item::Item(const uint16_t type, uint16_t amount/* = 0*/):
 	ItemAttributes(), id(type)
 {
 	raid = NULL;
-	loadedFromMap = false;
+	loadedFromMap = shared = false;
 
 	setItemCount(1);
 	setDefaultDuration();
@@ -1668,6 +1668,19 @@ bool Item::canDecay()
 	return it.decayTo >= 0 && it.decayTime;
 }
 
+bool Item::isShareable() const
+{
+	if(attributes && !attributes->empty())
+		return false;
+
+	const ItemType& it = Item::items[id];
+	if(it.group == ITEM_GROUP_CONTAINER || it.type != ITEM_TYPE_NONE || it.movable || it.pickupable
+		|| it.hasSubType() || it.forceSerialize || it.canWriteText || (it.decayTo >= 0 && it.decayTime))
+		return false;
+
+	return !floorChange() && it.magicEffect == MAGIC_EFFECT_NONE && it.walkStack;
+}
+
 void Item::getLight(LightInfo& lightInfo)
 {
 	const ItemType& it = items[id];
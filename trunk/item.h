@@ -147,7 +147,8 @@ class Item : virtual public Thing, public ItemAttributes
 
 		// Constructor for items
 		Item(const uint16_t type, uint16_t amount = 0);
-		Item(const Item &i): Thing(), ItemAttributes(i), id(i.id), count(i.count) {}
+		Item(const Item &i): Thing(), ItemAttributes(i), id(i.id), count(i.count),
+			raid(NULL), loadedFromMap(false), shared(false) {}
 		virtual ~Item() {}
 
 		virtual Item* clone() const;
@@ -312,6 +313,10 @@ class Item : virtual public Thing, public ItemAttributes
 		bool isLoadedFromMap() const {return loadedFromMap;}
 		void setLoadedFromMap(bool value) {loadedFromMap = value;}
 
+		bool isShared() const {return shared;}
+		void setShared(bool value) {shared = value;}
+		bool isShareable() const;
+
 		uint16_t getItemCount() const {return count;}
 		void setItemCount(uint16_t n) {count = n;}
 
@@ -342,7 +347,7 @@ class Item : virtual public Thing, public ItemAttributes
 		uint8_t count;
 
 		Raid* raid;
-		bool loadedFromMap;
+		bool loadedFromMap, shared;
 };
 
 inline std::string Item::getName() const
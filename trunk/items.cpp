@@ -136,7 +136,7 @@ bool Items::reload()
 int32_t Items::loadFromOtb(std::string file)
 {
 	FileLoader f;
-	if(!f.openFile(file.c_str(), false, true))
+	if(!f.openFile(file.c_str(), false))
 		return f.getError();
 
 	uint32_t type;
@@ -362,6 +362,24 @@ int32_t Items::loadFromOtb(std::string file)
 }
 
 bool Items::loadFromXml()
+{
+	uint64_t key = 0;
+	bool cache = getCacheKey(key);
+	if(cache && loadCache(key))
+		return true;
+
+	int64_t start = OTSYS_TIME();
+	if(!parseXml())
+		return false;
+
+	std::clog << "> Items parsed from XML in " << (OTSYS_TIME() - start) << " ms." << std::endl;
+	if(cache)
+		saveCache(key);
+
+	return true;
+}
+
+bool Items::parseXml()
 {
 	xmlDocPtr doc = xmlParseFile(getFilePath(FILE_TYPE_OTHER, "items/items.xml").c_str());
 	if(!doc)
@@ -1831,6 +1849,278 @@ void Items::parseItemNode(xmlNodePtr itemNode, uint32_t id)
 	}
 }
 
+// The compiled cache holds the item types as they are after items.otb,
+// items.xml and randomization.xml were applied, so it is only trusted while
+// the hashes of those three files (and the layout version) match.
+class ItemCacheWriter
+{
+	public:
+		template<typename T>
+		bool operator()(T& value)
+		{
+			buffer.append((const char*)&value, sizeof(T));
+			return true;
+		}
+
+		bool operator()(std::string& value)
+		{
+			uint32_t size = value.size();
+			(*this)(size);
+			buffer.append(value);
+			return true;
+		}
+
+		std::string buffer;
+};
+
+class ItemCacheReader
+{
+	public:
+		ItemCacheReader(const char* data, uint32_t size) {stream.init(data, size);}
+
+		template<typename T>
+		bool operator()(T& value)
+		{
+			T* tmp = NULL;
+			if(!stream.getStruct(tmp))
+				return false;
+
+			memcpy(&value, tmp, sizeof(T));
+			return true;
+		}
+
+		bool operator()(std::string& value) {return stream.getLongString(value);}
+		PropStream& getStream() {return stream;}
+
+	protected:
+		PropStream stream;
+};
+
+template<class Archive>
+static bool cacheItemType(Archive& ar, ItemType& it)
+{
+	return ar(it.stopTime) && ar(it.showCount) && ar(it.stackable) && ar(it.showDuration) && ar(it.showCharges)
+		&& ar(it.showAttributes) && ar(it.dualWield) && ar(it.allowDistRead) && ar(it.canReadText)
+		&& ar(it.canWriteText) && ar(it.forceSerialize) && ar(it.isVertical) && ar(it.isHorizontal)
+		&& ar(it.isHangable) && ar(it.usable) && ar(it.movable) && ar(it.pickupable) && ar(it.rotable)
+		&& ar(it.replacable) && ar(it.lookThrough) && ar(it.walkStack) && ar(it.hasHeight) && ar(it.blockSolid)
+		&& ar(it.blockPickupable) && ar(it.blockProjectile) && ar(it.blockPathFind) && ar(it.allowPickupable)
+		&& ar(it.alwaysOnTop) && ar(it.floorChange) && ar(it.magicEffect) && ar(it.fluidSource)
+		&& ar(it.weaponType) && ar(it.bedPartnerDir) && ar(it.ammoAction) && ar(it.combatType)
+		&& ar(it.corpseType) && ar(it.shootType) && ar(it.ammoType) && ar(it.transformUseTo)
+		&& ar(it.transformToFree) && ar(it.transformEquipTo) && ar(it.transformDeEquipTo) && ar(it.clientId)
+		&& ar(it.maxItems) && ar(it.slotPosition) && ar(it.wieldPosition) && ar(it.speed) && ar(it.maxTextLength)
+		&& ar(it.writeOnceItemId) && ar(it.attack) && ar(it.extraAttack) && ar(it.defense) && ar(it.extraDefense)
+		&& ar(it.armor) && ar(it.breakChance) && ar(it.hitChance) && ar(it.maxHitChance) && ar(it.runeLevel)
+		&& ar(it.runeMagLevel) && ar(it.lightLevel) && ar(it.lightColor) && ar(it.decayTo) && ar(it.rotateTo)
+		&& ar(it.alwaysOnTopOrder) && ar(it.shootRange) && ar(it.charges) && ar(it.decayTime) && ar(it.attackSpeed)
+		&& ar(it.wieldInfo) && ar(it.minReqLevel) && ar(it.minReqMagicLevel) && ar(it.worth) && ar(it.levelDoor)
+		&& ar(it.date) && ar(it.name) && ar(it.pluralName) && ar(it.article) && ar(it.description) && ar(it.text)
+		&& ar(it.writer) && ar(it.runeSpellName) && ar(it.vocationString) && ar(it.abilities) && ar(it.group)
+		&& ar(it.type) && ar(it.weight);
+}
+
+static void hashData(const char* data, size_t size, uint64_t& hash)
+{
+	for(size_t i = 0; i < size; ++i) // FNV-1a
+		hash = (hash ^ (uint8_t)data[i]) * 0x100000001B3ULL;
+}
+
+static bool hashFile(const std::string& file, uint64_t& hash)
+{
+	FILE* f = fopen(file.c_str(), "rb");
+	if(!f)
+		return false;
+
+	char buffer[16384];
+	size_t size;
+	while((size = fread(buffer, 1, sizeof(buffer), f)) > 0)
+		hashData(buffer, size, hash);
+
+	fclose(f);
+	return true;
+}
+
+bool Items::getCacheKey(uint64_t& key) const
+{
+	key = 0xCBF29CE484222325ULL ^ (ITEMS_CACHE_VERSION | ((uint64_t)sizeof(Abilities) << 16));
+	return hashFile(getFilePath(FILE_TYPE_OTHER, "items/items.otb"), key)
+		&& hashFile(getFilePath(FILE_TYPE_OTHER, "items/items.xml"), key)
+		&& hashFile(getFilePath(FILE_TYPE_OTHER, "items/randomization.xml"), key);
+}
+
+bool Items::loadCache(uint64_t key)
+{
+	FILE* f = fopen(getFilePath(FILE_TYPE_OTHER, "items/items.cache").c_str(), "rb");
+	if(!f)
+		return false;
+
+	int64_t start = OTSYS_TIME();
+	std::vector<char> data;
+
+	char buffer[16384];
+	size_t size;
+	while((size = fread(buffer, 1, sizeof(buffer), f)) > 0)
+		data.insert(data.end(), buffer, buffer + size);
+
+	fclose(f);
+	if(data.size() <= 2 * sizeof(uint64_t))
+		return false;
+
+	//check the whole payload before touching any item type
+	ItemCacheReader reader(&data[0], data.size());
+	uint64_t cacheKey = 0, checksum = 0, hash = 0xCBF29CE484222325ULL;
+	hashData(&data[2 * sizeof(uint64_t)], data.size() - 2 * sizeof(uint64_t), hash);
+
+	uint32_t count = 0;
+	if(!reader(cacheKey) || cacheKey != key || !reader(checksum) || checksum != hash
+		|| !reader(m_randomizationChance) || !reader(count))
+		return false;
+
+	for(uint32_t i = 0; i < count; ++i)
+	{
+		uint16_t id = 0;
+		if(!reader(id))
+			return false;
+
+		ItemType* iType = items.getElement(id);
+		if(!iType)
+		{
+			iType = new ItemType();
+			iType->id = id;
+			items.addElement(iType, id);
+		}
+
+		uint8_t hasCondition = 0;
+		if(!cacheItemType(reader, *iType) || !reader(hasCondition))
+			return false;
+
+		delete iType->condition;
+		iType->condition = NULL;
+		if(!hasCondition)
+			continue;
+
+		//the condition comes from a field, which is the only way items.xml adds one
+		Condition* condition = Condition::createCondition(reader.getStream());
+		if(!condition || !condition->unserialize(reader.getStream()))
+		{
+			delete condition;
+			return false;
+		}
+
+		condition->setParam(CONDITIONPARAM_FIELD, true);
+		if(ConditionDamage* conditionDamage = dynamic_cast<ConditionDamage*>(condition))
+		{
+			if(conditionDamage->getTotalDamage() > 0)
+				conditionDamage->setParam(CONDITIONPARAM_FORCEUPDATE, true);
+		}
+
+		iType->condition = condition;
+	}
+
+	int32_t key32 = 0, value = 0;
+	if(!reader(count))
+		return false;
+
+	for(uint32_t i = 0; i < count; ++i)
+	{
+		if(!reader(key32) || !reader(value))
+			return false;
+
+		moneyMap[key32] = value;
+	}
+
+	if(!reader(count))
+		return false;
+
+	for(uint32_t i = 0; i < count; ++i)
+	{
+		int16_t id = 0;
+		RandomizationBlock block;
+		if(!reader(id) || !reader(block))
+			return false;
+
+		randomizationMap[id] = block;
+	}
+
+	std::clog << "> Items loaded from compiled cache in " << (OTSYS_TIME() - start) << " ms." << std::endl;
+	return true;
+}
+
+void Items::saveCache(uint64_t key)
+{
+	ItemCacheWriter writer;
+	uint8_t chance = m_randomizationChance;
+	uint32_t count = 0;
+	uint64_t checksum = 0xCBF29CE484222325ULL;
+	writer(key);
+	writer(checksum);
+	writer(chance);
+
+	size_t countPos = writer.buffer.size();
+	writer(count);
+	for(uint32_t i = 0; i < items.size(); ++i)
+	{
+		ItemType* iType = items.getElement(i);
+		if(!iType)
+			continue;
+
+		uint16_t id = i;
+		writer(id);
+		cacheItemType(writer, *iType);
+
+		uint8_t hasCondition = iType->condition != NULL;
+		writer(hasCondition);
+		if(hasCondition)
+		{
+			PropWriteStream propWriteStream;
+			iType->condition->serialize(propWriteStream);
+			propWriteStream.addByte(CONDITIONATTR_END);
+
+			uint32_t size = 0;
+			const char* stream = propWriteStream.getStream(size);
+			writer.buffer.append(stream, size);
+		}
+
+		++count;
+	}
+
+	memcpy(&writer.buffer[countPos], &count, sizeof(count));
+	count = moneyMap.size();
+	writer(count);
+	for(IntegerMap::const_iterator it = moneyMap.begin(); it != moneyMap.end(); ++it)
+	{
+		int32_t first = it->first, second = it->second;
+		writer(first);
+		writer(second);
+	}
+
+	count = randomizationMap.size();
+	writer(count);
+	for(RandomizationMap::const_iterator it = randomizationMap.begin(); it != randomizationMap.end(); ++it)
+	{
+		int16_t id = it->first;
+		RandomizationBlock block = it->second;
+		writer(id);
+		writer(block);
+	}
+
+	hashData(writer.buffer.data() + 2 * sizeof(uint64_t), writer.buffer.size() - 2 * sizeof(uint64_t), checksum);
+	memcpy(&writer.buffer[sizeof(uint64_t)], &checksum, sizeof(checksum));
+
+	FILE* f = fopen(getFilePath(FILE_TYPE_OTHER, "items/items.cache").c_str(), "wb");
+	if(!f)
+	{
+		std::clog << "[Warning - Items::saveCache] Cannot write compiled items cache." << std::endl;
+		return;
+	}
+
+	if(fwrite(writer.buffer.data(), 1, writer.buffer.size(), f) != writer.buffer.size())
+		std::clog << "[Warning - Items::saveCache] Cannot write compiled items cache." << std::endl;
+
+	fclose(f);
+}
+
 void Items::parseRandomizationBlock(int32_t id, int32_t fromId, int32_t toId, int32_t chance)
 {
 	RandomizationMap::iterator it = randomizationMap.find(id);
@@ -1848,6 +2138,17 @@ void Items::parseRandomizationBlock(int32_t id, int32_t fromId, int32_t toId, in
 	randomizationMap[id] = rand;
 }
 
+RandomizationBlock Items::getRandomization(int16_t id) const
+{
+	//map areas are decoded on several threads, so never insert here
+	RandomizationMap::const_iterator it = randomizationMap.find(id);
+	if(it != randomizationMap.end())
+		return it->second;
+
+	RandomizationBlock empty = {0, 0, 0};
+	return empty;
+}
+
 uint16_t Items::getRandomizedItem(uint16_t id)
 {
 	if(!g_config.getBool(ConfigManager::RANDOMIZE_TILES))
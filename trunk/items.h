@@ -29,6 +29,7 @@
 #define ITEMS_SIZE 13000
 #define ITEMS_INCREMENT 500
 #define ITEMS_RANDOMIZATION 50
+#define ITEMS_CACHE_VERSION 1
 
 #define SLOTP_WHEREEVER 0xFFFFFFFF
 #define SLOTP_HEAD 1 << 0
@@ -269,7 +270,7 @@ class Items
 
 		uint16_t getRandomizedItem(uint16_t id);
 		uint8_t getRandomizationChance() const {return m_randomizationChance;}
-		const RandomizationBlock getRandomization(int16_t id) {return randomizationMap[id];}
+		RandomizationBlock getRandomization(int16_t id) const;
 
 		uint32_t size() {return items.size();}
 		const IntegerMap getMoneyMap() const {return moneyMap;}
@@ -283,6 +284,11 @@ class Items
 		uint8_t m_randomizationChance;
 		void clear();
 
+		bool parseXml();
+		bool getCacheKey(uint64_t& key) const;
+		bool loadCache(uint64_t key);
+		void saveCache(uint64_t key);
+
 		void parseRandomizationBlock(int32_t id, int32_t fromId, int32_t toId, int32_t chance);
 
 		Array<ItemType*> items;
@@ -205,12 +205,33 @@ void ScriptEnviroment::getInfo(int32_t& scriptId, std::string& desc, LuaInterfac
 	timerEvent = m_timerEvent;
 }
 
+#if defined _MSC_VER
+#define SCRIPT_THREAD_LOCAL __declspec(thread)
+#else
+#define SCRIPT_THREAD_LOCAL __thread
+#endif
+
+// set by threads that create items off the dispatcher, see IOMap::loadMap
+static SCRIPT_THREAD_LOCAL std::vector<Thing*>* uniqueQueue = NULL;
+
+void ScriptEnviroment::setUniqueQueue(std::vector<Thing*>* queue)
+{
+	uniqueQueue = queue;
+}
+
 void ScriptEnviroment::addUniqueThing(Thing* thing)
 {
 	Item* item = thing->getItem();
 	if(!item || !item->getUniqueId())
 		return;
 
+	if(uniqueQueue)
+	{
+		//registered later by the owner of the queue, in a fixed order
+		uniqueQueue->push_back(thing);
+		return;
+	}
+
 	if(m_globalMap[item->getUniqueId()])
 	{
 		if(item->getActionId() != 2000) //scripted quest system
@@ -934,6 +955,18 @@ void LuaInterface::executeTimer(uint32_t eventIndex)
 	}
 }
 
+void LuaInterface::executeQuery(uint32_t eventIndex, bool result)
+{
+	LuaTimerEvents::iterator it = m_timerEvents.find(eventIndex);
+	if(it == m_timerEvents.end())
+		return;
+
+	//the outcome goes in as the only parameter
+	lua_pushboolean(m_luaState, result);
+	it->second.parameters.push_back(luaL_ref(m_luaState, LUA_REGISTRYINDEX));
+	executeTimer(eventIndex);
+}
+
 int32_t LuaInterface::handleFunction(lua_State* L)
 {
 	lua_getfield(L, LUA_GLOBALSINDEX, "debug");
@@ -2528,6 +2561,9 @@ const luaL_Reg LuaInterface::luaDatabaseTable[] =
 	//db.query(query)
 	{"query", LuaInterface::luaDatabaseExecute},
 
+	//db.asyncQuery(query[, callback])
+	{"asyncQuery", LuaInterface::luaDatabaseAsyncExecute},
+
 	//db.storeQuery(query)
 	{"storeQuery", LuaInterface::luaDatabaseStoreQuery},
 
@@ -4014,7 +4050,7 @@ int32_t LuaInterface::luaDoRelocate(lua_State* L)
 				{
 					const ItemType& it = Item::items[item->getID()];
 					if(!it.isGroundTile() && !it.alwaysOnTop && !it.isMagicField())
-						g_game.internalTeleport(item, toPos, true, unmovable ? FLAG_IGNORENOTMOVABLE : 0);
+						g_game.internalTeleport(fromTile->unshareItem(item), toPos, true, unmovable ? FLAG_IGNORENOTMOVABLE : 0);
 				}
 				else if(creatures)
 				{
@@ -4055,7 +4091,7 @@ int32_t LuaInterface::luaDoCleanTile(lua_State* L)
 			if(Item* item = thing->getItem())
 			{
 				if(!item->isLoadedFromMap() || forceMapLoaded)
-					g_game.internalRemoveItem(NULL, item);
+					g_game.internalRemoveItem(NULL, tile->unshareItem(item));
 			}
 		}
 	}
@@ -4460,7 +4496,7 @@ int32_t LuaInterface::luaGetThingFromPos(lua_State* L)
 		else
 			thing = tile->__getThing(pos.stackpos);
 
-		if(thing)
+		if((thing = tile->unshareThing(thing)))
 			pushThing(L, thing, env->addThing(thing));
 		else
 			pushThing(L, NULL, 0);
@@ -4495,7 +4531,7 @@ int32_t LuaInterface::luaGetTileItemById(lua_State* L)
 		return 1;
 	}
 
-	Item* item = g_game.findItemOfType(tile, itemId, false, subType);
+	Item* item = tile->unshareItem(g_game.findItemOfType(tile, itemId, false, subType));
 	if(!item)
 	{
 		pushThing(L, NULL, 0);
@@ -4592,6 +4628,7 @@ int32_t LuaInterface::luaGetTileItemByType(lua_State* L)
 		if(Item::items[item->getID()].type != (ItemTypes_t)rType)
 			continue;
 
+		item = tile->unshareItem(item);
 		pushThing(L, item, env->addThing(item));
 		return 1;
 	}
@@ -4629,7 +4666,7 @@ int32_t LuaInterface::luaGetTileThingByPos(lua_State* L)
 		return 1;
 	}
 
-	Thing* thing = tile->__getThing(pos.stackpos);
+	Thing* thing = tile->unshareThing(tile->__getThing(pos.stackpos));
 	if(!thing)
 	{
 		pushThing(L, NULL, 0);
@@ -4917,7 +4954,8 @@ int32_t LuaInterface::luaGetTileInfo(lua_State* L)
 	if(Tile* tile = g_game.getMap()->getTile(pos))
 	{
 		ScriptEnviroment* env = getEnv();
-		pushThing(L, tile->ground, env->addThing(tile->ground));
+		Item* ground = tile->unshareItem(tile->ground);
+		pushThing(L, ground, env->addThing(ground));
 
 		setFieldBool(L, "protection", tile->hasFlag(TILESTATE_PROTECTIONZONE));
 		setFieldBool(L, "optional", tile->hasFlag(TILESTATE_OPTIONALZONE));
@@ -6638,8 +6676,8 @@ int32_t LuaInterface::luaGetMonsterTargetList(lua_State* L)
 		return 1;
 	}
 
-	const CreatureList& targetList = monster->getTargetList();
-	CreatureList::const_iterator it = targetList.begin();
+	const CreatureVector& targetList = monster->getTargetList();
+	CreatureVector::const_iterator it = targetList.begin();
 
 	lua_newtable(L);
 	for(uint32_t i = 1; it != targetList.end(); ++it, ++i)
@@ -6676,8 +6714,8 @@ int32_t LuaInterface::luaGetMonsterFriendList(lua_State* L)
 	}
 
 	Creature* friendCreature;
-	const CreatureList& friendList = monster->getFriendList();
-	CreatureList::const_iterator it = friendList.begin();
+	const CreatureVector& friendList = monster->getFriendList();
+	CreatureVector::const_iterator it = friendList.begin();
 
 	lua_newtable(L);
 	for(uint32_t i = 1; it != friendList.end(); ++it, ++i)
@@ -10131,6 +10169,7 @@ int32_t LuaInterface::luaDoItemSetAttribute(lua_State* L)
 	else
 		item->setAttribute(key, value);
 
+	g_game.markItemChanged(item);
 	lua_pushboolean(L, true);
 	return 1;
 }
@@ -10160,6 +10199,9 @@ int32_t LuaInterface::luaDoItemEraseAttribute(lua_State* L)
 	else
 		item->resetActionId();
 
+	if(ret)
+		g_game.markItemChanged(item);
+
 	lua_pushboolean(L, ret);
 	return 1;
 }
@@ -10947,6 +10989,58 @@ int32_t LuaInterface::luaDatabaseExecute(lua_State* L)
 	return 1;
 }
 
+int32_t LuaInterface::luaDatabaseAsyncExecute(lua_State* L)
+{
+	//db.asyncQuery(query[, callback])
+	int32_t parameters = lua_gettop(L);
+	if(parameters == 2 && lua_isnil(L, 2))
+		parameters = 1;
+
+	if(parameters < 1 || parameters > 2 || !lua_isstring(L, 1))
+	{
+		errorEx("Invalid parameters, expected db.asyncQuery(query[, callback]).");
+		lua_pushboolean(L, false);
+		return 1;
+	}
+
+	DBCallback callback;
+	if(parameters > 1)
+	{
+		ScriptEnviroment* env = getEnv();
+		LuaInterface* interface = env->getInterface();
+		if(!interface)
+		{
+			errorEx("No valid script interface!");
+			lua_pushboolean(L, false);
+			return 1;
+		}
+
+		if(!lua_isfunction(L, 2))
+		{
+			errorEx("Callback parameter should be a function.");
+			lua_pushboolean(L, false);
+			return 1;
+		}
+
+		//kept as a timer event without a scheduler task, so reloads drop it the same way
+		LuaTimerEvent event;
+		event.eventId = 0;
+
+		lua_pushvalue(L, 2);
+		event.function = luaL_ref(L, LUA_REGISTRYINDEX);
+		event.scriptId = env->getScriptId();
+
+		interface->m_timerEvents[++interface->m_lastTimer] = event;
+		callback = boost::bind(&LuaInterface::executeQuery, interface, interface->m_lastTimer, _1);
+	}
+
+	Database::asyncQuery(lua_tostring(L, 1), callback);
+	lua_settop(L, 0);
+
+	lua_pushboolean(L, true);
+	return 1;
+}
+
 int32_t LuaInterface::luaDatabaseStoreQuery(lua_State* L)
 {
 	//db.storeQuery(query)
@@ -144,6 +144,7 @@ class ScriptEnviroment
 
 		static void addUniqueThing(Thing* thing);
 		static void removeUniqueThing(Thing* thing);
+		static void setUniqueQueue(std::vector<Thing*>* queue);
 
 		static uint32_t getLastConditionId() {return m_lastConditionId;}
 		static uint32_t getLastCombatId() {return m_lastCombatId;}
@@ -698,8 +699,9 @@ class LuaInterface
 		static const luaL_Reg luaSystemTable[2];
 		static int32_t luaSystemTime(lua_State* L);
 
-		static const luaL_Reg luaDatabaseTable[9];
+		static const luaL_Reg luaDatabaseTable[10];
 		static int32_t luaDatabaseExecute(lua_State* L);
+		static int32_t luaDatabaseAsyncExecute(lua_State* L);
 		static int32_t luaDatabaseStoreQuery(lua_State* L);
 		static int32_t luaDatabaseEscapeString(lua_State* L);
 		static int32_t luaDatabaseEscapeBlob(lua_State* L);
@@ -746,6 +748,7 @@ class LuaInterface
 
 	private:
 		void executeTimer(uint32_t eventIndex);
+		void executeQuery(uint32_t eventIndex, bool result);
 
 		enum PlayerInfo_t
 		{
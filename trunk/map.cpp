@@ -39,20 +39,62 @@ Map::Map()
 {
 	mapWidth = 0;
 	mapHeight = 0;
+	loading = false;
+	memset(pages, 0, sizeof(pages));
+}
+
+Map::~Map()
+{
+	for(uint32_t x = 0; x < MAP_PAGES; ++x)
+	{
+		for(uint32_t y = 0; y < MAP_PAGES; ++y)
+		{
+			MapPage* page = pages[x][y];
+			if(!page)
+				continue;
+
+			//sectors live in the page arena, which goes away with the page
+			for(uint32_t sx = 0; sx < MAP_PAGE_SIZE; ++sx)
+			{
+				for(uint32_t sy = 0; sy < MAP_PAGE_SIZE; ++sy)
+				{
+					if(QTreeLeafNode* leaf = page->leaves[sx][sy])
+						leaf->~QTreeLeafNode();
+				}
+			}
+
+			delete page;
+		}
+	}
 }
 
 bool Map::loadMap(const std::string& identifier)
 {
 	int64_t start = OTSYS_TIME();
 	IOMap* loader = new IOMap();
-	if(!loader->loadMap(this, identifier))
+
+	loading = true;
+	bool result = loader->loadMap(this, identifier);
+	loading = false;
+	if(!result)
 	{
 		std::clog << "> FATAL: OTBM Loader - " << loader->getLastErrorString() << std::endl;
 		return false;
 	}
 
+	delete loader;
 	std::clog << "> Map loading time: " << (OTSYS_TIME() - start) / (1000.) << " seconds." << std::endl;
-	start = OTSYS_TIME();
+
+	size_t used, reserved;
+	getArenaUsage(used, reserved);
+	std::clog << "> Map arena: " << (used >> 10) << " KB used of " << (reserved >> 10) << " KB reserved." << std::endl;
+	return true;
+}
+
+bool Map::loadMapData()
+{
+	int64_t start = OTSYS_TIME();
+	IOMap* loader = new IOMap();
 	if(!loader->loadSpawns(this))
 		std::clog << "> WARNING: Could not load spawn data." << std::endl;
 
@@ -104,12 +146,65 @@ bool Map::saveMap()
 	return saved;
 }
 
+MapPage* Map::createPage(uint16_t x, uint16_t y)
+{
+	MapPage*& page = pages[x >> MAP_PAGE_SHIFT][y >> MAP_PAGE_SHIFT];
+	if(!page)
+		page = new MapPage();
+
+	return page;
+}
+
+void Map::getArenaUsage(size_t& used, size_t& reserved) const
+{
+	used = reserved = 0;
+	for(uint32_t x = 0; x < MAP_PAGES; ++x)
+	{
+		for(uint32_t y = 0; y < MAP_PAGES; ++y)
+		{
+			if(!pages[x][y])
+				continue;
+
+			used += pages[x][y]->arena.getUsed();
+			reserved += pages[x][y]->arena.getReserved();
+		}
+	}
+}
+
+QTreeLeafNode* Map::createLeaf(uint16_t x, uint16_t y)
+{
+	MapPage* page = createPage(x, y);
+	QTreeLeafNode* leaf = new(page->arena.allocate(sizeof(QTreeLeafNode))) QTreeLeafNode();
+	page->leaves[(x >> FLOOR_BITS) & MAP_PAGE_MASK][(y >> FLOOR_BITS) & MAP_PAGE_MASK] = leaf;
+
+	//link the neighbours used when walking sectors south and east
+	if(y >= FLOOR_SIZE)
+	{
+		if(QTreeLeafNode* northLeaf = getLeaf(x, y - FLOOR_SIZE))
+			northLeaf->m_leafS = leaf;
+	}
+
+	if(x >= FLOOR_SIZE)
+	{
+		if(QTreeLeafNode* westLeaf = getLeaf(x - FLOOR_SIZE, y))
+			westLeaf->m_leafE = leaf;
+	}
+
+	if(y < 0x10000 - FLOOR_SIZE)
+		leaf->m_leafS = getLeaf(x, y + FLOOR_SIZE);
+
+	if(x < 0x10000 - FLOOR_SIZE)
+		leaf->m_leafE = getLeaf(x + FLOOR_SIZE, y);
+
+	return leaf;
+}
+
 Tile* Map::getTile(int32_t x, int32_t y, int32_t z)
 {
 	if(x < 0 || x > 0xFFFF || y < 0 || y > 0xFFFF || z < 0 || z >= MAP_MAX_LAYERS)
 		return NULL;
 
-	QTreeLeafNode* leaf = QTreeNode::getLeafStatic(&root, x, y);
+	QTreeLeafNode* leaf = getLeaf(x, y);
 	if(!leaf)
 		return NULL;
 
@@ -128,33 +223,12 @@ void Map::setTile(uint16_t x, uint16_t y, uint16_t z, Tile* newTile)
 		return;
 	}
 
-	QTreeLeafNode::newLeaf = false;
-	QTreeLeafNode* leaf = root.createLeaf(x, y, 15);
-	if(QTreeLeafNode::newLeaf)
-	{
-		//update north
-		QTreeLeafNode* northLeaf = root.getLeaf(x, y - FLOOR_SIZE);
-		if(northLeaf)
-			northLeaf->m_leafS = leaf;
-
-		//update west leaf
-		QTreeLeafNode* westLeaf = root.getLeaf(x - FLOOR_SIZE, y);
-		if(westLeaf)
-			westLeaf->m_leafE = leaf;
-
-		//update south
-		QTreeLeafNode* southLeaf = root.getLeaf(x, y + FLOOR_SIZE);
-		if(southLeaf)
-			leaf->m_leafS = southLeaf;
-
-		//update east
-		QTreeLeafNode* eastLeaf = root.getLeaf(x + FLOOR_SIZE, y);
-		if(eastLeaf)
-			leaf->m_leafE = eastLeaf;
-	}
+	QTreeLeafNode* leaf = getLeaf(x, y);
+	if(!leaf)
+		leaf = createLeaf(x, y);
 
 	uint32_t offsetX = x & FLOOR_MASK, offsetY = y & FLOOR_MASK;
-	Floor* floor = leaf->createFloor(z);
+	Floor* floor = leaf->createFloor(z, createPage(x, y)->arena);
 	if(!floor->tiles[offsetX][offsetY])
 	{
 		floor->tiles[offsetX][offsetY] = newTile;
@@ -401,6 +475,72 @@ void Map::getSpectators(SpectatorVec& list, const Position& centerPos, bool chec
 	}
 }
 
+void Map::getStepSpectators(SpectatorVec& list, const Position& fromPos, const Position& toPos)
+{
+	if(toPos.z >= MAP_MAX_LAYERS || fromPos.z != toPos.z)
+		return;
+
+	int32_t minRangeZ, maxRangeZ;
+	if(toPos.z > 7)
+	{
+		minRangeZ = std::max(toPos.z - 2, 0);
+		maxRangeZ = std::min(toPos.z + 2, MAP_MAX_LAYERS - 1);
+	}
+	else
+	{
+		minRangeZ = 0;
+		maxRangeZ = 7;
+	}
+
+	int32_t dx = toPos.x - fromPos.x, dy = toPos.y - fromPos.y;
+	if(dx)
+	{
+		int32_t rangeX = (dx > 0 ? maxViewportX : -maxViewportX);
+		getSpectatorsInternal(list, toPos, false, rangeX, rangeX, -maxViewportY,
+			maxViewportY, minRangeZ, maxRangeZ);
+	}
+
+	if(dy)
+	{
+		int32_t rangeY = (dy > 0 ? maxViewportY : -maxViewportY);
+		getSpectatorsInternal(list, toPos, dx != 0, -maxViewportX, maxViewportX,
+			rangeY, rangeY, minRangeZ, maxRangeZ);
+	}
+}
+
+bool Map::isPlayerNearby(const Position& centerPos)
+{
+	if(centerPos.z >= MAP_MAX_LAYERS)
+		return false;
+
+	int32_t x1 = std::max((int32_t)0, (int32_t)centerPos.x - maxViewportX),
+		y1 = std::max((int32_t)0, (int32_t)centerPos.y - maxViewportY),
+		x2 = std::min((int32_t)0xFFFF, (int32_t)centerPos.x + maxViewportX),
+		y2 = std::min((int32_t)0xFFFF, (int32_t)centerPos.y + maxViewportY);
+	for(int32_t ny = y1 - (y1 % FLOOR_SIZE); ny <= y2; ny += FLOOR_SIZE)
+	{
+		for(int32_t nx = x1 - (x1 % FLOOR_SIZE); nx <= x2; nx += FLOOR_SIZE)
+		{
+			QTreeLeafNode* leaf = getLeaf(nx, ny);
+			if(!leaf || !leaf->hasPlayers())
+				continue;
+
+			for(CreatureVector::const_iterator it = leaf->creatureList.begin(); it != leaf->creatureList.end(); ++it)
+			{
+				const Player* player = (*it)->getPlayer();
+				if(!player || player->hasFlag(PlayerFlag_IgnoredByMonsters))
+					continue;
+
+				const Position& pos = player->getPosition();
+				if(pos.z == centerPos.z && pos.x >= x1 && pos.x <= x2 && pos.y >= y1 && pos.y <= y2)
+					return true;
+			}
+		}
+	}
+
+	return false;
+}
+
 const SpectatorVec& Map::getSpectators(const Position& centerPos)
 {
 	if(centerPos.z >= MAP_MAX_LAYERS)
@@ -1057,98 +1197,69 @@ Floor::Floor()
 	}
 }
 
-//**************** QTreeNode **********************
-QTreeNode::QTreeNode()
+//************ LeafNode  ************************
+QTreeLeafNode::QTreeLeafNode()
 {
-	m_isLeaf = false;
-	for(int32_t i = 0; i < 4; ++i)
-		m_child[i] = NULL;
+	for(int32_t i = 0; i < MAP_MAX_LAYERS; ++i)
+		m_array[i] = NULL;
+
+	m_leafS = NULL;
+	m_leafE = NULL;
+	playerCount = 0;
 }
 
-QTreeNode::~QTreeNode()
+void QTreeLeafNode::addCreature(Creature* c)
 {
-	for(int32_t i = 0; i < 4; ++i)
-		delete m_child[i];
+	creatureList.push_back(c);
+	if(c->getPlayer())
+		++playerCount;
 }
 
-QTreeLeafNode* QTreeNode::getLeaf(uint16_t x, uint16_t y)
+void QTreeLeafNode::removeCreature(Creature* c)
 {
-	if(isLeaf())
-		return static_cast<QTreeLeafNode*>(this);
-
-	uint32_t index = ((x & 0x8000) >> 15) | ((y & 0x8000) >> 14);
-	if(m_child[index])
-		return m_child[index]->getLeaf(x * 2, y * 2);
-
-	return NULL;
+	CreatureVector::iterator it = std::find(creatureList.begin(), creatureList.end(), c);
+	assert(it != creatureList.end());
+	creatureList.erase(it);
+	if(c->getPlayer())
+		--playerCount;
 }
 
-QTreeLeafNode* QTreeNode::getLeafStatic(QTreeNode* root, uint16_t x, uint16_t y)
+Floor* QTreeLeafNode::createFloor(uint16_t z, MapArena& arena)
 {
-	QTreeNode* currentNode = root;
-	uint32_t currentX = x, currentY = y;
-	while(currentNode)
-	{
-		if(currentNode->isLeaf())
-			return static_cast<QTreeLeafNode*>(currentNode);
-
-		uint32_t index = ((currentX & 0x8000) >> 15) | ((currentY & 0x8000) >> 14);
-		if(!currentNode->m_child[index])
-			return NULL;
-
-		currentNode = currentNode->m_child[index];
-		currentX = currentX * 2;
-		currentY = currentY * 2;
-	}
+	if(!m_array[z])
+		m_array[z] = new(arena.allocate(sizeof(Floor))) Floor();
 
-	return NULL;
+	return m_array[z];
 }
 
-QTreeLeafNode* QTreeNode::createLeaf(uint16_t x, uint16_t y, uint16_t level)
+//************ MapArena  ************************
+MapArena::~MapArena()
 {
-	if(!isLeaf())
-	{
-		uint32_t index = ((x & 0x8000) >> 15) | ((y & 0x8000) >> 14);
-		if(!m_child[index])
-		{
-			if(level != FLOOR_BITS)
-				m_child[index] = new QTreeNode();
-			else
-			{
-				m_child[index] = new QTreeLeafNode();
-				QTreeLeafNode::newLeaf = true;
-			}
-		}
-
-		return m_child[index]->createLeaf(x * 2, y * 2, level - 1);
-	}
-
-	return static_cast<QTreeLeafNode*>(this);
+	for(std::vector<char*>::iterator it = slabs.begin(); it != slabs.end(); ++it)
+		delete[] *it;
 }
 
-
-//************ LeafNode  ************************
-bool QTreeLeafNode::newLeaf = false;
-QTreeLeafNode::QTreeLeafNode()
+void* MapArena::allocate(size_t bytes)
 {
-	for(int32_t i = 0; i < MAP_MAX_LAYERS; ++i)
-		m_array[i] = NULL;
+	bytes = (bytes + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+	if(bytes > left)
+	{
+		//slabs grow with the page, so sparse pages stay small
+		size_t size = std::max(slabSize, bytes);
+		if(slabSize < MAP_ARENA_MAX_SLAB)
+			slabSize <<= 1;
 
-	m_isLeaf = true;
-	m_leafS = NULL;
-	m_leafE = NULL;
-}
+		current = new char[size];
+		slabs.push_back(current);
 
-QTreeLeafNode::~QTreeLeafNode()
-{
-	for(int32_t i = 0; i < MAP_MAX_LAYERS; ++i)
-		delete m_array[i];
-}
+		left = size;
+		reserved += size;
+	}
 
-Floor* QTreeLeafNode::createFloor(uint16_t z)
-{
-	if(!m_array[z])
-		m_array[z] = new Floor();
+	void* p = current;
+	current += bytes;
 
-	return m_array[z];
+	left -= bytes;
+	used += bytes;
+	return p;
 }
@@ -97,34 +97,41 @@ struct Floor
 class FrozenPathingConditionCall;
 class QTreeLeafNode;
 
-class QTreeNode
+#define MAP_ARENA_MIN_SLAB 4096
+#define MAP_ARENA_MAX_SLAB 65536
+
+// bump allocator for everything that lives as long as the map (sectors, floors,
+// tiles and their item lists), nothing is freed until the arena goes away;
+// like the map itself it is only written by one thread at a time
+class MapArena
 {
 	public:
-		QTreeNode();
-		virtual ~QTreeNode();
- 
-		bool isLeaf() const {return m_isLeaf;}
- 
-		QTreeLeafNode* getLeaf(uint16_t x, uint16_t y);
-		static QTreeLeafNode* getLeafStatic(QTreeNode* root, uint16_t x, uint16_t y);
- 
-		QTreeLeafNode* createLeaf(uint16_t x, uint16_t y, uint16_t level);
+		MapArena(): current(NULL), left(0), slabSize(MAP_ARENA_MIN_SLAB), used(0), reserved(0) {}
+		virtual ~MapArena();
 
-	protected:
-		bool m_isLeaf;
-		QTreeNode* m_child[4];
+		void* allocate(size_t bytes);
 
-		friend class Map;
+		size_t getUsed() const {return used;}
+		size_t getReserved() const {return reserved;}
+
+	private:
+		MapArena(const MapArena&);
+		const MapArena& operator=(const MapArena&);
+
+		std::vector<char*> slabs;
+		char* current;
+		size_t left, slabSize, used, reserved;
 };
- 
- 
-class QTreeLeafNode : public QTreeNode
+
+// sector of FLOOR_SIZE x FLOOR_SIZE tiles on every floor, the name stayed from
+// when sectors were the leaves of a quadtree
+class QTreeLeafNode
 {
 	public:
 		QTreeLeafNode();
-		virtual ~QTreeLeafNode();
+		virtual ~QTreeLeafNode() {} //floors belong to the page arena
 
-		Floor* createFloor(uint16_t z);
+		Floor* createFloor(uint16_t z, MapArena& arena);
 		Floor* getFloor(uint16_t z){return m_array[z];}
 
 		QTreeLeafNode* stepSouth(){return m_leafS;}
@@ -133,17 +140,35 @@ class QTreeLeafNode : public QTreeNode
 		void addCreature(Creature* c);
 		void removeCreature(Creature* c);
 
-	protected:
-		static bool newLeaf;
+		bool hasPlayers() const {return playerCount > 0;}
 
+	protected:
 		QTreeLeafNode* m_leafS;
 		QTreeLeafNode* m_leafE;
 
 		Floor* m_array[MAP_MAX_LAYERS];
 		CreatureVector creatureList;
+		uint32_t playerCount;
 
 		friend class Map;
-		friend class QTreeNode;
+};
+
+// sectors are found through a two level page table, (x, y) >> MAP_PAGE_SHIFT
+// picks the page and the remaining sector bits index into it
+#define MAP_PAGE_BITS 6
+#define MAP_PAGE_SIZE (1 << MAP_PAGE_BITS)
+#define MAP_PAGE_MASK (MAP_PAGE_SIZE - 1)
+#define MAP_PAGE_SHIFT (FLOOR_BITS + MAP_PAGE_BITS)
+#define MAP_PAGES (0x10000 >> MAP_PAGE_SHIFT)
+
+// every page allocates from its own arena, so the tiles of neighbouring sectors
+// share cache lines and pages instead of being spread over the heap
+struct MapPage
+{
+	MapPage() {memset(leaves, 0, sizeof(leaves));}
+
+	QTreeLeafNode* leaves[MAP_PAGE_SIZE][MAP_PAGE_SIZE];
+	MapArena arena;
 };
 
 /**
@@ -155,7 +180,7 @@ class Map
 {
 	public:
 		Map();
-		virtual ~Map() {}
+		virtual ~Map();
 
 		static const int32_t maxViewportX = 11; //min value: maxClientViewportX + 1
 		static const int32_t maxViewportY = 11; //min value: maxClientViewportY + 1
@@ -163,11 +188,17 @@ class Map
 		static const int32_t maxClientViewportY = 6;
 
 		/**
-		* Load a map.
+		* Load a map (tiles only).
 		* \returns true if the map was loaded successfully
 		*/
 		bool loadMap(const std::string& identifier);
 
+		/**
+		* Load spawns and houses and unserialize the map contents,
+		* needs the monsters to be loaded already.
+		*/
+		bool loadMapData();
+
 		/**
 		* Save a map.
 		* \param identifier file/database to save to
@@ -240,14 +271,33 @@ class Map
 		bool getPathMatching(const Creature* creature, std::list<Direction>& dirList,
 			const FrozenPathingConditionCall& pathCondition, const FindPathParams& fpp);
 
-		QTreeLeafNode* getLeaf(uint16_t x, uint16_t y) {return root.getLeaf(x, y);}
+		QTreeLeafNode* getLeaf(uint16_t x, uint16_t y)
+		{
+			if(MapPage* page = pages[x >> MAP_PAGE_SHIFT][y >> MAP_PAGE_SHIFT])
+				return page->leaves[(x >> FLOOR_BITS) & MAP_PAGE_MASK][(y >> FLOOR_BITS) & MAP_PAGE_MASK];
+
+			return NULL;
+		}
+		/**
+		* Get memory from the arena of the page holding the position,
+		* it is never given back while the map exists.
+		*/
+		void* allocate(uint16_t x, uint16_t y, size_t bytes) {return createPage(x, y)->arena.allocate(bytes);}
+		void getArenaUsage(size_t& used, size_t& reserved) const;
+		//only the map loader allocates from the arenas, later tiles stay on the heap
+		bool isLoading() const {return loading;}
+
 		const Tile* canWalkTo(const Creature* creature, const Position& pos);
 		Waypoints waypoints;
 
 	protected:
-		QTreeNode root;
+		MapPage* pages[MAP_PAGES][MAP_PAGES];
+		QTreeLeafNode* createLeaf(uint16_t x, uint16_t y);
+		MapPage* createPage(uint16_t x, uint16_t y);
 
 		uint32_t mapWidth, mapHeight;
+		bool loading;
+
 		std::string spawnfile, housefile;
 		StringVec descriptions;
 
@@ -266,20 +316,14 @@ class Map
 		// Take special heed in that the vector will be destroyed if any function
 		// that calls clearSpectatorCache is called.
 		const SpectatorVec& getSpectators(const Position& centerPos);
+		// Tells whether a player monsters care about can see centerPos, without
+		// building a spectator list; leaves holding no players are skipped.
+		bool isPlayerNearby(const Position& centerPos);
+		// Creatures that come into view when stepping from fromPos to toPos on the
+		// same floor, i.e. the leading row/column of the multifloor view range.
+		void getStepSpectators(SpectatorVec& list, const Position& fromPos, const Position& toPos);
 
 		friend class Game;
 		friend class IOMap;
 };
-
-inline void QTreeLeafNode::addCreature(Creature* c)
-{
-	creatureList.push_back(c);
-}
-
-inline void QTreeLeafNode::removeCreature(Creature* c)
-{
-	CreatureVector::iterator it = std::find(creatureList.begin(), creatureList.end(), c);
-	assert(it != creatureList.end());
-	creatureList.erase(it);
-}
 #endif
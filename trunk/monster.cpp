@@ -54,6 +54,7 @@ Monster::Monster(MonsterType* _mType):
 {
 	isIdle = true;
 	isMasterInRange = false;
+	stepUpdates = 0;
 	teleportToMaster = false;
 	mType = _mType;
 	spawn = NULL;
@@ -157,7 +158,10 @@ void Monster::onCreatureDisappear(const Creature* creature, bool isLogout)
 	if(creature == this)
 	{
 		if(spawn)
-			spawn->startEvent();
+		{
+			spawn->removeMonster(this, true);
+			spawn = NULL;
+		}
 
 		setIdle(true);
 	}
@@ -174,7 +178,12 @@ void Monster::onCreatureMove(const Creature* creature, const Tile* newTile, cons
 		if(isSummon())
 			isMasterInRange = canSee(master->getPosition());
 
-		updateTargetList();
+		//lists are dropped while idle, so those need a full rescan
+		if(isIdle || teleport || newPos.z != oldPos.z || std::abs(newPos.x - oldPos.x) > 1 || std::abs(newPos.y - oldPos.y) > 1)
+			updateTargetList();
+		else
+			updateTargetList(oldPos);
+
 		updateIdleStatus();
 	}
 	else
@@ -194,30 +203,26 @@ void Monster::onCreatureMove(const Creature* creature, const Tile* newTile, cons
 	}
 }
 
-void Monster::updateTargetList()
+void Monster::removeUnseen(CreatureVector& list)
 {
-	CreatureList::iterator it;
-	for(it = friendList.begin(); it != friendList.end();)
+	CreatureVector::iterator it = list.begin();
+	while(it != list.end())
 	{
 		if((*it)->getHealth() <= 0 || !canSee((*it)->getPosition()))
 		{
 			(*it)->unRef();
-			it = friendList.erase(it);
+			it = list.erase(it);
 		}
 		else
 			++it;
 	}
+}
 
-	for(it = targetList.begin(); it != targetList.end();)
-	{
-		if((*it)->getHealth() <= 0 || !canSee((*it)->getPosition()))
-		{
-			(*it)->unRef();
-			it = targetList.erase(it);
-		}
-		else
-			++it;
-	}
+void Monster::updateTargetList()
+{
+	stepUpdates = 0;
+	removeUnseen(friendList);
+	removeUnseen(targetList);
 
 	const SpectatorVec& list = g_game.getSpectators(getPosition());
 	for(SpectatorVec::const_iterator it = list.begin(); it != list.end(); ++it)
@@ -227,9 +232,33 @@ void Monster::updateTargetList()
 	}
 }
 
+void Monster::updateTargetList(const Position& oldPos)
+{
+	//a single step only uncovers the leading edge of our view, everything
+	//else is already known through the appear/move/disappear notifications;
+	//those dropped by removeUnseen while still in view are only found again
+	//by a full scan, so do one every few steps or once we run out of targets
+	if(targetList.empty() || ++stepUpdates >= MONSTER_STEP_UPDATES)
+	{
+		updateTargetList();
+		return;
+	}
+
+	removeUnseen(friendList);
+	removeUnseen(targetList);
+
+	SpectatorVec list;
+	g_game.getStepSpectators(list, oldPos, getPosition());
+	for(SpectatorVec::const_iterator it = list.begin(); it != list.end(); ++it)
+	{
+		if((*it) != this)
+			onCreatureFound(*it);
+	}
+}
+
 void Monster::clearTargetList()
 {
-	for(CreatureList::iterator it = targetList.begin(); it != targetList.end(); ++it)
+	for(CreatureVector::iterator it = targetList.begin(); it != targetList.end(); ++it)
 		(*it)->unRef();
 
 	targetList.clear();
@@ -237,7 +266,7 @@ void Monster::clearTargetList()
 
 void Monster::clearFriendList()
 {
-	for(CreatureList::iterator it = friendList.begin(); it != friendList.end(); ++it)
+	for(CreatureVector::iterator it = friendList.begin(); it != friendList.end(); ++it)
 		(*it)->unRef();
 
 	friendList.clear();
@@ -262,7 +291,7 @@ void Monster::onCreatureFound(Creature* creature, bool pushFront /*= false*/)
 		{
 			creature->addRef();
 			if(pushFront)
-				targetList.push_front(creature);
+				targetList.insert(targetList.begin(), creature);
 			else
 				targetList.push_back(creature);
 		}
@@ -341,7 +370,7 @@ void Monster::onCreatureLeave(Creature* creature)
 	//update friendList
 	if(isFriend(creature))
 	{
-		CreatureList::iterator it = std::find(friendList.begin(), friendList.end(), creature);
+		CreatureVector::iterator it = std::find(friendList.begin(), friendList.end(), creature);
 		if(it != friendList.end())
 		{
 			(*it)->unRef();
@@ -356,7 +385,7 @@ void Monster::onCreatureLeave(Creature* creature)
 	//update targetList
 	if(isOpponent(creature))
 	{
-		CreatureList::iterator it = std::find(targetList.begin(), targetList.end(), creature);
+		CreatureVector::iterator it = std::find(targetList.begin(), targetList.end(), creature);
 		if(it != targetList.end())
 		{
 			(*it)->unRef();
@@ -377,9 +406,9 @@ bool Monster::searchTarget(TargetSearchType_t searchType /*= TARGETSEARCH_DEFAUL
 	std::clog << "Searching target... " << std::endl;
 #endif
 
-	std::list<Creature*> resultList;
+	CreatureVector resultList;
 	const Position& myPos = getPosition();
-	for(CreatureList::iterator it = targetList.begin(); it != targetList.end(); ++it)
+	for(CreatureVector::iterator it = targetList.begin(); it != targetList.end(); ++it)
 	{
 		if(followCreature != (*it) && isTarget(*it) && (searchType == TARGETSEARCH_RANDOM
 			|| canUseAttack(myPos, *it)))
@@ -392,7 +421,7 @@ bool Monster::searchTarget(TargetSearchType_t searchType /*= TARGETSEARCH_DEFAUL
 		{
 			Creature* target = NULL;
 			int32_t range = -1;
-			for(CreatureList::iterator it = resultList.begin(); it != resultList.end(); ++it)
+			for(CreatureVector::iterator it = resultList.begin(); it != resultList.end(); ++it)
 			{
 				int32_t tmp = std::max(std::abs(myPos.x - (*it)->getPosition().x),
 					std::abs(myPos.y - (*it)->getPosition().y));
@@ -412,8 +441,7 @@ bool Monster::searchTarget(TargetSearchType_t searchType /*= TARGETSEARCH_DEFAUL
 		{
 			if(!resultList.empty())
 			{
-				CreatureList::iterator it = resultList.begin();
-				std::advance(it, random_range(0, resultList.size() - 1));
+				CreatureVector::iterator it = resultList.begin() + random_range(0, resultList.size() - 1);
 #ifdef __DEBUG__
 
 				std::clog << "Selecting target " << (*it)->getName() << std::endl;
@@ -430,7 +458,7 @@ bool Monster::searchTarget(TargetSearchType_t searchType /*= TARGETSEARCH_DEFAUL
 
 
 	//lets just pick the first target in the list
-	for(CreatureList::iterator it = targetList.begin(); it != targetList.end(); ++it)
+	for(CreatureVector::iterator it = targetList.begin(); it != targetList.end(); ++it)
 	{
 		if(followCreature == (*it) || !selectTarget(*it))
 			continue;
@@ -449,14 +477,14 @@ void Monster::onFollowCreatureComplete(const Creature* creature)
 	if(!creature)
 		return;
 
-	CreatureList::iterator it = std::find(targetList.begin(), targetList.end(), creature);
+	CreatureVector::iterator it = std::find(targetList.begin(), targetList.end(), creature);
 	if(it != targetList.end())
 	{
 		Creature* target = (*it);
 		targetList.erase(it);
 
 		if(hasFollowPath) //push target we have found a path to the front
-			targetList.push_front(target);
+			targetList.insert(targetList.begin(), target);
 		else if(!isSummon()) //push target we have not found a path to the back
 			targetList.push_back(target);
 		else //Since we removed the creature from the targetList (and not put it back) we have to release it too
@@ -502,7 +530,7 @@ bool Monster::selectTarget(Creature* creature)
 	if(!isTarget(creature))
 		return false;
 
-	CreatureList::iterator it = std::find(targetList.begin(), targetList.end(), creature);
+	CreatureVector::iterator it = std::find(targetList.begin(), targetList.end(), creature);
 	if(it == targetList.end())
 	{
 		//Target not found in our target list.
@@ -34,6 +34,8 @@ enum TargetSearchType_t
 	TARGETSEARCH_NEAREST
 };
 
+#define MONSTER_STEP_UPDATES 8
+
 typedef std::list<Creature*> CreatureList;
 class Monster : public Creature
 {
@@ -108,8 +110,8 @@ class Monster : public Creature
 		bool searchTarget(TargetSearchType_t searchType = TARGETSEARCH_DEFAULT);
 		bool selectTarget(Creature* creature);
 
-		const CreatureList& getTargetList() {return targetList;}
-		const CreatureList& getFriendList() {return friendList;}
+		const CreatureVector& getTargetList() {return targetList;}
+		const CreatureVector& getFriendList() {return friendList;}
 
 		bool isTarget(Creature* creature);
 		bool getIdleStatus() const {return isIdle;}
@@ -119,8 +121,8 @@ class Monster : public Creature
 			bool checkDefense = false, bool checkArmor = false, bool reflect = true, bool field = false);
 
 	private:
-		CreatureList targetList;
-		CreatureList friendList;
+		CreatureVector targetList;
+		CreatureVector friendList;
 
 		MonsterType* mType;
 
@@ -131,6 +133,7 @@ class Monster : public Creature
 		uint32_t targetChangeTicks;
 		uint32_t defenseTicks;
 		uint32_t yellTicks;
+		uint32_t stepUpdates;
 		int32_t targetChangeCooldown;
 		bool resetTicks;
 		bool isIdle;
@@ -150,6 +153,8 @@ class Monster : public Creature
 		void updateLookDirection();
 
 		void updateTargetList();
+		void updateTargetList(const Position& oldPos);
+		void removeUnseen(CreatureVector& list);
 		void clearTargetList();
 		void clearFriendList();
 
@@ -37,6 +37,8 @@ extern Spells* g_spells;
 extern Monsters g_monsters;
 extern ConfigManager g_config;
 
+#define LOOT_BATCH 32
+
 void MonsterType::reset()
 {
 	canPushItems = canPushCreatures = isSummonable = isIllusionable = isConvinceable = isLureable = isWalkable = hideName = hideHealth = false;
@@ -83,38 +85,58 @@ void MonsterType::reset()
 
 	voiceVector.clear();
 	lootItems.clear();
+	lootTable.clear();
 	elementMap.clear();
+	lootRoots = 0;
 }
 
-uint16_t Monsters::getLootRandom()
+void Monsters::compileLoot()
 {
-	return (uint16_t)std::ceil((double)random_range(0, MAX_LOOTCHANCE) / g_config.getDouble(ConfigManager::RATE_LOOT));
+	double rate = g_config.getDouble(ConfigManager::RATE_LOOT);
+	for(MonsterMap::iterator it = monsters.begin(); it != monsters.end(); ++it)
+		it->second->compileLoot(rate);
 }
 
-void MonsterType::dropLoot(Container* corpse)
+void MonsterType::compileLoot(double rate)
+{
+	lootTable.clear();
+	compileLoot(lootItems, rate);
+	lootRoots = lootItems.size();
+}
+
+uint32_t MonsterType::compileLoot(const LootItems& items, double rate)
 {
-	ItemList items;
-	for(LootItems::const_iterator it = lootItems.begin(); it != lootItems.end() && !corpse->full(); ++it)
+	uint32_t begin = lootTable.size();
+	for(LootItems::const_iterator it = items.begin(); it != items.end(); ++it)
 	{
-		items = createLoot(*it);
-		if(items.empty())
+		//a block drops when ceil(roll / rate) < chance, that is roll <= (chance - 1) * rate
+		LootEntry entry;
+		entry.block = &(*it);
+		entry.threshold = 0;
+		if(it->chance && rate > 0)
+			entry.threshold = (uint32_t)std::min((double)MAX_LOOTCHANCE + 1, std::floor((it->chance - 1) * rate) + 1);
+
+		entry.childBegin = entry.childEnd = 0;
+		lootTable.push_back(entry);
+	}
+
+	uint32_t index = begin;
+	for(LootItems::const_iterator it = items.begin(); it != items.end(); ++it, ++index)
+	{
+		if(it->childLoot.empty())
 			continue;
 
-		for(ItemList::iterator iit = items.begin(); iit != items.end(); ++iit)
-		{
-			Item* tmpItem = *iit;
-			if(Container* container = tmpItem->getContainer())
-			{
-				if(createChildLoot(container, *it))
-					corpse->__internalAddThing(tmpItem);
-				else
-					delete container;
-			}
-			else
-				corpse->__internalAddThing(tmpItem);
-		}
+		uint32_t childBegin = compileLoot(it->childLoot, rate);
+		lootTable[index].childBegin = childBegin;
+		lootTable[index].childEnd = childBegin + it->childLoot.size();
 	}
 
+	return begin;
+}
+
+void MonsterType::dropLoot(Container* corpse)
+{
+	createLoot(corpse, 0, lootRoots);
 	corpse->__startDecaying();
 	uint32_t ownerId = corpse->getCorpseOwner();
 	if(!ownerId)
@@ -139,18 +161,36 @@ void MonsterType::dropLoot(Container* corpse)
 		owner->sendTextMessage((MessageClasses)g_config.getNumber(ConfigManager::LOOT_MESSAGE_TYPE), ss.str());
 }
 
-ItemList MonsterType::createLoot(const LootBlock& lootBlock)
+void MonsterType::createLoot(Container* parent, uint32_t begin, uint32_t end)
 {
-	uint16_t item = lootBlock.ids[0], random = Monsters::getLootRandom(), count = 0;
+	uint32_t rolls[LOOT_BATCH];
+	for(uint32_t i = begin; i < end; i += LOOT_BATCH)
+	{
+		uint32_t size = std::min(end - i, (uint32_t)LOOT_BATCH);
+		random_fill(rolls, size, MAX_LOOTCHANCE + 1);
+		for(uint32_t j = 0; j < size; ++j)
+		{
+			if(parent->full())
+				return;
+
+			if(rolls[j] < lootTable[i + j].threshold)
+				createLootItem(parent, lootTable[i + j]);
+		}
+	}
+}
+
+void MonsterType::createLootItem(Container* parent, const LootEntry& entry)
+{
+	const LootBlock& lootBlock = *entry.block;
+	uint16_t item = lootBlock.ids[0], count = 1;
 	if(lootBlock.ids.size() > 1)
-		item = lootBlock.ids[random_range((size_t)0, lootBlock.ids.size() - 1)];
+		item = lootBlock.ids[random_range(0, lootBlock.ids.size() - 1)];
 
-	ItemList items;
-	if(random < lootBlock.chance)
-		count = random % lootBlock.count + 1;
+	if(lootBlock.count > 1)
+		count = random_range(1, lootBlock.count);
 
 	Item* tmpItem = NULL;
-	while(count > 0)
+	while(count > 0 && !parent->full())
 	{
 		uint16_t n = 0;
 		if(Item::items[item].stackable)
@@ -172,41 +212,19 @@ ItemList MonsterType::createLoot(const LootBlock& lootBlock)
 		if(!lootBlock.text.empty())
 			tmpItem->setText(lootBlock.text);
 
-		items.push_back(tmpItem);
-	}
-
-	return items;
-}
-
-bool MonsterType::createChildLoot(Container* parent, const LootBlock& lootBlock)
-{
-	LootItems::const_iterator it = lootBlock.childLoot.begin();
-	if(it == lootBlock.childLoot.end())
-		return true;
-
-	ItemList items;
-	for(; it != lootBlock.childLoot.end() && !parent->full(); ++it)
-	{
-		items = createLoot(*it);
-		if(items.empty())
-			continue;
-
-		for(ItemList::iterator iit = items.begin(); iit != items.end(); ++iit)
+		Container* container = tmpItem->getContainer();
+		if(container && entry.childBegin != entry.childEnd)
 		{
-			Item* tmpItem = *iit;
-			if(Container* container = tmpItem->getContainer())
+			createLoot(container, entry.childBegin, entry.childEnd);
+			if(container->empty())
 			{
-				if(createChildLoot(container, *it))
-					parent->__internalAddThing(tmpItem);
-				else
-					delete container;
+				delete container;
+				continue;
 			}
-			else
-				parent->__internalAddThing(tmpItem);
 		}
-	}
 
-	return !parent->empty();
+		parent->__internalAddThing(tmpItem);
+	}
 }
 
 bool Monsters::loadFromXml(bool reloading /*= false*/)
@@ -1460,6 +1478,7 @@ bool Monsters::loadMonster(const std::string& file, const std::string& monsterNa
 		return false;
 	}
 
+	mType->compileLoot(g_config.getDouble(ConfigManager::RATE_LOOT));
 	static uint32_t id = 0;
 	if(new_mType)
 	{
@@ -52,6 +52,13 @@ struct LootBlock
 	}
 };
 
+struct LootEntry
+{
+	const LootBlock* block;
+	uint32_t threshold, childBegin, childEnd;
+};
+typedef std::vector<LootEntry> LootTable;
+
 struct summonBlock_t
 {
 	std::string name;
@@ -87,9 +94,8 @@ class MonsterType
 
 		void reset();
 
+		void compileLoot(double rate);
 		void dropLoot(Container* corpse);
-		ItemList createLoot(const LootBlock& lootBlock);
-		bool createChildLoot(Container* parent, const LootBlock& lootBlock);
 
 		bool isSummonable, isIllusionable, isConvinceable, isAttackable, isHostile, isLureable,
 			isWalkable, canPushItems, canPushCreatures, pushable, hideName, hideHealth;
@@ -116,6 +122,15 @@ class MonsterType
 		SpellList spellDefenseList;
 		VoiceVector voiceVector;
 		StringVec scriptList;
+
+	protected:
+		uint32_t compileLoot(const LootItems& items, double rate);
+		void createLoot(Container* parent, uint32_t begin, uint32_t end);
+		void createLootItem(Container* parent, const LootEntry& entry);
+
+		//lootItems flattened, roots first and children of every entry kept contiguous
+		LootTable lootTable;
+		uint32_t lootRoots;
 };
 
 class Monsters
@@ -134,7 +149,7 @@ class Monsters
 
 		uint32_t getIdByName(const std::string& name);
 		bool isLoaded() const {return loaded;}
-		static uint16_t getLootRandom();
+		void compileLoot();
 
 	private:
 		bool loaded;
@@ -593,11 +593,12 @@ uint32_t MoveEvents::onCreatureMove(Creature* actor, Creature* creature, const T
 
 		if((moveEvent = getEvent(tileItem, eventType)))
 		{
+			tileItem = const_cast<Tile*>(tile)->unshareItem(tileItem);
 			m_lastCacheItemVector.push_back(tileItem);
 			ret &= moveEvent->fireStepEvent(actor, creature, tileItem, tile->getPosition(), fromPos, toPos);
 		}
 		else if(hasTileEvent(tileItem))
-			m_lastCacheItemVector.push_back(tileItem);
+			m_lastCacheItemVector.push_back(const_cast<Tile*>(tile)->unshareItem(tileItem));
 	}
 
 	return ret;
@@ -666,11 +667,12 @@ uint32_t MoveEvents::onItemMove(Creature* actor, Item* item, Tile* tile, bool is
 
 		if((moveEvent = getEvent(tileItem, tileEventType)))
 		{
+			tileItem = tile->unshareItem(tileItem);
 			m_lastCacheItemVector.push_back(tileItem);
 			ret &= moveEvent->fireAddRemItem(actor, item, tileItem, tile->getPosition());
 		}
 		else if(hasTileEvent(tileItem))
-			m_lastCacheItemVector.push_back(tileItem);
+			m_lastCacheItemVector.push_back(tile->unshareItem(tileItem));
 	}
 
 	return ret;
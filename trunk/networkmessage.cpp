@@ -185,6 +185,16 @@ void NetworkMessage::putString(const char* value, bool addSize/* = true*/)
 	m_size += size;
 }
 
+void NetworkMessage::putRaw(const char* value, uint32_t size)
+{
+	if(!hasSpace(size))
+		return;
+
+	memcpy(m_buffer + m_position, value, size);
+	m_position += size;
+	m_size += size;
+}
+
 void NetworkMessage::putPadding(uint32_t amount)
 {
 	if(!hasSpace(amount))
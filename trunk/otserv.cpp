@@ -30,6 +30,7 @@
 #endif
 #include <boost/config.hpp>
 
+#include <openssl/crypto.h>
 #include <openssl/rsa.h>
 #include <openssl/bn.h>
 #include <openssl/err.h>
@@ -99,6 +100,39 @@ boost::condition_variable g_loaderSignal;
 boost::unique_lock<boost::mutex> g_loaderUniqueLock(g_loaderLock);
 std::list<std::pair<uint32_t, uint32_t> > serverIps;
 
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+#ifdef _MSC_VER
+#define OTSERV_THREAD_LOCAL __declspec(thread)
+#else
+#define OTSERV_THREAD_LOCAL __thread
+#endif
+
+// login workers decrypt with g_RSA at once, OpenSSL before 1.1 needs
+// these to guard its shared state (the blinding and Montgomery caches)
+static boost::mutex* sslLocks = NULL;
+static OTSERV_THREAD_LOCAL char sslThread = 0;
+
+static void sslLockingCallback(int mode, int n, const char*, int)
+{
+	if(mode & CRYPTO_LOCK)
+		sslLocks[n].lock();
+	else
+		sslLocks[n].unlock();
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x10000000L
+static void sslThreadId(CRYPTO_THREADID* id)
+{
+	CRYPTO_THREADID_set_pointer(id, &sslThread);
+}
+#else
+static unsigned long sslThreadId()
+{
+	return (unsigned long)&sslThread;
+}
+#endif
+#endif
+
 bool argumentsHandler(StringVec args)
 {
 	StringVec tmp;
@@ -249,8 +283,13 @@ void allocationHandler()
 	exit(-1);
 }
 
+static boost::thread* mapLoader = NULL;
+
 void startupErrorMessage(std::string error = "")
 {
+	if(mapLoader) //exit must not tear down what the map decode is still using
+		mapLoader->join();
+
 	if(error.length() > 0)
 		std::clog << std::endl << "> ERROR: " << error << std::endl;
 
@@ -258,10 +297,23 @@ void startupErrorMessage(std::string error = "")
 	exit(-1);
 }
 
+void startupPhase(int64_t& start)
+{
+	int64_t now = OTSYS_TIME();
+	std::clog << "> Done in " << (now - start) / (1000.) << " seconds." << std::endl;
+	start = now;
+}
+
+void loadMapTiles(bool* loaded)
+{
+	*loaded = g_game.loadMap(g_config.getString(ConfigManager::MAP_NAME));
+}
+
 void otserv(StringVec args, ServiceManager* services);
 int main(int argc, char* argv[])
 {
 	std::srand((uint32_t)OTSYS_TIME());
+	random_seed((uint64_t)OTSYS_TIME());
 	StringVec args = StringVec(argv, argv + argc);
 	if(argc > 1 && !argumentsHandler(args))
 		return 0;
@@ -545,6 +597,16 @@ void otserv(StringVec, ServiceManager* services)
 	else
 		std::clog << "Ignoring version check, using SVN" << std::endl;
 
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+	sslLocks = new boost::mutex[CRYPTO_num_locks()];
+	CRYPTO_set_locking_callback(&sslLockingCallback);
+#if OPENSSL_VERSION_NUMBER >= 0x10000000L
+	CRYPTO_THREADID_set_callback(&sslThreadId);
+#else
+	CRYPTO_set_id_callback(&sslThreadId);
+#endif
+#endif
+
 	std::clog << ">> Loading RSA key";
 	g_RSA = RSA_new();
 
@@ -559,15 +621,28 @@ void otserv(StringVec, ServiceManager* services)
 	{
 		std::clog << std::endl << "> Calculating dmp1, dmq1 and iqmp for RSA...";
 
-		// Ok, now we calculate a few things, dmp1, dmq1 and iqmp
+		// Ok, now we calculate a few things, dmp1, dmq1 and iqmp, without
+		// them OpenSSL silently falls back to the full modulus exponentiation
 		BN_CTX* ctx = BN_CTX_new();
 		BN_CTX_start(ctx);
 
+		g_RSA->dmp1 = BN_new();
+		g_RSA->dmq1 = BN_new();
+		g_RSA->iqmp = BN_new();
+
 		BIGNUM *r1 = BN_CTX_get(ctx), *r2 = BN_CTX_get(ctx);
+		BN_sub(r1, g_RSA->p, BN_value_one());
+		BN_sub(r2, g_RSA->q, BN_value_one());
+
 		BN_mod(g_RSA->dmp1, g_RSA->d, r1, ctx);
 		BN_mod(g_RSA->dmq1, g_RSA->d, r2, ctx);
-
 		BN_mod_inverse(g_RSA->iqmp, g_RSA->q, g_RSA->p, ctx);
+
+		BN_CTX_end(ctx);
+		BN_CTX_free(ctx);
+
+		// keep the Montgomery contexts of p, q and n between decrypts
+		g_RSA->flags |= RSA_FLAG_CACHE_PUBLIC | RSA_FLAG_CACHE_PRIVATE;
 		std::clog << " done" << std::endl;
 	}
 	else
@@ -608,10 +683,12 @@ void otserv(StringVec, ServiceManager* services)
 	else
 		startupErrorMessage("Couldn't estabilish connection to SQL database!");
 
+	int64_t phase = OTSYS_TIME();
 	std::clog << ">> Loading items (OTB)" << std::endl;
 	if(Item::items.loadFromOtb(getFilePath(FILE_TYPE_OTHER, "items/items.otb")))
 		startupErrorMessage("Unable to load items (OTB)!");
 
+	startupPhase(phase);
 	std::clog << ">> Loading items (XML)" << std::endl;
 	if(!Item::items.loadFromXml())
 	{
@@ -621,31 +698,39 @@ void otserv(StringVec, ServiceManager* services)
 			startupErrorMessage("Unable to load items (XML)!");
 	}
 
+	startupPhase(phase);
 	std::clog << ">> Loading groups" << std::endl;
 	if(!Groups::getInstance()->loadFromXml())
 		startupErrorMessage("Unable to load groups!");
 
+	startupPhase(phase);
 	std::clog << ">> Loading vocations" << std::endl;
 	if(!Vocations::getInstance()->loadFromXml())
 		startupErrorMessage("Unable to load vocations!");
 
+	startupPhase(phase);
 	std::clog << ">> Loading outfits" << std::endl;
 	if(!Outfits::getInstance()->loadFromXml())
 		startupErrorMessage("Unable to load outfits!");
 
+	startupPhase(phase);
 	std::clog << ">> Loading mounts" << std::endl;
 	if(!Mounts::getInstance()->loadFromXml())
 		startupErrorMessage("Unable to load mounts!");
 
+	startupPhase(phase);
 	std::clog << ">> Loading chat channels" << std::endl;
 	if(!g_chat.loadFromXml())
 		startupErrorMessage("Unable to load chat channels!");
 
+	startupPhase(phase);
 	if(g_config.getBool(ConfigManager::SCRIPT_SYSTEM))
 	{
 		std::clog << ">> Loading script systems" << std::endl;
 		if(!ScriptManager::getInstance()->loadSystem())
 			startupErrorMessage();
+
+		startupPhase(phase);
 	}
 	else
 		ScriptManager::getInstance();
@@ -654,18 +739,38 @@ void otserv(StringVec, ServiceManager* services)
 	if(!ScriptManager::getInstance()->loadMods())
 		startupErrorMessage();
 
+	startupPhase(phase);
+	//tiles only need the item types, final once mods added theirs, so decode the
+	//map while the rest is loading; its result is reported once monsters are done
+	std::clog << ">> Loading map (in background)" << std::endl;
+
+	bool mapLoaded = false;
+	int64_t mapStart = OTSYS_TIME();
+	mapLoader = new boost::thread(boost::bind(&loadMapTiles, &mapLoaded));
+
 	#ifdef __LOGIN_SERVER__
 	std::clog << ">> Loading game servers" << std::endl;
 	if(!GameServers::getInstance()->loadFromXml(true))
 		startupErrorMessage("Unable to load game servers!");
 
+	startupPhase(phase);
 	#endif
 	std::clog << ">> Loading experience stages" << std::endl;
 	if(!g_game.loadExperienceStages())
 		startupErrorMessage("Unable to load experience stages!");
 
+	startupPhase(phase);
 	std::clog << ">> Loading monsters" << std::endl;
-	if(!g_monsters.loadFromXml())
+	bool monstersLoaded = g_monsters.loadFromXml();
+
+	startupPhase(phase);
+	mapLoader->join();
+	delete mapLoader;
+	mapLoader = NULL;
+
+	std::clog << "> Map ready after " << (OTSYS_TIME() - mapStart) / (1000.) << " seconds ("
+		<< (OTSYS_TIME() - phase) / (1000.) << " spent waiting)." << std::endl;
+	if(!monstersLoaded)
 	{
 		std::clog << "Unable to load monsters! Continue? (y/N)" << std::endl;
 		char buffer = getch();
@@ -673,10 +778,17 @@ void otserv(StringVec, ServiceManager* services)
 			startupErrorMessage("Unable to load monsters!");
 	}
 
-	std::clog << ">> Loading map and spawns..." << std::endl;
-	if(!g_game.loadMap(g_config.getString(ConfigManager::MAP_NAME)))
+	if(!mapLoaded)
 		startupErrorMessage();
 
+	phase = OTSYS_TIME();
+
+	std::clog << ">> Loading spawns and houses..." << std::endl;
+	if(!g_game.loadMapData())
+		startupErrorMessage();
+
+	startupPhase(phase);
+
 	std::clog << ">> Checking world type... ";
 	std::string worldType = asLowerCaseString(g_config.getString(ConfigManager::WORLD_TYPE));
 	if(worldType == "open" || worldType == "2" || worldType == "openpvp")
@@ -701,6 +813,10 @@ void otserv(StringVec, ServiceManager* services)
 	}
 
 	std::clog << ">> Initializing game state and binding services..." << std::endl;
+	TaskPool::getInstance(TASKPOOL_CPU).start(g_config.getNumber(ConfigManager::LOGIN_CPU_THREADS));
+	TaskPool::getInstance(TASKPOOL_DATABASE).start(g_config.getNumber(ConfigManager::LOGIN_DATABASE_THREADS),
+		boost::bind(&Database::connectThread));
+
 	g_game.setGameState(GAMESTATE_INIT);
 	IPAddressList ipList;
 
@@ -82,54 +82,62 @@ void OutputMessagePool::send(OutputMessage_ptr msg)
 
 void OutputMessagePool::sendAll()
 {
-	boost::recursive_mutex::scoped_lock lockClass(m_outputPoolLock);
-	OutputMessageList::iterator it;
-	for(it = m_addQueue.begin(); it != m_addQueue.end();)
+	OutputMessageList sendList;
 	{
-		//drop messages that are older than 10 seconds
-		if(OTSYS_TIME() - (*it)->getFrame() > 10000)
+		boost::recursive_mutex::scoped_lock lockClass(m_outputPoolLock);
+		OutputMessageList::iterator it;
+		for(it = m_addQueue.begin(); it != m_addQueue.end();)
 		{
-			if((*it)->getProtocol())
-				(*it)->getProtocol()->onSendMessage(*it);
+			//drop messages that are older than 10 seconds
+			if(OTSYS_TIME() - (*it)->getFrame() > 10000)
+			{
+				if((*it)->getProtocol())
+					(*it)->getProtocol()->onSendMessage(*it);
 
-			it = m_addQueue.erase(it);
-			continue;
-		}
+				it = m_addQueue.erase(it);
+				continue;
+			}
 
-		(*it)->setState(OutputMessage::STATE_ALLOCATED);
-		m_autoSend.push_back(*it);
-		++it;
-	}
+			(*it)->setState(OutputMessage::STATE_ALLOCATED);
+			m_autoSend.push_back(*it);
+			++it;
+		}
 
-	m_addQueue.clear();
-	for(it = m_autoSend.begin(); it != m_autoSend.end();)
-	{
-		OutputMessage_ptr omsg = (*it);
-		#ifdef __NO_PLAYER_SENDBUFFER__
-		//use this define only for debugging
-		if(true)
-		#else
-		//It will send only messages bigger then 1 kb or with a lifetime greater than 10 ms
-		if(omsg->size() > 1024 || (m_frameTime - omsg->getFrame() > 10))
-		#endif
+		m_addQueue.clear();
+		for(it = m_autoSend.begin(); it != m_autoSend.end();)
 		{
-			#ifdef __DEBUG_NET_DETAIL__
-			std::clog << "Sending message - ALL" << std::endl;
+			#ifdef __NO_PLAYER_SENDBUFFER__
+			//use this define only for debugging
+			if(true)
+			#else
+			//It will send only messages bigger then 1 kb or with a lifetime greater than 10 ms
+			if((*it)->size() > 1024 || (m_frameTime - (*it)->getFrame() > 10))
 			#endif
-			if(omsg->getConnection())
 			{
-				if(!omsg->getConnection()->send(omsg) && omsg->getProtocol())
-					omsg->getProtocol()->onSendMessage(omsg);
+				sendList.push_back(*it);
+				it = m_autoSend.erase(it);
 			}
-			#ifdef __DEBUG_NET__
 			else
-				std::clog << "[Error - OutputMessagePool::send] NULL connection." << std::endl;
-			#endif
+				++it;
+		}
+	}
 
-			it = m_autoSend.erase(it);
+	//connections lock themselves and may queue back into the pool, so send unlocked
+	for(OutputMessageList::iterator it = sendList.begin(); it != sendList.end(); ++it)
+	{
+		OutputMessage_ptr omsg = (*it);
+		#ifdef __DEBUG_NET_DETAIL__
+		std::clog << "Sending message - ALL" << std::endl;
+		#endif
+		if(omsg->getConnection())
+		{
+			if(!omsg->getConnection()->send(omsg) && omsg->getProtocol())
+				omsg->getProtocol()->onSendMessage(omsg);
 		}
+		#ifdef __DEBUG_NET__
 		else
-			++it;
+			std::clog << "[Error - OutputMessagePool::send] NULL connection." << std::endl;
+		#endif
 	}
 }
 
@@ -19,6 +19,7 @@
 
 #include "player.h"
 #include "manager.h"
+#include "status.h"
 
 #include "iologindata.h"
 #include "ioban.h"
@@ -56,7 +57,7 @@ Player::Player(const std::string& _name, ProtocolGame* p):
 	if(client)
 		client->setPlayer(this);
 
-	pvpBlessing = pzLocked = isConnecting = addAttackSkillPoint = requestedOutfit = mounted = false;
+	legacyDepots = pvpBlessing = pzLocked = isConnecting = addAttackSkillPoint = requestedOutfit = mounted = false;
 	saving = true;
 
 	lastAttackBlockType = BLOCK_NONE;
@@ -2419,6 +2420,7 @@ void Player::removeList()
 {
 	Manager::getInstance()->removeUser(id);
 	autoList.erase(id);
+	Status::getInstance()->invalidate();
 	if(!isGhost())
 	{
 		for(AutoList<Player>::iterator it = autoList.begin(); it != autoList.end(); ++it)
@@ -2452,6 +2454,7 @@ void Player::addList()
 
 	autoList[id] = this;
 	Manager::getInstance()->addUser(this);
+	Status::getInstance()->invalidate();
 }
 
 void Player::kick(bool displayEffect, bool forceLogout)
@@ -741,6 +741,8 @@ class Player : public Creature, public Cylinder
 		InvitedToGuildsList invitedToGuildsList;
 		ConditionList storedConditionList;
 		DepotMap depots;
+		std::set<uint32_t> brokenDepots; //stored, but failed to load, so never written over
+		bool legacyDepots;
 
 		uint32_t marriage;
 		uint64_t balance;
@@ -29,6 +29,25 @@
 #include <openssl/rsa.h>
 extern RSA* g_RSA;
 
+LatencyHistogram Protocol::loginLatency[LOGINSTAGE_LAST + 1];
+
+LoginRequest::LoginRequest(Protocol* _protocol, NetworkMessage& _msg):
+	protocol(_protocol), connection(_protocol->getConnection())
+{
+	memcpy(msg.buffer(), _msg.buffer(), _msg.size());
+	msg.setSize(_msg.size());
+	msg.setPosition(_msg.position());
+
+	ip = _protocol->getIP();
+	for(int8_t i = 0; i < 4; ++i)
+		key[i] = 0;
+
+	version = 0;
+	operatingSystem = CLIENTOS_LINUX;
+	gamemaster = decrypted = failed = false;
+	started = boost::posix_time::microsec_clock::universal_time();
+}
+
 void Protocol::onSendMessage(OutputMessage_ptr msg)
 {
 	#ifdef __DEBUG_NET_DETAIL__
@@ -188,12 +207,11 @@ bool Protocol::XTEA_decrypt(NetworkMessage& msg)
 	return true;
 }
 
-bool Protocol::RSA_decrypt(NetworkMessage& msg)
+bool Protocol::RSA_decrypt(NetworkMessage& msg, uint32_t ip)
 {
 	if(msg.size() - msg.position() != 128)
 	{
 		std::clog << "[Warning - Protocol::RSA_decrypt] Not valid packet size";
-		int32_t ip = getIP();
 		if(ip)
 			std::clog << " (IP: " << convertIPAddress(ip) << ")";
 
@@ -210,7 +228,6 @@ bool Protocol::RSA_decrypt(NetworkMessage& msg)
 		return true;
 
 	std::clog << "[Warning - Protocol::RSA_decrypt] First byte != 0";
-	int32_t ip = getIP();
 	if(ip)
 		std::clog << " (IP: " << convertIPAddress(ip) << ")";
 
@@ -218,6 +235,48 @@ bool Protocol::RSA_decrypt(NetworkMessage& msg)
 	return false;
 }
 
+void Protocol::addLoginTask(LoginRequest_ptr request, LoginStage_t stage, LoginTask task)
+{
+	request->queued = boost::posix_time::microsec_clock::universal_time();
+	if(stage == LOGINSTAGE_DECRYPT) //the next packet may only be read once the key is installed
+		request->connection->pauseRead();
+
+	Task* tmp = createTask(boost::bind(&Protocol::runLoginTask, request, stage, task));
+	switch(stage)
+	{
+		case LOGINSTAGE_DECRYPT:
+		case LOGINSTAGE_PASSWORD:
+			TaskPool::getInstance(TASKPOOL_CPU).addTask(tmp);
+			break;
+
+		case LOGINSTAGE_ACCOUNT:
+		case LOGINSTAGE_BAN:
+			TaskPool::getInstance(TASKPOOL_DATABASE).addTask(tmp);
+			break;
+
+		default:
+			Dispatcher::getInstance().addTask(tmp);
+			break;
+	}
+}
+
+void Protocol::runLoginTask(LoginRequest_ptr request, LoginStage_t stage, LoginTask task)
+{
+	boost::posix_time::ptime queued = request->queued;
+	if(stage == LOGINSTAGE_INSTALL && request->connection->getProtocol() != request->protocol)
+		return; //connection got closed meanwhile, the protocol is gone
+
+	task(request);
+	if(stage == LOGINSTAGE_INSTALL)
+		request->connection->resumeRead();
+
+	boost::posix_time::ptime now = boost::posix_time::microsec_clock::universal_time();
+
+	loginLatency[stage].add((now - queued).total_microseconds());
+	if(stage == LOGINSTAGE_INSTALL)
+		loginLatency[LOGINSTAGE_TOTAL].add((now - request->started).total_microseconds());
+}
+
 uint32_t Protocol::getIP() const
 {
 	if(Connection_ptr connection = getConnection())
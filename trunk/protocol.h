@@ -18,11 +18,54 @@
 #ifndef __PROTOCOL__
 #define __PROTOCOL__
 #include "otsystem.h"
+#include "enums.h"
+
 #include "connection.h"
+#include "dispatcher.h"
+#include "account.h"
 
 class OutputMessage;
 class Connection;
 class NetworkMessage;
+class Protocol;
+
+enum LoginStage_t
+{
+	LOGINSTAGE_DECRYPT = 0,
+	LOGINSTAGE_ACCOUNT,
+	LOGINSTAGE_PASSWORD,
+	LOGINSTAGE_BAN,
+	LOGINSTAGE_INSTALL,
+	LOGINSTAGE_TOTAL,
+	LOGINSTAGE_LAST = LOGINSTAGE_TOTAL
+};
+
+class LoginRequest;
+typedef boost::shared_ptr<LoginRequest> LoginRequest_ptr;
+typedef void (*LoginTask)(LoginRequest_ptr);
+
+// first packet of a login, carried through the worker stages; the protocol
+// itself is only touched again in the final (dispatcher) stage
+class LoginRequest
+{
+	public:
+		LoginRequest(Protocol* _protocol, NetworkMessage& _msg);
+		virtual ~LoginRequest() {}
+
+		Protocol* protocol;
+		Connection_ptr connection;
+		NetworkMessage msg;
+
+		Account account;
+		std::string name, password, character, error;
+
+		uint32_t ip, key[4];
+		uint16_t version;
+		OperatingSystem_t operatingSystem;
+		bool gamemaster, decrypted, failed;
+
+		boost::posix_time::ptime started, queued;
+};
 
 class Protocol : boost::noncopyable
 {
@@ -54,6 +97,9 @@ class Protocol : boost::noncopyable
 		int32_t addRef() {return ++m_refCount;}
 		int32_t unRef() {return --m_refCount;}
 
+		static void addLoginTask(LoginRequest_ptr request, LoginStage_t stage, LoginTask task);
+		static LatencyHistogram loginLatency[LOGINSTAGE_LAST + 1];
+
 	protected:
 		//use this function for autosend messages only
 		OutputMessage_ptr getOutputBuffer();
@@ -68,7 +114,10 @@ class Protocol : boost::noncopyable
 
 		void XTEA_encrypt(OutputMessage& msg);
 		bool XTEA_decrypt(NetworkMessage& msg);
-		bool RSA_decrypt(NetworkMessage& msg);
+		bool RSA_decrypt(NetworkMessage& msg) {return RSA_decrypt(msg, getIP());}
+		static bool RSA_decrypt(NetworkMessage& msg, uint32_t ip);
+
+		static void runLoginTask(LoginRequest_ptr request, LoginStage_t stage, LoginTask task);
 
 		virtual void releaseProtocol();
 		virtual void deleteProtocolTask();
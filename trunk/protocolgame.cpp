@@ -409,78 +409,125 @@ bool ProtocolGame::parseFirstPacket(NetworkMessage& msg)
 
 	OperatingSystem_t operatingSystem = (OperatingSystem_t)msg.get<uint16_t>();
 	uint16_t version = msg.get<uint16_t>();
-	if(!RSA_decrypt(msg))
+
+	LoginRequest_ptr request(new LoginRequest(this, msg));
+	request->operatingSystem = operatingSystem;
+	request->version = version;
+
+	addLoginTask(request, LOGINSTAGE_DECRYPT, &ProtocolGame::decryptTask);
+	return true;
+}
+
+void ProtocolGame::decryptTask(LoginRequest_ptr request)
+{
+	//cpu pool
+	NetworkMessage& msg = request->msg;
+	if(!RSA_decrypt(msg, request->ip))
 	{
-		getConnection()->close();
-		return false;
+		request->failed = true;
+		addLoginTask(request, LOGINSTAGE_INSTALL, &ProtocolGame::installTask);
+		return;
 	}
 
-	uint32_t key[4] = {msg.get<uint32_t>(), msg.get<uint32_t>(), msg.get<uint32_t>(), msg.get<uint32_t>()};
-	enableXTEAEncryption();
-	setXTEAKey(key);
+	for(int8_t i = 0; i < 4; ++i)
+		request->key[i] = msg.get<uint32_t>();
+
+	request->decrypted = true;
+	request->gamemaster = (msg.get<char>() != (char)0);
 
-	bool gamemaster = (msg.get<char>() != (char)0);
-	std::string name = msg.getString(), character = msg.getString(), password = msg.getString();
+	request->name = msg.getString();
+	request->character = msg.getString();
+	request->password = msg.getString();
 
 	msg.skip(6); //841- wtf?
-	if(version < CLIENT_VERSION_MIN || version > CLIENT_VERSION_MAX)
+	request->failed = true;
+	if(request->version < CLIENT_VERSION_MIN || request->version > CLIENT_VERSION_MAX)
 	{
-		disconnectClient(0x14, CLIENT_VERSION_STRING);
-		return false;
+		request->error = CLIENT_VERSION_STRING;
+		addLoginTask(request, LOGINSTAGE_INSTALL, &ProtocolGame::installTask);
+		return;
 	}
 
-	if(name.empty())
+	if(request->name.empty())
 	{
 		if(!g_config.getBool(ConfigManager::ACCOUNT_MANAGER))
 		{
-			disconnectClient(0x14, "Invalid account name.");
-			return false;
+			request->error = "Invalid account name.";
+			addLoginTask(request, LOGINSTAGE_INSTALL, &ProtocolGame::installTask);
+			return;
 		}
 
-		name = "1";
-		password = "1";
+		request->name = "1";
+		request->password = "1";
 	}
 
 	if(g_game.getGameState() < GAMESTATE_NORMAL)
-	{
-		disconnectClient(0x14, "Gameworld is just starting up, please wait.");
-		return false;
-	}
+		request->error = "Gameworld is just starting up, please wait.";
+	else if(g_game.getGameState() == GAMESTATE_MAINTAIN)
+		request->error = "Gameworld is under maintenance, please re-connect in a while.";
+	else if(ConnectionManager::getInstance()->isDisabled(request->ip, protocolId))
+		request->error = "Too many connections attempts from your IP address, please try again later.";
+	else
+		request->failed = false;
 
-	if(g_game.getGameState() == GAMESTATE_MAINTAIN)
-	{
-		disconnectClient(0x14, "Gameworld is under maintenance, please re-connect in a while.");
-		return false;
-	}
+	addLoginTask(request, request->failed ? LOGINSTAGE_INSTALL : LOGINSTAGE_ACCOUNT,
+		request->failed ? &ProtocolGame::installTask : &ProtocolGame::accountTask);
+}
 
-	if(ConnectionManager::getInstance()->isDisabled(getIP(), protocolId))
+void ProtocolGame::accountTask(LoginRequest_ptr request)
+{
+	//database pool
+	request->failed = true;
+	if(IOBan::getInstance()->isIpBanished(request->ip))
 	{
-		disconnectClient(0x14, "Too many connections attempts from your IP address, please try again later.");
-		return false;
+		request->error = "Your IP is banished!";
+		addLoginTask(request, LOGINSTAGE_INSTALL, &ProtocolGame::installTask);
+		return;
 	}
 
-	if(IOBan::getInstance()->isIpBanished(getIP()))
+	uint32_t id = 1;
+	if(!IOLoginData::getInstance()->getAccountId(request->name, id))
 	{
-		disconnectClient(0x14, "Your IP is banished!");
-		return false;
+		ConnectionManager::getInstance()->addAttempt(request->ip, protocolId, false);
+		request->error = "Invalid account name.";
+		addLoginTask(request, LOGINSTAGE_INSTALL, &ProtocolGame::installTask);
+		return;
 	}
 
-	uint32_t id = 1;
-	if(!IOLoginData::getInstance()->getAccountId(name, id))
+	Account& account = request->account;
+	account.number = id;
+	if(!IOLoginData::getInstance()->getPassword(id, account.password, account.salt, request->character))
 	{
-		ConnectionManager::getInstance()->addAttempt(getIP(), protocolId, false);
-		disconnectClient(0x14, "Invalid account name.");
-		return false;
+		ConnectionManager::getInstance()->addAttempt(request->ip, protocolId, false);
+		request->error = "Invalid password.";
+		addLoginTask(request, LOGINSTAGE_INSTALL, &ProtocolGame::installTask);
+		return;
 	}
 
-	std::string hash, salt;
-	if(!IOLoginData::getInstance()->getPassword(id, hash, salt, character) || !encryptTest(salt + password, hash))
+	request->failed = false;
+	addLoginTask(request, LOGINSTAGE_PASSWORD, &ProtocolGame::passwordTask);
+}
+
+void ProtocolGame::passwordTask(LoginRequest_ptr request)
+{
+	//cpu pool
+	if(encryptTest(request->account.salt + request->password, request->account.password))
 	{
-		ConnectionManager::getInstance()->addAttempt(getIP(), protocolId, false);
-		disconnectClient(0x14, "Invalid password.");
-		return false;
+		addLoginTask(request, LOGINSTAGE_BAN, &ProtocolGame::banTask);
+		return;
 	}
 
+	ConnectionManager::getInstance()->addAttempt(request->ip, protocolId, false);
+	request->failed = true;
+	request->error = "Invalid password.";
+	addLoginTask(request, LOGINSTAGE_INSTALL, &ProtocolGame::installTask);
+}
+
+void ProtocolGame::banTask(LoginRequest_ptr request)
+{
+	//database pool
+	uint32_t id = request->account.number;
+
 	Ban ban;
 	ban.value = id;
 
@@ -500,14 +547,32 @@ bool ProtocolGame::parseFirstPacket(NetworkMessage& msg)
 			   << ".\nThe comment given was:\n" << ban.comment.c_str() << ".\nYour " << (deletion ? "account won't be undeleted" : "banishment will be lifted at:\n")
 			   << (deletion ? "" : formatDateEx(ban.expires).c_str()) << ".";
 
-		disconnectClient(0x14, stream.str().c_str());
-		return false;
+		request->failed = true;
+		request->error = stream.str();
 	}
+	else
+		ConnectionManager::getInstance()->addAttempt(request->ip, protocolId, true);
 
-	ConnectionManager::getInstance()->addAttempt(getIP(), protocolId, true);
-	Dispatcher::getInstance().addTask(createTask(boost::bind(
-		&ProtocolGame::login, this, character, id, password, operatingSystem, version, gamemaster)));
-	return true;
+	addLoginTask(request, LOGINSTAGE_INSTALL, &ProtocolGame::installTask);
+}
+
+void ProtocolGame::installTask(LoginRequest_ptr request)
+{
+	//dispatcher thread
+	ProtocolGame* protocol = static_cast<ProtocolGame*>(request->protocol);
+	if(request->decrypted)
+	{
+		protocol->enableXTEAEncryption();
+		protocol->setXTEAKey(request->key);
+	}
+
+	if(!request->failed)
+		protocol->login(request->character, request->account.number, request->password,
+			request->operatingSystem, request->version, request->gamemaster);
+	else if(request->error.empty())
+		protocol->getConnection()->close();
+	else
+		protocol->disconnectClient(0x14, request->error.c_str());
 }
 
 void ProtocolGame::parsePacket(NetworkMessage &msg)
@@ -91,6 +91,12 @@ class ProtocolGame : public Protocol
 		bool parseFirstPacket(NetworkMessage& msg);
 		virtual void parsePacket(NetworkMessage& msg);
 
+		static void decryptTask(LoginRequest_ptr request);
+		static void accountTask(LoginRequest_ptr request);
+		static void passwordTask(LoginRequest_ptr request);
+		static void banTask(LoginRequest_ptr request);
+		static void installTask(LoginRequest_ptr request);
+
 		//Parse methods
 		void parseLogout(NetworkMessage& msg);
 		void parseCancelMove(NetworkMessage& msg);
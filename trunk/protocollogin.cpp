@@ -68,79 +68,109 @@ bool ProtocolLogin::parseFirstPacket(NetworkMessage& msg)
 		return false;
 	}
 
-	uint32_t clientIp = getConnection()->getIP();
 	/*uint16_t operatingSystem = msg.get<uint16_t>();*/msg.skip(2);
 	uint16_t version = msg.get<uint16_t>();
 
 	msg.skip(12);
-	if(!RSA_decrypt(msg))
+	LoginRequest_ptr request(new LoginRequest(this, msg));
+	request->version = version;
+
+	addLoginTask(request, LOGINSTAGE_DECRYPT, &ProtocolLogin::decryptTask);
+	return true;
+}
+
+void ProtocolLogin::decryptTask(LoginRequest_ptr request)
+{
+	//cpu pool
+	NetworkMessage& msg = request->msg;
+	if(!RSA_decrypt(msg, request->ip))
 	{
-		getConnection()->close();
-		return false;
+		request->failed = true;
+		addLoginTask(request, LOGINSTAGE_INSTALL, &ProtocolLogin::installTask);
+		return;
 	}
 
-	uint32_t key[4] = {msg.get<uint32_t>(), msg.get<uint32_t>(), msg.get<uint32_t>(), msg.get<uint32_t>()};
-	enableXTEAEncryption();
-	setXTEAKey(key);
+	for(int8_t i = 0; i < 4; ++i)
+		request->key[i] = msg.get<uint32_t>();
+
+	request->decrypted = true;
+	request->name = msg.getString();
+	request->password = msg.getString();
 
-	std::string name = msg.getString(), password = msg.getString();
-	if(name.empty())
+	request->failed = true;
+	if(request->name.empty())
 	{
 		if(!g_config.getBool(ConfigManager::ACCOUNT_MANAGER))
 		{
-			disconnectClient(0x0A, "Invalid account name.");
-			return false;
+			request->error = "Invalid account name.";
+			addLoginTask(request, LOGINSTAGE_INSTALL, &ProtocolLogin::installTask);
+			return;
 		}
 
-		name = "1";
-		password = "1";
+		request->name = "1";
+		request->password = "1";
 	}
 
-	if(version < CLIENT_VERSION_MIN || version > CLIENT_VERSION_MAX)
-	{
-		disconnectClient(0x0A, CLIENT_VERSION_STRING);
-		return false;
-	}
+	if(request->version < CLIENT_VERSION_MIN || request->version > CLIENT_VERSION_MAX)
+		request->error = CLIENT_VERSION_STRING;
+	else if(g_game.getGameState() < GAMESTATE_NORMAL)
+		request->error = "Server is just starting up, please wait.";
+	else if(g_game.getGameState() == GAMESTATE_MAINTAIN)
+		request->error = "Server is under maintenance, please re-connect in a while.";
+	else if(ConnectionManager::getInstance()->isDisabled(request->ip, protocolId))
+		request->error = "Too many connections attempts from your IP address, please try again later.";
+	else
+		request->failed = false;
+
+	addLoginTask(request, request->failed ? LOGINSTAGE_INSTALL : LOGINSTAGE_ACCOUNT,
+		request->failed ? &ProtocolLogin::installTask : &ProtocolLogin::accountTask);
+}
 
-	if(g_game.getGameState() < GAMESTATE_NORMAL)
+void ProtocolLogin::accountTask(LoginRequest_ptr request)
+{
+	//database pool
+	request->failed = true;
+	if(IOBan::getInstance()->isIpBanished(request->ip))
 	{
-		disconnectClient(0x0A, "Server is just starting up, please wait.");
-		return false;
+		request->error = "Your IP is banished!";
+		addLoginTask(request, LOGINSTAGE_INSTALL, &ProtocolLogin::installTask);
+		return;
 	}
 
-	if(g_game.getGameState() == GAMESTATE_MAINTAIN)
+	uint32_t id = 1;
+	if(!IOLoginData::getInstance()->getAccountId(request->name, id))
 	{
-		disconnectClient(0x0A, "Server is under maintenance, please re-connect in a while.");
-		return false;
+		ConnectionManager::getInstance()->addAttempt(request->ip, protocolId, false);
+		request->error = "Invalid account name.";
+		addLoginTask(request, LOGINSTAGE_INSTALL, &ProtocolLogin::installTask);
+		return;
 	}
 
-	if(ConnectionManager::getInstance()->isDisabled(clientIp, protocolId))
-	{
-		disconnectClient(0x0A, "Too many connections attempts from your IP address, please try again later.");
-		return false;
-	}
+	request->failed = false;
+	request->account = IOLoginData::getInstance()->loadAccount(id);
+	addLoginTask(request, LOGINSTAGE_PASSWORD, &ProtocolLogin::passwordTask);
+}
 
-	if(IOBan::getInstance()->isIpBanished(clientIp))
+void ProtocolLogin::passwordTask(LoginRequest_ptr request)
+{
+	//cpu pool
+	if(encryptTest(request->account.salt + request->password, request->account.password))
 	{
-		disconnectClient(0x0A, "Your IP is banished!");
-		return false;
+		addLoginTask(request, LOGINSTAGE_BAN, &ProtocolLogin::banTask);
+		return;
 	}
 
-	uint32_t id = 1;
-	if(!IOLoginData::getInstance()->getAccountId(name, id))
-	{
-		ConnectionManager::getInstance()->addAttempt(clientIp, protocolId, false);
-		disconnectClient(0x0A, "Invalid account name.");
-		return false;
-	}
+	ConnectionManager::getInstance()->addAttempt(request->ip, protocolId, false);
+	request->failed = true;
+	request->error = "Invalid password.";
+	addLoginTask(request, LOGINSTAGE_INSTALL, &ProtocolLogin::installTask);
+}
 
-	Account account = IOLoginData::getInstance()->loadAccount(id);
-	if(!encryptTest(account.salt + password, account.password))
-	{
-		ConnectionManager::getInstance()->addAttempt(clientIp, protocolId, false);
-		disconnectClient(0x0A, "Invalid password.");
-		return false;
-	}
+void ProtocolLogin::banTask(LoginRequest_ptr request)
+{
+	//database pool
+	Account& account = request->account;
+	request->failed = true;
 
 	Ban ban;
 	ban.value = account.number;
@@ -160,22 +190,50 @@ bool ProtocolLogin::parseFirstPacket(NetworkMessage& msg)
 			   << name_.c_str() << ",\nfor the following reason:\n" << getReason(ban.reason).c_str() << ".\nThe action taken was:\n" << getAction(ban.action, false).c_str()
 			   << ".\nThe comment given was:\n" << ban.comment.c_str() << ".\nYour " << (deletion ? "account won't be undeleted" : "banishment will be lifted at:\n")
 			   << (deletion ? "" : formatDateEx(ban.expires).c_str()) << ".";
-		
-		disconnectClient(0x0A, stream.str().c_str());
-		return false;
+
+		request->error = stream.str();
+		addLoginTask(request, LOGINSTAGE_INSTALL, &ProtocolLogin::installTask);
+		return;
 	}
 
 	// remove premium days
 	IOLoginData::getInstance()->removePremium(account);
 	if(!g_config.getBool(ConfigManager::ACCOUNT_MANAGER) && !account.charList.size())
 	{
-		disconnectClient(0x0A, std::string("This account does not contain any character yet.\nCreate a new character on the "
-			+ g_config.getString(ConfigManager::SERVER_NAME) + " website at " + g_config.getString(ConfigManager::URL) + ".").c_str());
-		return false;
+		request->error = "This account does not contain any character yet.\nCreate a new character on the "
+			+ g_config.getString(ConfigManager::SERVER_NAME) + " website at " + g_config.getString(ConfigManager::URL) + ".";
+		addLoginTask(request, LOGINSTAGE_INSTALL, &ProtocolLogin::installTask);
+		return;
 	}
 
-	ConnectionManager::getInstance()->addAttempt(clientIp, protocolId, true);
-	if(OutputMessage_ptr output = OutputMessagePool::getInstance()->getOutputMessage(this, false))
+	ConnectionManager::getInstance()->addAttempt(request->ip, protocolId, true);
+	request->failed = false;
+	addLoginTask(request, LOGINSTAGE_INSTALL, &ProtocolLogin::installTask);
+}
+
+void ProtocolLogin::installTask(LoginRequest_ptr request)
+{
+	//dispatcher thread
+	ProtocolLogin* protocol = static_cast<ProtocolLogin*>(request->protocol);
+	if(request->decrypted)
+	{
+		protocol->enableXTEAEncryption();
+		protocol->setXTEAKey(request->key);
+	}
+
+	if(request->failed)
+	{
+		if(request->error.empty())
+			protocol->getConnection()->close();
+		else
+			protocol->disconnectClient(0x0A, request->error.c_str());
+
+		return;
+	}
+
+	Account& account = request->account;
+	uint32_t clientIp = request->ip;
+	if(OutputMessage_ptr output = OutputMessagePool::getInstance()->getOutputMessage(protocol, false))
 	{
 		TRACK_MESSAGE(output);
 		output->put<char>(0x14);
@@ -196,7 +254,7 @@ bool ProtocolLogin::parseFirstPacket(NetworkMessage& msg)
 
 		//Add char list
 		output->put<char>(0x64);
-		if(g_config.getBool(ConfigManager::ACCOUNT_MANAGER) && id != 1)
+		if(g_config.getBool(ConfigManager::ACCOUNT_MANAGER) && account.number != 1)
 		{
 			output->put<char>(account.charList.size() + 1);
 			output->putString("Account Manager");
@@ -224,7 +282,7 @@ bool ProtocolLogin::parseFirstPacket(NetworkMessage& msg)
 			output->put<uint32_t>(serverIp);
 			output->put<uint16_t>(g_config.getNumber(ConfigManager::GAME_PORT));
 			#else
-			if(version < it->second->getVersionMin() || version > it->second->getVersionMax())
+			if(request->version < it->second->getVersionMin() || request->version > it->second->getVersionMax())
 				continue;
 
 			output->putString(it->first);
@@ -243,6 +301,5 @@ bool ProtocolLogin::parseFirstPacket(NetworkMessage& msg)
 		OutputMessagePool::getInstance()->send(output);
 	}
 
-	getConnection()->close();
-	return true;
+	protocol->getConnection()->close();
 }
@@ -52,5 +52,11 @@ class ProtocolLogin : public Protocol
 
 		void disconnectClient(uint8_t error, const char* message);
 		bool parseFirstPacket(NetworkMessage& msg);
+
+		static void decryptTask(LoginRequest_ptr request);
+		static void accountTask(LoginRequest_ptr request);
+		static void passwordTask(LoginRequest_ptr request);
+		static void banTask(LoginRequest_ptr request);
+		static void installTask(LoginRequest_ptr request);
 };
 #endif
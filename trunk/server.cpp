@@ -131,8 +131,8 @@ void ServicePort::accept(Acceptor_ptr acceptor)
 	try
 	{
 		boost::asio::ip::tcp::socket* socket = new boost::asio::ip::tcp::socket(m_io_service);
-		acceptor->async_accept(*socket, boost::bind(
-			&ServicePort::handle, this, acceptor, socket, boost::asio::placeholders::error));
+		acceptor->async_accept(*socket, m_strand.wrap(boost::bind(
+			&ServicePort::handle, this, acceptor, socket, boost::asio::placeholders::error)));
 	}
 	catch(std::exception& e)
 	{
@@ -235,10 +235,26 @@ Protocol* ServicePort::makeProtocol(bool checksum, NetworkMessage& msg) const
 void ServiceManager::run()
 {
 	assert(!running);
+	m_threads = g_config.getNumber(ConfigManager::IO_THREADS);
+	if(!m_threads)
+		m_threads = std::max((uint32_t)1, (uint32_t)boost::thread::hardware_concurrency());
+
+	// handlers of a single connection are serialized through its strand,
+	// so any of these threads may pick up the next ready socket
+	boost::thread_group threads;
+	for(uint32_t i = 1; i < m_threads; ++i)
+		threads.create_thread(boost::bind(&ServiceManager::runThread, this));
+
+	runThread();
+	threads.join_all();
+	running = true;
+}
+
+void ServiceManager::runThread()
+{
 	try
 	{
 		m_io_service.run();
-		running = true;
 	}
 	catch(std::exception& e)
 	{
@@ -59,7 +59,7 @@ class ServicePort : boost::noncopyable, public boost::enable_shared_from_this<Se
 {
 	public:
 		ServicePort(boost::asio::io_service& io_service): m_io_service(io_service),
-			m_serverPort(0), m_pendingStart(false) {}
+			m_strand(io_service), m_serverPort(0), m_pendingStart(false) {}
 		virtual ~ServicePort() {close();}
 
 		static void services(boost::weak_ptr<ServicePort> weakService, IPAddressList ips, uint16_t port);
@@ -86,6 +86,8 @@ class ServicePort : boost::noncopyable, public boost::enable_shared_from_this<Se
 		AcceptorVec m_acceptors;
 
 		boost::asio::io_service& m_io_service;
+		boost::asio::io_service::strand m_strand;
+
 		uint16_t m_serverPort;
 		bool m_pendingStart;
 
@@ -96,7 +98,7 @@ class ServiceManager : boost::noncopyable
 {
 	ServiceManager(const ServiceManager&);
 	public:
-		ServiceManager(): m_io_service(), deathTimer(m_io_service), running(false) {}
+		ServiceManager(): m_io_service(), deathTimer(m_io_service), running(false), m_threads(0) {}
 		virtual ~ServiceManager() {stop();}
 
 		template <typename ProtocolType>
@@ -105,15 +107,19 @@ class ServiceManager : boost::noncopyable
 		void run();
 		void stop();
 
+		uint32_t getThreadCount() const {return m_threads;}
+
 		bool isRunning() const {return !m_acceptors.empty();}
 		std::list<uint16_t> getPorts() const;
 
 	protected:
 		void die() {m_io_service.stop();}
+		void runThread();
 
 		boost::asio::io_service m_io_service;
 		boost::asio::deadline_timer deathTimer;
 		bool running;
+		uint32_t m_threads;
 
 		typedef std::map<uint16_t, ServicePort_ptr> AcceptorsMap;
 		AcceptorsMap m_acceptors;
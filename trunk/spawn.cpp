@@ -36,7 +36,10 @@ extern Game g_game;
 
 Spawns::Spawns()
 {
-	loaded = started = false;
+	loaded = started = checking = false;
+	checkEvent = 0;
+	checkTime = startTime = 0;
+	respawnCount = blockedCount = 0;
 }
 
 Spawns::~Spawns()
@@ -203,6 +206,7 @@ void Spawns::startup()
 		g_game.placeCreature((*it), (*it)->getMasterPosition(), false, true);
 
 	npcList.clear();
+	startTime = OTSYS_TIME();
 	for(SpawnList::iterator it = spawnList.begin(); it != spawnList.end(); ++it)
 		(*it)->startup();
 
@@ -212,6 +216,15 @@ void Spawns::startup()
 void Spawns::clear()
 {
 	started = false;
+	if(checkEvent)
+	{
+		Scheduler::getInstance().stopEvent(checkEvent);
+		checkEvent = 0;
+	}
+
+	while(!respawnQueue.empty())
+		respawnQueue.pop();
+
 	for(SpawnList::iterator it = spawnList.begin(); it != spawnList.end(); ++it)
 		delete (*it);
 
@@ -229,10 +242,87 @@ bool Spawns::isInZone(const Position& centerPos, int32_t radius, const Position&
 		(pos.y >= centerPos.y - radius) && (pos.y <= centerPos.y + radius));
 }
 
-void Spawn::startEvent()
+void Spawns::addRespawn(Spawn* spawn, uint32_t spawnId, int64_t time)
 {
-	if(!checkSpawnEvent)
-		checkSpawnEvent = Scheduler::getInstance().addEvent(createSchedulerTask(getInterval(), boost::bind(&Spawn::checkSpawn, this)));
+	respawnEvent_t event;
+	event.time = time;
+	event.spawn = spawn;
+	event.spawnId = spawnId;
+
+	respawnQueue.push(event);
+	if(!checking)
+		scheduleCheck();
+}
+
+void Spawns::scheduleCheck()
+{
+	if(respawnQueue.empty())
+		return;
+
+	int64_t time = respawnQueue.top().time;
+	if(checkEvent)
+	{
+		if(time >= checkTime)
+			return;
+
+		Scheduler::getInstance().stopEvent(checkEvent);
+	}
+
+	checkTime = time;
+	checkEvent = Scheduler::getInstance().addEvent(createSchedulerTask(std::max((int64_t)SCHEDULER_MINTICKS,
+		time - OTSYS_TIME()), boost::bind(&Spawns::checkRespawns, this)));
+}
+
+void Spawns::checkRespawns()
+{
+	checkEvent = 0;
+	checking = true;
+
+	int64_t now = OTSYS_TIME();
+	uint32_t rateSpawn = (uint32_t)g_config.getNumber(ConfigManager::RATE_SPAWN);
+
+	std::map<Spawn*, uint32_t> spawnCount;
+	while(!respawnQueue.empty() && respawnQueue.top().time <= now)
+	{
+		respawnEvent_t event = respawnQueue.top();
+		respawnQueue.pop();
+
+		Spawn* spawn = event.spawn;
+		Spawn::SpawnMap::iterator it = spawn->spawnMap.find(event.spawnId);
+		if(it == spawn->spawnMap.end() || spawn->spawnedMap.find(event.spawnId) != spawn->spawnedMap.end())
+			continue;
+
+		spawnBlock_t& sb = it->second;
+		uint32_t& count = spawnCount[spawn];
+		if(count >= rateSpawn)
+		{
+			addRespawn(spawn, event.spawnId, now + spawn->getInterval());
+			continue;
+		}
+
+		if(g_game.isPlayerNearby(sb.pos) || !spawn->spawnMonster(event.spawnId, sb.mType, sb.pos, sb.direction))
+		{
+			++blockedCount;
+			sb.lastSpawn = now;
+			addRespawn(spawn, event.spawnId, now + sb.interval);
+			continue;
+		}
+
+		++respawnCount;
+		++count;
+	}
+
+	checking = false;
+	scheduleCheck();
+}
+
+uint32_t Spawns::getRespawnRate() const
+{
+	int64_t elapsed = OTSYS_TIME() - startTime;
+	if(!started || elapsed < 1000)
+		return 0;
+
+	return (uint32_t)(respawnCount * 1000 / elapsed);
 }
 
 Spawn::Spawn(const Position& _pos, int32_t _radius)
@@ -240,12 +330,10 @@ Spawn::Spawn(const Position& _pos, int32_t _radius)
 	centerPos = _pos;
 	radius = _radius;
 	interval = DEFAULTSPAWN_INTERVAL;
-	checkSpawnEvent = 0;
 }
 
 Spawn::~Spawn()
 {
-	stopEvent();
 	Monster* monster = NULL;
 	for(SpawnedMap::iterator it = spawnedMap.begin(); it != spawnedMap.end(); ++it)
 	{
@@ -261,21 +349,6 @@ Spawn::~Spawn()
 	spawnMap.clear();
 }
 
-bool Spawn::findPlayer(const Position& pos)
-{
-	SpectatorVec list;
-	g_game.getSpectators(list, pos);
-
-	Player* tmpPlayer = NULL;
-	for(SpectatorVec::iterator it = list.begin(); it != list.end(); ++it)
-	{
-		if((tmpPlayer = (*it)->getPlayer()) && !tmpPlayer->hasFlag(PlayerFlag_IgnoredByMonsters))
-			return true;
-	}
-
-	return false;
-}
-
 bool Spawn::spawnMonster(uint32_t spawnId, MonsterType* mType, const Position& pos, Direction dir, bool startup /*= false*/)
 {
 	Monster* monster = Monster::createMonster(mType);
@@ -312,71 +385,11 @@ void Spawn::startup()
 	for(SpawnMap::iterator it = spawnMap.begin(); it != spawnMap.end(); ++it)
 	{
 		spawnBlock_t& sb = it->second;
-		spawnMonster(it->first, sb.mType, sb.pos, sb.direction, true);
+		if(!spawnMonster(it->first, sb.mType, sb.pos, sb.direction, true))
+			Spawns::getInstance()->addRespawn(this, it->first, OTSYS_TIME() + sb.interval);
 	}
 }
 
-void Spawn::checkSpawn()
-{
-#ifdef __DEBUG_SPAWN__
-	std::clog << "[Notice] Spawn::checkSpawn " << this << std::endl;
-#endif
-	Monster* monster;
-	uint32_t spawnId;
-
-	checkSpawnEvent = 0;
-	for(SpawnedMap::iterator it = spawnedMap.begin(); it != spawnedMap.end();)
-	{
-		spawnId = it->first;
-		monster = it->second;
-		if(monster->isRemoved())
-		{
-			if(spawnId)
-				spawnMap[spawnId].lastSpawn = OTSYS_TIME();
-
-			monster->unRef();
-			spawnedMap.erase(it++);
-		}
-		else
-		{
-			/*if(spawnId && !isInSpawnZone(monster->getPosition()) && monster->getIdleStatus())
-				g_game.internalTeleport(monster, monster->getMasterPosition(), true);*/
-
-			++it;
-		}
-	}
-
-	uint32_t spawnCount = 0;
-	for(SpawnMap::iterator it = spawnMap.begin(); it != spawnMap.end(); ++it)
-	{
-		spawnId = it->first;
-		spawnBlock_t& sb = it->second;
-		if(spawnedMap.count(spawnId))
-			continue;
-
-		if(OTSYS_TIME() < sb.lastSpawn + sb.interval)
-			continue;
-
-		if(findPlayer(sb.pos))
-		{
-			sb.lastSpawn = OTSYS_TIME();
-			continue;
-		}
-
-		spawnMonster(spawnId, sb.mType, sb.pos, sb.direction);
-		++spawnCount;
-		if(spawnCount >= (uint32_t)g_config.getNumber(ConfigManager::RATE_SPAWN))
-			break;
-	}
-
-	if(spawnedMap.size() < spawnMap.size())
-		checkSpawnEvent = Scheduler::getInstance().addEvent(createSchedulerTask(getInterval(), boost::bind(&Spawn::checkSpawn, this)));
-#ifdef __DEBUG_SPAWN__
-	else
-		std::clog << "[Notice] Spawn::checkSpawn stopped " << this << std::endl;
-#endif
-}
-
 bool Spawn::addMonster(const std::string& _name, const Position& _pos, Direction _dir, uint32_t _interval)
 {
 	if(!g_game.getTile(_pos))
@@ -407,24 +420,26 @@ bool Spawn::addMonster(const std::string& _name, const Position& _pos, Direction
 	return true;
 }
 
-void Spawn::removeMonster(Monster* monster)
+void Spawn::removeMonster(Monster* monster, bool died/* = false*/)
 {
 	for(SpawnedMap::iterator it = spawnedMap.begin(); it != spawnedMap.end(); ++it)
 	{
 		if(it->second != monster)
 			continue;
 
+		uint32_t spawnId = it->first;
 		monster->unRef();
 		spawnedMap.erase(it);
-		break;
-	}
-}
 
-void Spawn::stopEvent()
-{
-	if(!checkSpawnEvent)
-		return;
+		SpawnMap::iterator sit = spawnMap.find(spawnId);
+		if(sit == spawnMap.end())
+			break;
+
+		spawnBlock_t& sb = sit->second;
+		if(died)
+			sb.lastSpawn = OTSYS_TIME();
 
-	Scheduler::getInstance().stopEvent(checkSpawnEvent);
-	checkSpawnEvent = 0;
+		Spawns::getInstance()->addRespawn(this, spawnId, sb.lastSpawn + sb.interval);
+		break;
+	}
 }
@@ -28,6 +28,16 @@
 class Spawn;
 typedef std::list<Spawn*> SpawnList;
 
+struct respawnEvent_t
+{
+	int64_t time;
+	Spawn* spawn;
+	uint32_t spawnId;
+
+	bool operator>(const respawnEvent_t& other) const {return time > other.time;}
+};
+typedef std::priority_queue<respawnEvent_t, std::vector<respawnEvent_t>, std::greater<respawnEvent_t> > RespawnQueue;
+
 class Spawns
 {
 	public:
@@ -49,6 +59,13 @@ class Spawns
 		bool isLoaded() const {return loaded;}
 		bool isStarted() const {return started;}
 
+		void addRespawn(Spawn* spawn, uint32_t spawnId, int64_t time);
+
+		uint64_t getRespawnCount() const {return respawnCount;}
+		uint64_t getBlockedCount() const {return blockedCount;}
+		uint32_t getPendingCount() const {return respawnQueue.size();}
+		uint32_t getRespawnRate() const;
+
 	private:
 		Spawns();
 		SpawnList spawnList;
@@ -58,6 +75,15 @@ class Spawns
 
 		bool loaded, started;
 		std::string filename;
+
+		void checkRespawns();
+		void scheduleCheck();
+
+		RespawnQueue respawnQueue;
+		bool checking;
+		uint32_t checkEvent;
+		int64_t checkTime, startTime;
+		uint64_t respawnCount, blockedCount;
 };
 
 struct spawnBlock_t
@@ -77,28 +103,22 @@ class Spawn
 		virtual ~Spawn();
 
 		bool addMonster(const std::string& _name, const Position& _pos, Direction _dir, uint32_t _interval);
-		void removeMonster(Monster* monster);
+		void removeMonster(Monster* monster, bool died = false);
 
 		Position getPosition() const {return centerPos;}
 		uint32_t getInterval() const {return interval;}
 
-		void startEvent();
-		void stopEvent();
-
 		void startup();
 		bool isInSpawnZone(const Position& pos) {return Spawns::getInstance()->isInZone(centerPos, radius, pos);}
 
 	private:
-		uint32_t interval, checkSpawnEvent;
+		uint32_t interval;
 
 		Position centerPos;
 		int32_t radius, despawnRange, despawnRadius;
 
-		void checkSpawn();
 		bool spawnMonster(uint32_t spawnId, MonsterType* mType, const Position& pos, Direction dir, bool startup = false);
 
-		bool findPlayer(const Position& pos);
-
 		//map of creatures in the spawn
 		typedef std::map<uint32_t, spawnBlock_t> SpawnMap;
 		SpawnMap spawnMap;
@@ -107,5 +127,7 @@ class Spawn
 		typedef std::multimap<uint32_t, Monster*, std::less<uint32_t> > SpawnedMap;
 		typedef SpawnedMap::value_type SpawnedPair;
 		SpawnedMap spawnedMap;
+
+		friend class Spawns;
 };
 #endif
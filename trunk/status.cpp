@@ -34,7 +34,9 @@
 #include "outputmessage.h"
 
 #include "configmanager.h"
+#include "scheduler.h"
 #include "game.h"
+#include "player.h"
 
 extern ConfigManager g_config;
 extern Game g_game;
@@ -43,30 +45,68 @@ extern Game g_game;
 uint32_t ProtocolStatus::protocolStatusCount = 0;
 #endif
 IpConnectMap ProtocolStatus::ipConnectMap;
+boost::mutex ProtocolStatus::ipConnectLock;
+int64_t ProtocolStatus::ipConnectCleanup = 0;
+
+#define STATUS_UPTIME_MARKER "{uptime}"
+
+template<typename T>
+inline void putValue(std::string& out, T value)
+{
+	out.append((const char*)&value, sizeof(T));
+}
+
+inline void putString(std::string& out, const std::string& value)
+{
+	putValue<uint16_t>(out, value.size());
+	out.append(value);
+}
 
 void ProtocolStatus::onRecvFirstMessage(NetworkMessage& msg)
 {
-	if(getIP() != LOCALHOST)
+	StatusSnapshot_ptr snapshot = Status::getInstance()->getSnapshot();
+	if(!snapshot)
 	{
-		std::string ip = convertIPAddress(getIP());
-		if(!g_game.isInWhitelist(ip))
+		getConnection()->close();
+		return;
+	}
+
+	int64_t now = OTSYS_TIME(), timeout = g_config.getNumber(ConfigManager::STATUSQUERY_TIMEOUT);
+	if(getIP() != LOCALHOST && snapshot->whitelist.find(getIP()) == snapshot->whitelist.end())
+	{
+		if(snapshot->blacklist.find(getIP()) != snapshot->blacklist.end())
 		{
-			if(g_game.isInBlacklist(ip))
-			{
-				getConnection()->close();
-				return;
-			}
+			getConnection()->close();
+			return;
+		}
 
-			IpConnectMap::const_iterator it = ipConnectMap.find(getIP());
-			if(it != ipConnectMap.end() && OTSYS_TIME() < it->second + g_config.getNumber(ConfigManager::STATUSQUERY_TIMEOUT))
+		boost::unique_lock<boost::mutex> lockClass(ipConnectLock);
+		IpConnectMap::const_iterator it = ipConnectMap.find(getIP());
+		if(it != ipConnectMap.end() && now < it->second + timeout)
+		{
+			getConnection()->close();
+			return;
+		}
+	}
+
+	{
+		boost::unique_lock<boost::mutex> lockClass(ipConnectLock);
+		ipConnectMap[getIP()] = now;
+		if(now > ipConnectCleanup + timeout)
+		{
+			// drop addresses that are not limited anymore, so the map does not grow forever
+			for(IpConnectMap::iterator it = ipConnectMap.begin(); it != ipConnectMap.end(); )
 			{
-				getConnection()->close();
-				return;
+				if(now >= it->second + timeout)
+					ipConnectMap.erase(it++);
+				else
+					++it;
 			}
+
+			ipConnectCleanup = now;
 		}
 	}
 
-	ipConnectMap[getIP()] = OTSYS_TIME();
 	uint8_t type = msg.get<char>();
 	switch(type)
 	{
@@ -77,16 +117,14 @@ void ProtocolStatus::onRecvFirstMessage(NetworkMessage& msg)
 				if(OutputMessage_ptr output = OutputMessagePool::getInstance()->getOutputMessage(this, false))
 				{
 					TRACK_MESSAGE(output);
-					if(Status* status = Status::getInstance())
-					{
-						bool sendPlayers = false;
-						#ifndef __SPOOF_PLAYERS__
-						if(msg.size() > msg.position())
-							sendPlayers = msg.get<char>() == 0x01;
-                        #endif
+					bool sendPlayers = false;
+					#ifndef __SPOOF_PLAYERS__
+					if(msg.size() > msg.position())
+						sendPlayers = msg.get<char>() == 0x01;
+					#endif
 
-						output->putString(status->getStatusString(sendPlayers), false);
-					}
+					std::string xml = Status::getInstance()->getStatusString(sendPlayers);
+					output->putRaw(xml.c_str(), xml.size());
 
 					setRawMessages(true); // we dont want the size header, nor encryption
 					OutputMessagePool::getInstance()->send(output);
@@ -102,9 +140,7 @@ void ProtocolStatus::onRecvFirstMessage(NetworkMessage& msg)
 			if(OutputMessage_ptr output = OutputMessagePool::getInstance()->getOutputMessage(this, false))
 			{
 				TRACK_MESSAGE(output);
-				if(Status* status = Status::getInstance())
-					status->getInfo(requestedInfo, output, msg);
-
+				Status::getInstance()->getInfo(requestedInfo, output, msg);
 				OutputMessagePool::getInstance()->send(output);
 			}
 
@@ -126,7 +162,159 @@ void ProtocolStatus::deleteProtocolTask()
 	Protocol::deleteProtocolTask();
 }
 
-std::string Status::getStatusString(bool sendPlayers) const
+void Status::startup()
+{
+	refresh();
+	Scheduler::getInstance().addEvent(createSchedulerTask(std::max(1000, g_config.getNumber(
+		ConfigManager::STATUS_REFRESH_INTERVAL)), boost::bind(&Status::check, this)));
+}
+
+void Status::check()
+{
+	refresh();
+	Scheduler::getInstance().addEvent(createSchedulerTask(std::max(1000, g_config.getNumber(
+		ConfigManager::STATUS_REFRESH_INTERVAL)), boost::bind(&Status::check, this)));
+}
+
+void Status::invalidate()
+{
+	if(m_dirty)
+		return;
+
+	// coalesce bursts of logins/logouts into a single rebuild
+	m_dirty = true;
+	Scheduler::getInstance().addEvent(createSchedulerTask(STATUS_DIRTY_DELAY,
+		boost::bind(&Status::refresh, this)));
+}
+
+void Status::refresh()
+{
+	m_dirty = false;
+	StatusSnapshot* snapshot = new StatusSnapshot();
+
+	std::string xml = buildStatusString(false);
+	size_t pos = xml.find(STATUS_UPTIME_MARKER);
+	if(pos != std::string::npos)
+	{
+		snapshot->xmlHead = xml.substr(0, pos);
+		snapshot->xmlTail = xml.substr(pos + strlen(STATUS_UPTIME_MARKER));
+	}
+	else
+		snapshot->xmlHead = xml;
+
+	xml = buildStatusString(true);
+	if((pos = xml.find(STATUS_UPTIME_MARKER)) != std::string::npos)
+	{
+		snapshot->xmlPlayersHead = xml.substr(0, pos);
+		snapshot->xmlPlayersTail = xml.substr(pos + strlen(STATUS_UPTIME_MARKER));
+	}
+	else
+		snapshot->xmlPlayersHead = xml;
+
+	buildInfo(snapshot);
+	for(AutoList<Player>::iterator it = Player::autoList.begin(); it != Player::autoList.end(); ++it)
+	{
+		if(!it->second->isRemoved())
+			snapshot->players[asLowerCaseString(it->second->getName())] = it->second->isGhost();
+	}
+
+	const StatusList& blacklist = g_game.getBlacklist();
+	for(StatusList::const_iterator it = blacklist.begin(); it != blacklist.end(); ++it)
+		snapshot->blacklist.insert(inet_addr(it->c_str()));
+
+	const StatusList& whitelist = g_game.getWhitelist();
+	for(StatusList::const_iterator it = whitelist.begin(); it != whitelist.end(); ++it)
+		snapshot->whitelist.insert(inet_addr(it->c_str()));
+
+	boost::unique_lock<boost::mutex> lockClass(m_lock);
+	m_snapshot.reset(snapshot);
+}
+
+StatusSnapshot_ptr Status::getSnapshot()
+{
+	boost::unique_lock<boost::mutex> lockClass(m_lock);
+	return m_snapshot;
+}
+
+std::string Status::getStatusString(bool sendPlayers)
+{
+	StatusSnapshot_ptr snapshot = getSnapshot();
+	if(!snapshot)
+		return "";
+
+	char buffer[15];
+	sprintf(buffer, "%u", getUptime());
+	if(sendPlayers)
+		return snapshot->xmlPlayersHead + buffer + snapshot->xmlPlayersTail;
+
+	return snapshot->xmlHead + buffer + snapshot->xmlTail;
+}
+
+void Status::getInfo(uint32_t requestedInfo, OutputMessage_ptr output, NetworkMessage& msg)
+{
+	StatusSnapshot_ptr snapshot = getSnapshot();
+	if(!snapshot)
+		return;
+
+	for(uint8_t i = 0; i < STATUS_INFO_SECTIONS; ++i)
+	{
+		uint32_t section = (1 << i);
+		if(!(requestedInfo & section))
+			continue;
+
+		switch(section)
+		{
+			case REQUEST_MISC_SERVER_INFO:
+			{
+				output->putRaw(snapshot->info[i].c_str(), snapshot->info[i].size());
+				uint64_t uptime = getUptime();
+				output->put<uint32_t>((uint32_t)(uptime >> 32));
+				output->put<uint32_t>((uint32_t)(uptime));
+				break;
+			}
+
+			#ifndef __SPOOF_PLAYERS__
+			case REQUEST_PLAYER_STATUS_INFO:
+			{
+				output->put<char>(0x22);
+				std::string name = asLowerCaseString(msg.getString());
+
+				bool online = false;
+				if(!name.empty())
+				{
+					char tmp = *name.rbegin();
+					if(tmp == '~' || tmp == '*')
+					{
+						// same rules as Game::getPlayerByNameWildcard, it has to be unambiguous
+						name.erase(name.length() - 1);
+						std::map<std::string, bool>::const_iterator it = snapshot->players.lower_bound(name);
+						if(it != snapshot->players.end() && !it->first.compare(0, name.length(), name))
+						{
+							std::map<std::string, bool>::const_iterator next = it;
+							if(++next == snapshot->players.end() || next->first.compare(0, name.length(), name))
+								online = !it->second;
+						}
+					}
+					else
+					{
+						std::map<std::string, bool>::const_iterator it = snapshot->players.find(name);
+						online = it != snapshot->players.end() && !it->second;
+					}
+				}
+
+				output->put<char>(online ? 0x01 : 0x00);
+				break;
+			}
+			#endif
+
+			default:
+				output->putRaw(snapshot->info[i].c_str(), snapshot->info[i].size());
+				break;
+		}
+	}
+}
+
+std::string Status::buildStatusString(bool sendPlayers) const
 {
 	char buffer[90];
 	xmlDocPtr doc;
@@ -139,8 +327,7 @@ std::string Status::getStatusString(bool sendPlayers) const
 	xmlSetProp(root, (const xmlChar*)"version", (const xmlChar*)"1.0");
 
 	p = xmlNewNode(NULL,(const xmlChar*)"serverinfo");
-	sprintf(buffer, "%u", (uint32_t)getUptime());
-	xmlSetProp(p, (const xmlChar*)"uptime", (const xmlChar*)buffer);
+	xmlSetProp(p, (const xmlChar*)"uptime", (const xmlChar*)STATUS_UPTIME_MARKER);
 	xmlSetProp(p, (const xmlChar*)"ip", (const xmlChar*)g_config.getString(ConfigManager::IP).c_str());
 	xmlSetProp(p, (const xmlChar*)"servername", (const xmlChar*)g_config.getString(ConfigManager::SERVER_NAME).c_str());
 	sprintf(buffer, "%d", g_config.getNumber(ConfigManager::LOGIN_PORT));
@@ -232,100 +419,72 @@ std::string Status::getStatusString(bool sendPlayers) const
 	return xml;
 }
 
-void Status::getInfo(uint32_t requestedInfo, OutputMessage_ptr output, NetworkMessage& msg) const
+void Status::buildInfo(StatusSnapshot* snapshot) const
 {
-	if(requestedInfo & REQUEST_BASIC_SERVER_INFO)
-	{
-		output->put<char>(0x10);
-		output->putString(g_config.getString(ConfigManager::SERVER_NAME).c_str());
-		output->putString(g_config.getString(ConfigManager::IP).c_str());
+	std::string* out = &snapshot->info[0]; // REQUEST_BASIC_SERVER_INFO
+	putValue<char>(*out, 0x10);
+	putString(*out, g_config.getString(ConfigManager::SERVER_NAME));
+	putString(*out, g_config.getString(ConfigManager::IP));
 
-		char buffer[10];
-		sprintf(buffer, "%d", g_config.getNumber(ConfigManager::LOGIN_PORT));
-		output->putString(buffer);
-	}
+	char buffer[10];
+	sprintf(buffer, "%d", g_config.getNumber(ConfigManager::LOGIN_PORT));
+	putString(*out, buffer);
 
-	if(requestedInfo & REQUEST_SERVER_OWNER_INFO)
-	{
-		output->put<char>(0x11);
-		output->putString(g_config.getString(ConfigManager::OWNER_NAME).c_str());
-		output->putString(g_config.getString(ConfigManager::OWNER_EMAIL).c_str());
-	}
+	out = &snapshot->info[1]; // REQUEST_SERVER_OWNER_INFO
+	putValue<char>(*out, 0x11);
+	putString(*out, g_config.getString(ConfigManager::OWNER_NAME));
+	putString(*out, g_config.getString(ConfigManager::OWNER_EMAIL));
 
-	if(requestedInfo & REQUEST_MISC_SERVER_INFO)
-	{
-		output->put<char>(0x12);
-		output->putString(g_config.getString(ConfigManager::MOTD).c_str());
-		output->putString(g_config.getString(ConfigManager::LOCATION).c_str());
-		output->putString(g_config.getString(ConfigManager::URL).c_str());
-
-		uint64_t uptime = getUptime();
-		output->put<uint32_t>((uint32_t)(uptime >> 32));
-		output->put<uint32_t>((uint32_t)(uptime));
-	}
+	out = &snapshot->info[2]; // REQUEST_MISC_SERVER_INFO, uptime is appended when sending
+	putValue<char>(*out, 0x12);
+	putString(*out, g_config.getString(ConfigManager::MOTD));
+	putString(*out, g_config.getString(ConfigManager::LOCATION));
+	putString(*out, g_config.getString(ConfigManager::URL));
 
-	if(requestedInfo & REQUEST_PLAYERS_INFO)
-	{
-		output->put<char>(0x20);
-		#ifdef __SPOOF_PLAYERS__
-		output->put<uint32_t>(g_game.getPlayersOnline() + PLAYERS_TO_SPOOF);
-		output->put<uint32_t>(g_game.getPlayersRecord() + (PLAYERS_TO_SPOOF + 1));
-		#else
-		output->put<uint32_t>(g_game.getPlayersOnline());
-		output->put<uint32_t>(g_game.getPlayersRecord());
-		#endif
-		output->put<uint32_t>(g_config.getNumber(ConfigManager::MAX_PLAYERS));
-	}
+	out = &snapshot->info[3]; // REQUEST_PLAYERS_INFO
+	putValue<char>(*out, 0x20);
+	#ifdef __SPOOF_PLAYERS__
+	putValue<uint32_t>(*out, g_game.getPlayersOnline() + PLAYERS_TO_SPOOF);
+	putValue<uint32_t>(*out, g_game.getPlayersRecord() + (PLAYERS_TO_SPOOF + 1));
+	#else
+	putValue<uint32_t>(*out, g_game.getPlayersOnline());
+	putValue<uint32_t>(*out, g_game.getPlayersRecord());
+	#endif
+	putValue<uint32_t>(*out, g_config.getNumber(ConfigManager::MAX_PLAYERS));
 
-	if(requestedInfo & REQUEST_SERVER_MAP_INFO)
-	{
-		output->put<char>(0x30);
-		output->putString(g_config.getString(ConfigManager::MAP_NAME).c_str());
-		output->putString(g_config.getString(ConfigManager::MAP_AUTHOR).c_str());
-
-		uint32_t mapWidth, mapHeight;
-		g_game.getMapDimensions(mapWidth, mapHeight);
-		output->put<uint16_t>(mapWidth);
-		output->put<uint16_t>(mapHeight);
-	}
+	out = &snapshot->info[4]; // REQUEST_SERVER_MAP_INFO
+	putValue<char>(*out, 0x30);
+	putString(*out, g_config.getString(ConfigManager::MAP_NAME));
+	putString(*out, g_config.getString(ConfigManager::MAP_AUTHOR));
 
-    #ifndef __SPOOF_PLAYERS__
-	if(requestedInfo & REQUEST_EXT_PLAYERS_INFO)
-	{
-		output->put<char>(0x21);
-		std::list<std::pair<std::string, uint32_t> > players;
-		for(AutoList<Player>::iterator it = Player::autoList.begin(); it != Player::autoList.end(); ++it)
-		{
-			if(!it->second->isRemoved() && !it->second->isGhost())
-				players.push_back(std::make_pair(it->second->getName(), it->second->getLevel()));
-		}
+	uint32_t mapWidth, mapHeight;
+	g_game.getMapDimensions(mapWidth, mapHeight);
+	putValue<uint16_t>(*out, mapWidth);
+	putValue<uint16_t>(*out, mapHeight);
 
-		output->put<uint32_t>(players.size());
-		for(std::list<std::pair<std::string, uint32_t> >::iterator it = players.begin(); it != players.end(); ++it)
-		{
-			output->putString(it->first);
-			output->put<uint32_t>(it->second);
-		}
-	}
+	#ifndef __SPOOF_PLAYERS__
+	out = &snapshot->info[5]; // REQUEST_EXT_PLAYERS_INFO
+	putValue<char>(*out, 0x21);
 
-	if(requestedInfo & REQUEST_PLAYER_STATUS_INFO)
+	std::string players;
+	uint32_t count = 0;
+	for(AutoList<Player>::iterator it = Player::autoList.begin(); it != Player::autoList.end(); ++it)
 	{
-		output->put<char>(0x22);
-		const std::string name = msg.getString();
-
-		Player* p = NULL;
-		if(g_game.getPlayerByNameWildcard(name, p) == RET_NOERROR && !p->isGhost())
-			output->put<char>(0x01);
-		else
-			output->put<char>(0x00);
+		if(it->second->isRemoved() || it->second->isGhost())
+			continue;
+
+		putString(players, it->second->getName());
+		putValue<uint32_t>(players, it->second->getLevel());
+		++count;
 	}
+
+	putValue<uint32_t>(*out, count);
+	out->append(players);
 	#endif
 
-	if(requestedInfo & REQUEST_SERVER_SOFTWARE_INFO)
-	{
-		output->put<char>(0x23);
-		output->putString(SOFTWARE_NAME);
-		output->putString(SOFTWARE_VERSION);
-		output->putString(SOFTWARE_PROTOCOL);
-	}
+	out = &snapshot->info[7]; // REQUEST_SERVER_SOFTWARE_INFO
+	putValue<char>(*out, 0x23);
+	putString(*out, SOFTWARE_NAME);
+	putString(*out, SOFTWARE_VERSION);
+	putString(*out, SOFTWARE_PROTOCOL);
 }
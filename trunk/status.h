@@ -34,6 +34,22 @@ enum RequestedInfo_t
 };
 
 typedef std::map<uint32_t, int64_t> IpConnectMap;
+typedef std::set<uint32_t> IpSet;
+
+#define STATUS_INFO_SECTIONS 8
+#define STATUS_DIRTY_DELAY 1000
+
+class StatusSnapshot
+{
+	public:
+		std::string xmlHead, xmlTail, xmlPlayersHead, xmlPlayersTail;
+		std::string info[STATUS_INFO_SECTIONS];
+
+		std::map<std::string, bool> players; // lowercase name, ghost
+		IpSet blacklist, whitelist;
+};
+typedef boost::shared_ptr<const StatusSnapshot> StatusSnapshot_ptr;
+
 class ProtocolStatus : public Protocol
 {
 	public:
@@ -62,6 +78,9 @@ class ProtocolStatus : public Protocol
 
 	protected:
 		static IpConnectMap ipConnectMap;
+		static boost::mutex ipConnectLock;
+		static int64_t ipConnectCleanup;
+
 		virtual void deleteProtocolTask();
 };
 
@@ -75,8 +94,13 @@ class Status
 			return &status;
 		}
 
-		std::string getStatusString(bool sendPlayers) const;
-		void getInfo(uint32_t requestedInfo, OutputMessage_ptr output, NetworkMessage& msg) const;
+		void startup();
+		void invalidate();
+
+		StatusSnapshot_ptr getSnapshot();
+
+		std::string getStatusString(bool sendPlayers);
+		void getInfo(uint32_t requestedInfo, OutputMessage_ptr output, NetworkMessage& msg);
 
 		uint32_t getUptime() const {return (OTSYS_TIME() - m_start) / 1000;}
 		int64_t getStart() const {return m_start;}
@@ -85,9 +109,20 @@ class Status
 		Status()
 		{
 			m_start = OTSYS_TIME();
+			m_dirty = false;
 		}
 
+		void check();
+		void refresh();
+
+		std::string buildStatusString(bool sendPlayers) const;
+		void buildInfo(StatusSnapshot* snapshot) const;
+
 	private:
 		int64_t m_start;
+		bool m_dirty;
+
+		boost::mutex m_lock;
+		StatusSnapshot_ptr m_snapshot;
 };
 #endif
@@ -28,6 +28,7 @@
 
 #include "house.h"
 #include "town.h"
+#include "spawn.h"
 
 #include "teleport.h"
 #include "status.h"
@@ -842,7 +843,7 @@ bool TalkAction::thingProporties(Creature* creature, const std::string&, const s
 		return true;
 	}
 
-	Thing* thing = tile->getTopVisibleThing(creature);
+	Thing* thing = tile->unshareThing(tile->getTopVisibleThing(creature));
 	if(!thing)
 	{
 		player->sendTextMessage(MSG_STATUS_SMALL, "No object found.");
@@ -1133,6 +1134,15 @@ bool TalkAction::diagnostics(Creature* creature, const std::string&, const std::
 		<< "Monster: " << g_game.getMonstersOnline() << " (" << Monster::monsterCount << ")" << std::endl << std::endl;
 	player->sendTextMessage(MSG_STATUS_CONSOLE_BLUE, s.str());
 
+	s.str("");
+	Spawns* spawns = Spawns::getInstance();
+	s << "Spawns:" << std::endl
+		<< "--------------------" << std::endl
+		<< "Respawns: " << spawns->getRespawnCount() << " (" << spawns->getRespawnRate() << "/s)" << std::endl
+		<< "Blocked respawns: " << spawns->getBlockedCount() << std::endl
+		<< "Pending respawns: " << spawns->getPendingCount() << std::endl << std::endl;
+	player->sendTextMessage(MSG_STATUS_CONSOLE_BLUE, s.str());
+
 	s.str("");
 	s << "Protocols:" << std::endl
 		<< "--------------------" << std::endl
@@ -1156,6 +1166,46 @@ bool TalkAction::diagnostics(Creature* creature, const std::string&, const std::
 		<< "Free message pool: " << OutputMessagePool::getInstance()->getAvailableMessageCount() << std::endl;
 	player->sendTextMessage(MSG_STATUS_CONSOLE_BLUE, s.str());
 
+	static const char* loginStages[LOGINSTAGE_LAST + 1] = {"Decrypt", "Account", "Password", "Ban", "Install", "Total"};
+	s.str("");
+	s << "Login pipeline (us, count/avg/p50/p99/max):" << std::endl
+		<< "--------------------" << std::endl
+		<< "Pending: " << TaskPool::getInstance(TASKPOOL_CPU).getPendingCount() << " cpu, "
+		<< TaskPool::getInstance(TASKPOOL_DATABASE).getPendingCount() << " database" << std::endl;
+	for(int32_t i = LOGINSTAGE_DECRYPT; i <= LOGINSTAGE_LAST; ++i)
+	{
+		LatencyHistogram& latency = Protocol::loginLatency[i];
+		s << loginStages[i] << ": " << latency.getCount() << " / " << latency.getAverage() << " / " << latency.getPercentile(50)
+			<< " / " << latency.getPercentile(99) << " / " << latency.getMax() << std::endl;
+	}
+
+	player->sendTextMessage(MSG_STATUS_CONSOLE_BLUE, s.str());
+
+	static const char* databaseTypes[DBLATENCY_LAST + 1] = {"Query", "Store", "Statement", "Queue"};
+	s.str("");
+	s << "Database (us, count/avg/p50/p99/max):" << std::endl
+		<< "--------------------" << std::endl
+		<< "Connections: " << (Database::getPoolSize() + 1) << " (" << Database::getPoolSize() << " for "
+		<< TaskPool::getInstance(TASKPOOL_DATABASE).getThreadCount() << " workers)" << std::endl;
+	for(int32_t i = DBLATENCY_QUERY; i <= DBLATENCY_LAST; ++i)
+	{
+		LatencyHistogram& latency = Database::latency[i];
+		s << databaseTypes[i] << ": " << latency.getCount() << " / " << latency.getAverage() << " / " << latency.getPercentile(50)
+			<< " / " << latency.getPercentile(99) << " / " << latency.getMax() << std::endl;
+	}
+
+	player->sendTextMessage(MSG_STATUS_CONSOLE_BLUE, s.str());
+
+	Logger* logger = Logger::getInstance();
+	s.str("");
+	s << "Logger:" << std::endl
+		<< "--------------------" << std::endl
+		<< "Queued: " << logger->getQueuedCount() << " (" << logger->getPendingCount() << " pending)" << std::endl
+		<< "Written: " << logger->getWrittenCount() << " in " << logger->getBatchCount() << " batches" << std::endl
+		<< "Dropped: " << logger->getDroppedCount() << std::endl
+		<< "Enqueue cost: " << logger->getEnqueueCost() << " ns/line" << std::endl;
+	player->sendTextMessage(MSG_STATUS_CONSOLE_BLUE, s.str());
+
 #else
 	player->sendTextMessage(MSG_STATUS_CONSOLE_BLUE, "Command not available, please rebuild your software with -D__ENABLE_SERVER_DIAG__");
 #endif
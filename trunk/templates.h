@@ -18,6 +18,7 @@
 #ifndef __TEMPLATES__
 #define __TEMPLATES__
 #include "otsystem.h"
+#include <stdexcept>
 
 template<class T> class AutoList : public std::map<uint32_t, T*>
 {
@@ -26,43 +27,98 @@ template<class T> class AutoList : public std::map<uint32_t, T*>
 		virtual ~AutoList() {}
 };
 
+/*
+ * Creature ids keep the protocol ranges (see Creature::setID), the low 28 bits
+ * are split into a slot and a generation, so that a slot can be looked up
+ * directly while stale ids held by scripts or clients do not match again
+ * until its generation wraps around.
+ */
+#define AUTOID_SLOT_BITS 20
+#define AUTOID_SLOTS (1 << AUTOID_SLOT_BITS)
+#define AUTOID_SLOT_MASK (AUTOID_SLOTS - 1)
+#define AUTOID_GENERATION_MASK 0xFF
+
 class AutoId
 {
 	public:
 		AutoId()
 		{
-			boost::recursive_mutex::scoped_lock lockClass(lock);
-			++count;
-			if(count >= 0xFFFFFF)
-				count = 1000;
-
-			while(list.find(count) != list.end())
+			boost::mutex::scoped_lock lockClass(lock);
+			uint32_t slot = 0;
+			if(next < AUTOID_SLOTS) // use every slot once before recycling, like the old counter did
+				slot = next++;
+			else if(!freeSlots.empty())
+			{
+				slot = freeSlots.front();
+				freeSlots.pop_front();
+			}
+			else
 			{
-				if(count >= 0xFFFFFF)
-					count = 1000;
-				else
-					++count;
+				// handing out a slot twice would merge two creatures in every lookup
+				std::clog << "[Critical - AutoId::AutoId] No more free ids." << std::endl;
+				throw std::length_error("AutoId: no more free ids");
 			}
 
-			list.insert(count);
-			autoId = count;
+			if(slot >= generations.size())
+				generations.resize(std::min((uint32_t)AUTOID_SLOTS, std::max(slot + 1, (uint32_t)generations.size() << 1)), 0);
+
+			autoId = (generations[slot] << AUTOID_SLOT_BITS) | slot;
 		}
 
 		virtual ~AutoId()
 		{
-			std::set<uint32_t>::iterator it = list.find(autoId);
-			if(it != list.end())
-				list.erase(it);
+			uint32_t slot = autoId & AUTOID_SLOT_MASK;
+			if(!slot)
+				return;
+
+			boost::mutex::scoped_lock lockClass(lock);
+			generations[slot] = (generations[slot] + 1) & AUTOID_GENERATION_MASK;
+			freeSlots.push_back(slot);
 		}
 
 		uint32_t autoId;
 
 	protected:
-		static uint32_t count;
+		static uint32_t next;
+		static std::vector<uint8_t> generations;
+		static std::deque<uint32_t> freeSlots;
+
+		static boost::mutex lock;
+};
+
+template<class T> class AutoIndex
+{
+	public:
+		AutoIndex() {}
+		virtual ~AutoIndex() {}
 
-		typedef std::set<uint32_t> List;
-		static List list;
+		T* get(uint32_t id) const
+		{
+			uint32_t slot = id & AUTOID_SLOT_MASK;
+			if(slot >= m_slots.size() || m_slots[slot].first != id)
+				return NULL;
+
+			return m_slots[slot].second;
+		}
 
-		static boost::recursive_mutex lock;
+		void set(uint32_t id, T* value)
+		{
+			uint32_t slot = id & AUTOID_SLOT_MASK;
+			if(slot >= m_slots.size())
+				m_slots.resize(std::min((uint32_t)AUTOID_SLOTS, std::max(slot + 1, (uint32_t)m_slots.size() << 1)), Entry(0, NULL));
+
+			m_slots[slot] = Entry(id, value);
+		}
+
+		void erase(uint32_t id)
+		{
+			uint32_t slot = id & AUTOID_SLOT_MASK;
+			if(slot < m_slots.size() && m_slots[slot].first == id)
+				m_slots[slot] = Entry(0, NULL);
+		}
+
+	protected:
+		typedef std::pair<uint32_t, T*> Entry;
+		std::vector<Entry> m_slots;
 };
 #endif
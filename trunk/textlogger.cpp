@@ -26,60 +26,320 @@
 extern ConfigManager g_config;
 extern Game g_game;
 
+Logger::Logger()
+{
+	m_loaded = false;
+	m_thread = NULL;
+	m_state = STATE_TERMINATED;
+
+	m_head = m_size = m_wakeup = 0;
+	m_bytes = m_maxBytes = m_rotateSize = 0;
+	m_flushInterval = 1000;
+	m_rotateInterval = 0;
+	m_block = false;
+
+	m_queued = m_written = m_dropped = m_batches = m_reported = 0;
+#ifdef __ENABLE_SERVER_DIAGNOSTIC__
+	m_enqueueTime = 0;
+#endif
+}
+
 void Logger::open()
 {
+	if(m_thread)
+		return;
+
 	std::string path = g_config.getString(ConfigManager::OUTPUT_LOG);
 	if(path.length() < 3)
 		path = "";
 	else if(path[0] != '/' && path[1] != ':')
 		path = getFilePath(FILE_TYPE_LOG, path);
 
-	m_files[LOGFILE_ADMIN] = fopen(getFilePath(FILE_TYPE_LOG, "admin.log").c_str(), "a");
+	m_files[LOGFILE_ADMIN].path = getFilePath(FILE_TYPE_LOG, "admin.log");
+	openFile(m_files[LOGFILE_ADMIN], "a");
 	if(!path.empty())
-		m_files[LOGFILE_OUTPUT] = fopen(path.c_str(), (g_config.getBool(ConfigManager::TRUNCATE_LOG) ? "w" : "a"));
+	{
+		m_files[LOGFILE_OUTPUT].path = path;
+		openFile(m_files[LOGFILE_OUTPUT], (g_config.getBool(ConfigManager::TRUNCATE_LOG) ? "w" : "a"));
+	}
+
+	m_files[LOGFILE_ASSERTIONS].path = getFilePath(FILE_TYPE_LOG, "client_assertions.log");
+	openFile(m_files[LOGFILE_ASSERTIONS], "a");
+
+	m_ring.resize(std::max(64, g_config.getNumber(ConfigManager::LOG_QUEUE_SIZE)));
+	m_wakeup = m_ring.size() >> 2;
+
+	m_maxBytes = (uint64_t)std::max(64, g_config.getNumber(ConfigManager::LOG_QUEUE_MEMORY)) << 10;
+	m_rotateSize = (uint64_t)std::max(0, g_config.getNumber(ConfigManager::LOG_ROTATE_SIZE)) << 20;
+	m_rotateInterval = std::max(0, g_config.getNumber(ConfigManager::LOG_ROTATE_INTERVAL));
 
-	m_files[LOGFILE_ASSERTIONS] = fopen(getFilePath(FILE_TYPE_LOG, "client_assertions.log").c_str(), "a");
+	m_flushInterval = std::max(10, g_config.getNumber(ConfigManager::LOG_FLUSH_INTERVAL));
+	m_block = g_config.getBool(ConfigManager::LOG_BLOCK_WHEN_FULL);
+
+	m_state = STATE_RUNNING;
+	m_thread = new boost::thread(boost::bind(&Logger::writerThread, (void*)this));
 	m_loaded = true;
 }
 
 void Logger::close()
 {
 	m_loaded = false;
+	if(m_thread)
+	{
+		m_lock.lock();
+		if(m_state == STATE_RUNNING)
+			m_state = STATE_CLOSING;
+
+		m_lock.unlock();
+		m_signal.notify_one();
+
+		m_thread->join();
+		delete m_thread;
+		m_thread = NULL;
+	}
+
 	for(uint8_t i = 0; i <= LOGFILE_LAST; i++)
 	{
-		if(m_files[i])
-			fclose(m_files[i]);
+		if(!m_files[i].handle)
+			continue;
+
+		fclose(m_files[i].handle);
+		m_files[i].handle = NULL;
 	}
+
+	closeIdle(0, true);
+}
+
+void Logger::iFile(LogFile_t file, const std::string& output, bool newLine)
+{
+	if(m_loaded)
+		push(file, "", output, newLine);
 }
 
-void Logger::iFile(LogFile_t file, std::string output, bool newLine)
+void Logger::eFile(const std::string& file, const std::string& output, bool newLine)
 {
-	if(!m_loaded || !m_files[file])
+	if(!file.empty())
+		push(LOGFILE_FIRST, file, output, newLine);
+}
+
+void Logger::push(LogFile_t file, const std::string& name, const std::string& output, bool newLine)
+{
+#ifdef __ENABLE_SERVER_DIAGNOSTIC__
+	boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+#endif
+	boost::unique_lock<boost::mutex> lockClass(m_lock);
+	if(m_block)
+	{
+		// backpressure, wait for the writer to drain the queue
+		while(m_state != STATE_TERMINATED && (m_size >= m_ring.size() || m_bytes >= m_maxBytes))
+			m_space.wait(lockClass);
+	}
+
+	if(m_state == STATE_TERMINATED)
+	{
+		// writer is not running, either not opened yet or already closed
+		LogRecord record;
+		record.file = file;
+		record.name = name;
+		record.text = output;
+		record.stamp = time(NULL);
+		record.newLine = newLine;
+
+		write(record);
+		closeIdle(0, true);
 		return;
+	}
+
+	if(m_size >= m_ring.size() || m_bytes >= m_maxBytes)
+	{
+		++m_dropped;
+		return;
+	}
+
+	// slots keep their string capacity, so steady state does not allocate
+	LogRecord& record = m_ring[(m_head + m_size) % m_ring.size()];
+	record.file = file;
+	record.name.assign(name);
+	record.text.assign(output);
+	record.stamp = time(NULL);
+	record.newLine = newLine;
+
+	m_bytes += name.size() + output.size();
+	++m_queued;
+
+	bool signal = (++m_size == m_wakeup);
+#ifdef __ENABLE_SERVER_DIAGNOSTIC__
+	m_enqueueTime += (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds();
+#endif
+	lockClass.unlock();
+	if(signal)
+		m_signal.notify_one();
+}
+
+void Logger::writerThread(void* p)
+{
+	Logger* logger = (Logger*)p;
+	std::vector<LogRecord> batch(logger->m_ring.size());
+
+	boost::unique_lock<boost::mutex> lockClass(logger->m_lock, boost::defer_lock);
+	while(true)
+	{
+		lockClass.lock();
+		if(logger->m_state == STATE_RUNNING && logger->m_size < logger->m_wakeup)
+			logger->m_signal.timed_wait(lockClass, boost::get_system_time() +
+				boost::posix_time::milliseconds(logger->m_flushInterval));
+
+		uint32_t count = logger->m_size;
+		if(!count && logger->m_state != STATE_RUNNING)
+		{
+			logger->m_state = STATE_TERMINATED;
+			lockClass.unlock();
+
+			logger->m_space.notify_all();
+			break;
+		}
+
+		// take the whole queue, swapping strings back and forth keeps the buffers
+		for(uint32_t i = 0; i < count; ++i)
+		{
+			LogRecord& record = logger->m_ring[(logger->m_head + i) % logger->m_ring.size()];
+			batch[i].file = record.file;
+			batch[i].name.swap(record.name);
+			batch[i].text.swap(record.text);
+			batch[i].stamp = record.stamp;
+			batch[i].newLine = record.newLine;
+		}
+
+		logger->m_head = (logger->m_head + count) % logger->m_ring.size();
+		logger->m_size = 0;
+		logger->m_bytes = 0;
+
+		uint64_t dropped = logger->m_dropped - logger->m_reported;
+		logger->m_reported = logger->m_dropped;
 
-	internal(m_files[file], output, newLine);
-	fflush(m_files[file]);
+		lockClass.unlock();
+		logger->m_space.notify_all();
+		if(dropped)
+		{
+			std::stringstream s;
+			s << "[" << formatDate() << "] (Warning - Logger::writerThread) Queue full, dropped " << dropped << " message(s).";
+
+			LogRecord record;
+			record.file = LOGFILE_ADMIN;
+			record.text = s.str();
+			record.stamp = time(NULL);
+			record.newLine = true;
+			logger->write(record);
+		}
+
+		logger->flush(batch, count);
+	}
+}
+
+void Logger::flush(std::vector<LogRecord>& batch, uint32_t count)
+{
+	for(uint32_t i = 0; i < count; ++i)
+		write(batch[i]);
+
+	time_t now = time(NULL);
+	for(uint8_t i = 0; i <= LOGFILE_LAST; i++)
+	{
+		if(!m_files[i].handle)
+			continue;
+
+		fflush(m_files[i].handle);
+		rotateFile(m_files[i], now);
+	}
+
+	for(LogFileMap::iterator it = m_extFiles.begin(); it != m_extFiles.end(); ++it)
+	{
+		fflush(it->second.handle);
+		rotateFile(it->second, now);
+	}
+
+	closeIdle(now, false);
+	++m_batches;
 }
 
-void Logger::eFile(std::string file, std::string output, bool newLine)
+void Logger::write(const LogRecord& record)
 {
-	FILE* f = fopen(getFilePath(FILE_TYPE_LOG, file).c_str(), "a");
-	if(!f)
+	LogFileState* state = NULL;
+	if(!record.name.empty())
+	{
+		LogFileMap::iterator it = m_extFiles.find(record.name);
+		if(it == m_extFiles.end())
+		{
+			LogFileState tmp;
+			tmp.path = getFilePath(FILE_TYPE_LOG, record.name);
+			if(!openFile(tmp, "a"))
+				return;
+
+			it = m_extFiles.insert(std::make_pair(record.name, tmp)).first;
+		}
+
+		state = &it->second;
+	}
+	else
+		state = &m_files[record.file];
+
+	if(!state->handle)
 		return;
 
-	internal(f, "[" + formatDate() + "] " + output, newLine);
-	fclose(f);
+	if(!record.name.empty())
+	{
+		std::string prefix = "[" + formatDate(record.stamp) + "] ";
+		state->size += fwrite(prefix.c_str(), 1, prefix.size(), state->handle);
+	}
+
+	state->size += fwrite(record.text.c_str(), 1, record.text.size(), state->handle);
+	if(record.newLine && fputc('\n', state->handle) != EOF)
+		state->size++;
+
+	state->used = record.stamp;
+	++m_written;
 }
 
-void Logger::internal(FILE* file, std::string output, bool newLine)
+bool Logger::openFile(LogFileState& state, const char* mode)
 {
-	if(!file)
+	if(!(state.handle = fopen(state.path.c_str(), mode)))
+		return false;
+
+	fseek(state.handle, 0, SEEK_END);
+	state.size = ftell(state.handle);
+	state.opened = state.used = time(NULL);
+	return true;
+}
+
+void Logger::rotateFile(LogFileState& state, time_t now)
+{
+	if(!state.handle || !state.size)
+		return;
+
+	if((!m_rotateSize || state.size < m_rotateSize) && (!m_rotateInterval || now - state.opened < m_rotateInterval))
 		return;
 
-	if(newLine)
-		output += "\n";
+	fclose(state.handle);
+	state.handle = NULL;
 
-	fprintf(file, "%s", output.c_str());
+	rename(state.path.c_str(), (state.path + "." + formatDateEx(now, "%Y%m%d-%H%M%S")).c_str());
+	openFile(state, "a");
+}
+
+void Logger::closeIdle(time_t now, bool all)
+{
+	for(LogFileMap::iterator it = m_extFiles.begin(); it != m_extFiles.end(); )
+	{
+		if(!all && now - it->second.used < LOG_IDLE_TIMEOUT)
+		{
+			++it;
+			continue;
+		}
+
+		if(it->second.handle)
+			fclose(it->second.handle);
+
+		m_extFiles.erase(it++);
+	}
 }
 
 void Logger::log(const char* func, LogType_t type, std::string message, std::string channel/* = ""*/, bool newLine/* = true*/)
@@ -134,9 +394,37 @@ OutputHandler::~OutputHandler()
 std::streambuf::int_type OutputHandler::overflow(std::streambuf::int_type c/* = traits_type::eof()*/)
 {
 	m_cache += c;
-	if(c != '\n' && c != '\r')
-		return c;
+	if(c == '\n' || c == '\r')
+		flushLine();
 
+	return c;
+}
+
+std::streamsize OutputHandler::xsputn(const char* s, std::streamsize n)
+{
+	const char* end = s + n;
+	while(s < end)
+	{
+		const char* it = s;
+		while(it < end && *it != '\n' && *it != '\r')
+			++it;
+
+		if(it == end)
+		{
+			m_cache.append(s, end - s);
+			break;
+		}
+
+		m_cache.append(s, it - s + 1);
+		flushLine();
+		s = it + 1;
+	}
+
+	return n;
+}
+
+void OutputHandler::flushLine()
+{
 	if(m_cache.size() > 1)
 		std::cout << "[" << formatTime(0, true) << "] ";
 
@@ -154,5 +442,4 @@ std::streambuf::int_type OutputHandler::overflow(std::streambuf::int_type c/* =
 	}
 
 	m_cache.clear();
-	return c;
 }
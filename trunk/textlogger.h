@@ -18,6 +18,7 @@
 #ifndef __TEXTLOGGER__
 #define __TEXTLOGGER__
 #include "otsystem.h"
+#define LOG_IDLE_TIMEOUT 60
 
 enum LogFile_t
 {
@@ -36,6 +37,28 @@ enum LogType_t
 	LOGTYPE_ERROR,
 };
 
+struct LogRecord
+{
+	LogRecord(): file(LOGFILE_FIRST), stamp(0), newLine(false) {}
+
+	LogFile_t file;
+	std::string name, text;
+	time_t stamp;
+	bool newLine;
+};
+
+struct LogFileState
+{
+	LogFileState(): handle(NULL), size(0), opened(0), used(0) {}
+
+	FILE* handle;
+	std::string path;
+	uint64_t size;
+	time_t opened, used;
+};
+
+typedef std::map<std::string, LogFileState> LogFileMap;
+
 class Logger
 {
 	public:
@@ -51,17 +74,58 @@ class Logger
 
 		bool isLoaded() const {return m_loaded;}
 
-		void iFile(LogFile_t file, std::string output, bool newLine);
-		void eFile(std::string file, std::string output, bool newLine);
+		void iFile(LogFile_t file, const std::string& output, bool newLine);
+		void eFile(const std::string& file, const std::string& output, bool newLine);
 
 		void log(const char* func, LogType_t type, std::string message, std::string channel = "", bool newLine = true);
 
+#ifdef __ENABLE_SERVER_DIAGNOSTIC__
+		uint64_t getQueuedCount() const {return m_queued;}
+		uint64_t getWrittenCount() const {return m_written;}
+		uint64_t getDroppedCount() const {return m_dropped;}
+		uint64_t getBatchCount() const {return m_batches;}
+		uint32_t getPendingCount() const {return m_size;}
+		uint64_t getEnqueueCost() const {return m_queued ? m_enqueueTime * 1000 / m_queued : 0;}
+
+#endif
 	private:
-		Logger() {m_loaded = false;}
-		void internal(FILE* file, std::string output, bool newLine);
+		Logger();
+		static void writerThread(void* p);
+
+		void push(LogFile_t file, const std::string& name, const std::string& output, bool newLine);
+		void write(const LogRecord& record);
+		void flush(std::vector<LogRecord>& batch, uint32_t count);
+
+		bool openFile(LogFileState& state, const char* mode);
+		void rotateFile(LogFileState& state, time_t now);
+		void closeIdle(time_t now, bool all);
+
+		enum WriterState
+		{
+			STATE_RUNNING,
+			STATE_CLOSING,
+			STATE_TERMINATED
+		};
 
-		FILE* m_files[LOGFILE_LAST + 1];
+		LogFileState m_files[LOGFILE_LAST + 1];
+		LogFileMap m_extFiles;
 		bool m_loaded;
+
+		boost::mutex m_lock;
+		boost::condition_variable m_signal, m_space;
+		boost::thread* m_thread;
+		WriterState m_state;
+
+		std::vector<LogRecord> m_ring;
+		uint32_t m_head, m_size, m_wakeup;
+		uint64_t m_bytes, m_maxBytes, m_rotateSize;
+		int32_t m_flushInterval, m_rotateInterval;
+		bool m_block;
+
+		uint64_t m_queued, m_written, m_dropped, m_batches, m_reported;
+#ifdef __ENABLE_SERVER_DIAGNOSTIC__
+		uint64_t m_enqueueTime;
+#endif
 };
 
 #define LOG_MESSAGE(type, message, channel) \
@@ -80,6 +144,9 @@ class OutputHandler : public std::streambuf
 	protected:
 		OutputHandler();
 		std::streambuf::int_type overflow(std::streambuf::int_type c = traits_type::eof());
+		std::streamsize xsputn(const char* s, std::streamsize n);
+
+		void flushLine();
 
 		std::streambuf* log;
 		std::streambuf* err;
@@ -39,9 +39,6 @@ extern MoveEvents* g_moveEvents;
 
 StaticTile reallyNullTile(0xFFFF, 0xFFFF, 0xFFFF);
 Tile& Tile::nullTile = reallyNullTile;
-#ifdef __GROUND_CACHE__
-std::map<Item*, int32_t> g_grounds;
-#endif
 
 bool Tile::hasProperty(enum ITEMPROPERTY prop) const
 {
@@ -302,6 +299,74 @@ Item* Tile::getItemByTopOrder(uint32_t topOrder)
 	return NULL;
 }
 
+TileItemVector* StaticTile::makeItemList()
+{
+	if(items)
+		return items;
+
+	Map* map = g_game.getMap();
+	if(map->isLoading())
+		items = new(map->allocate(pos.x, pos.y, sizeof(TileItemVector))) TileItemVector;
+	else
+		items = new TileItemVector;
+
+	return items;
+}
+
+CreatureVector* StaticTile::makeCreatures()
+{
+	if(creatures)
+		return creatures;
+
+	Map* map = g_game.getMap();
+	if(map->isLoading())
+		creatures = new(map->allocate(pos.x, pos.y, sizeof(CreatureVector))) CreatureVector;
+	else
+		creatures = new CreatureVector;
+
+	return creatures;
+}
+
+Item* Tile::unshareItem(Item* item)
+{
+	if(!item || !item->isShared())
+		return item;
+
+	Item* newItem = item->clone();
+	if(!newItem)
+		return item;
+
+	if(item != ground)
+	{
+		TileItemVector* items = getItemList();
+		ItemVector::iterator it;
+		if(!items || (it = std::find(items->begin(), items->end(), item)) == items->end())
+		{
+			newItem->unRef();
+			return item;
+		}
+
+		*it = newItem;
+	}
+	else
+		ground = newItem;
+
+	newItem->setParent(this);
+	newItem->setLoadedFromMap(true);
+	return newItem;
+}
+
+Thing* Tile::unshareThing(Thing* thing)
+{
+	if(!thing)
+		return NULL;
+
+	if(Item* item = thing->getItem())
+		return unshareItem(item);
+
+	return thing;
+}
+
 Thing* Tile::getTopVisibleThing(const Creature* creature)
 {
 	if(Creature* _creature = getTopVisibleCreature(creature))
@@ -907,25 +972,11 @@ void Tile::__addThing(Creature* actor, int32_t, Thing* thing)
 			Item* oldGround = ground;
 			ground = item;
 
-#ifdef __GROUND_CACHE__
-			std::map<Item*, int32_t>::iterator it = g_grounds.find(ground);
-			bool erase = it == g_grounds.end();
-			if(!erase)
-			{
-				it->second--;
-				erase = it->second < 1;
-				if(erase)
-					g_grounds.erase(it);
-			}
-
-			if(erase)
+			if(!oldGround->isShared())
 			{
-#endif
 				oldGround->setParent(NULL);
 				g_game.freeThing(oldGround);
-#ifdef __GROUND_CACHE__
 			}
-#endif
 
 			updateTileFlags(oldGround, true);
 			updateTileFlags(item, false);
@@ -1151,9 +1202,7 @@ void Tile::__replaceThing(uint32_t index, Thing* thing)
 	if(oldItem)
 	{
 		onUpdateTileItem(oldItem, Item::items[oldItem->getID()], item, Item::items[item->getID()]);
-#ifdef __GROUND_CACHE__
-		if(g_grounds.find(oldItem) == g_grounds.end())
-#endif
+		if(!oldItem->isShared())
 			oldItem->setParent(NULL);
 
 		return/* RET_NOERROR*/;
@@ -1222,9 +1271,7 @@ void Tile::__removeThing(Thing* thing, uint32_t count)
 				oldStackposVector.push_back(getClientIndexOfThing(tmpPlayer, ground));
 		}
 
-#ifdef __GROUND_CACHE__
-		if(g_grounds.find(ground) == g_grounds.end())
-#endif
+		if(!ground->isShared())
 			ground->setParent(NULL);
 
 		ground = NULL;
@@ -1255,9 +1302,10 @@ void Tile::__removeThing(Thing* thing, uint32_t count)
 					oldStackposVector.push_back(getClientIndexOfThing(tmpPlayer, *it));
 			}
 
-			(*it)->setParent(NULL);
-			items->erase(it);
+			if(!item->isShared())
+				item->setParent(NULL);
 
+			items->erase(it);
 			--thingCount;
 			onRemoveTileItem(list, oldStackposVector, item);
 			return/* RET_NOERROR*/;
@@ -1293,7 +1341,9 @@ void Tile::__removeThing(Thing* thing, uint32_t count)
 						oldStackposVector.push_back(getClientIndexOfThing(tmpPlayer, *it));
 				}
 
-				(*it)->setParent(NULL);
+				if(!item->isShared())
+					item->setParent(NULL);
+
 				items->erase(it);
 
 				--items->downItemCount;
@@ -1576,10 +1626,6 @@ void Tile::__internalAddThing(uint32_t, Thing* thing)
 	if(!item)
 		return;
 
-	TileItemVector* items = makeItemList();
-	if(items && items->size() >= 0xFFFF)
-		return/* RET_NOTPOSSIBLE*/;
-
 	if(item->isGroundTile())
 	{
 		if(!ground)
@@ -1587,8 +1633,17 @@ void Tile::__internalAddThing(uint32_t, Thing* thing)
 			ground = item;
 			++thingCount;
 		}
+
+		//grounds don't need the item list, most static tiles never get one
+		updateTileFlags(item, false);
+		return;
 	}
-	else if(item->isAlwaysOnTop())
+
+	TileItemVector* items = makeItemList();
+	if(items && items->size() >= 0xFFFF)
+		return/* RET_NOTPOSSIBLE*/;
+
+	if(item->isAlwaysOnTop())
 	{
 		bool isInserted = false;
 		for(ItemVector::iterator it = items->getBeginTopItem(); it != items->getEndTopItem(); ++it)
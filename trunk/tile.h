@@ -168,6 +168,9 @@ class Tile : public Cylinder
 		const Creature* getTopVisibleCreature(const Creature* creature) const;
 		Item* getItemByTopOrder(uint32_t topOrder);
 
+		Item* unshareItem(Item* item);
+		Thing* unshareThing(Thing* thing);
+
 		uint32_t getThingCount() const {return thingCount;}
 		uint32_t getCreatureCount() const;
 		uint32_t getItemCount() const;
@@ -325,11 +328,11 @@ class StaticTile : public Tile
 
 		TileItemVector* getItemList() {return items;}
 		const TileItemVector* getItemList() const {return items;}
-		TileItemVector* makeItemList() {return (items) ? (items) : (items = new TileItemVector);}
+		TileItemVector* makeItemList();
 
 		CreatureVector* getCreatures() {return creatures;}
 		const CreatureVector* getCreatures() const {return creatures;}
-		CreatureVector* makeCreatures() {return (creatures) ? (creatures) : (creatures = new CreatureVector);}
+		CreatureVector* makeCreatures();
 };
 
 inline Tile::Tile(uint16_t x, uint16_t y, uint16_t z): qt_node(NULL),
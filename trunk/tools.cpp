@@ -36,6 +36,12 @@
 #include "vocation.h"
 #include "configmanager.h"
 
+#if defined _MSC_VER
+#define RANDOM_THREAD_LOCAL __declspec(thread)
+#else
+#define RANDOM_THREAD_LOCAL __thread
+#endif
+
 extern ConfigManager g_config;
 
 std::string transformToMD5(std::string plainText, bool upperCase)
@@ -539,43 +545,127 @@ int32_t round(float v)
 	return t;
 }
 
+// every thread owns its own xoshiro128** state, so rolls need no locking
+// (unlike rand(), which serializes all callers in glibc)
+struct RandomState
+{
+	uint32_t state[4];
+	float normal;
+	bool seeded, hasNormal;
+};
+
+static RANDOM_THREAD_LOCAL RandomState randomState;
+static uint64_t randomSeed = 0;
+
+static uint64_t splitmix64(uint64_t& x)
+{
+	uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+static void seedState(RandomState& rs, uint64_t seed)
+{
+	uint64_t a = splitmix64(seed), b = splitmix64(seed);
+	rs.state[0] = (uint32_t)a;
+	rs.state[1] = (uint32_t)(a >> 32);
+	rs.state[2] = (uint32_t)b;
+	rs.state[3] = (uint32_t)(b >> 32);
+	if(!(rs.state[0] | rs.state[1] | rs.state[2] | rs.state[3]))
+		rs.state[0] = 1;
+
+	rs.hasNormal = false;
+	rs.seeded = true;
+}
+
+static inline uint32_t rotl(uint32_t x, int32_t k)
+{
+	return (x << k) | (x >> (32 - k));
+}
+
+void random_seed(uint64_t seed)
+{
+	randomSeed = seed;
+	seedState(randomState, seed);
+}
+
+uint32_t random_next()
+{
+	RandomState& rs = randomState;
+	if(!rs.seeded) // other threads derive their stream from the global seed
+		seedState(rs, randomSeed ^ (uint64_t)(uintptr_t)&rs);
+
+	uint32_t* s = rs.state;
+	const uint32_t result = rotl(s[1] * 5, 7) * 9, t = s[1] << 9;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+
+	s[2] ^= t;
+	s[3] = rotl(s[3], 11);
+	return result;
+}
+
+uint32_t random_bounded(uint32_t range)
+{
+	// unbiased [0, range), multiply-shift with rejection (Lemire)
+	if(!range)
+		return random_next();
+
+	uint64_t m = (uint64_t)random_next() * range;
+	if((uint32_t)m < range)
+	{
+		uint32_t threshold = (0 - range) % range;
+		while((uint32_t)m < threshold)
+			m = (uint64_t)random_next() * range;
+	}
+
+	return (uint32_t)(m >> 32);
+}
+
+void random_fill(uint32_t* values, uint32_t count, uint32_t range)
+{
+	for(uint32_t i = 0; i < count; ++i)
+		values[i] = random_bounded(range);
+}
+
+double random_real()
+{
+	return (random_next() >> 8) * (1. / 16777216.);
+}
+
 uint32_t rand24b()
 {
-	return ((rand() << 12) ^ (rand())) & (0xFFFFFF);
+	return random_next() >> 8;
 }
 
 float box_muller(float m, float s)
 {
 	// normal random variate generator
 	// mean m, standard deviation s
-	float x1, x2, w, y1;
-	static float y2;
-
-	static bool useLast = false;
-	if(useLast) // use value from previous call
+	RandomState& rs = randomState;
+	if(rs.hasNormal) // use value from previous call
 	{
-		y1 = y2;
-		useLast = false;
-		return (m + y1 * s);
+		rs.hasNormal = false;
+		return (m + rs.normal * s);
 	}
 
+	double x1, x2, w;
 	do
 	{
-		double r1 = (((float)(rand()) / RAND_MAX));
-		double r2 = (((float)(rand()) / RAND_MAX));
-
-		x1 = 2.0 * r1 - 1.0;
-		x2 = 2.0 * r2 - 1.0;
+		x1 = 2.0 * random_real() - 1.0;
+		x2 = 2.0 * random_real() - 1.0;
 		w = x1 * x1 + x2 * x2;
 	}
-	while(w >= 1.0);
+	while(w >= 1.0 || w == 0.0);
 	w = sqrt((-2.0 * log(w)) / w);
 
-	y1 = x1 * w;
-	y2 = x2 * w;
-
-	useLast = true;
-	return (m + y1 * s);
+	rs.normal = (float)(x2 * w);
+	rs.hasNormal = true;
+	return (m + (float)(x1 * w) * s);
 }
 
 int32_t random_range(int32_t lowestNumber, int32_t highestNumber, DistributionType_t type /*= DISTRO_UNIFORM*/)
@@ -589,7 +679,7 @@ int32_t random_range(int32_t lowestNumber, int32_t highestNumber, DistributionTy
 	switch(type)
 	{
 		case DISTRO_UNIFORM:
-			return (lowestNumber + ((int32_t)rand24b() % (highestNumber - lowestNumber + 1)));
+			return (lowestNumber + (int32_t)random_bounded((uint32_t)highestNumber - (uint32_t)lowestNumber + 1));
 		case DISTRO_NORMAL:
 			return (lowestNumber + int32_t(float(highestNumber - lowestNumber) * (float)std::min((float)1, std::max((float)0, box_muller(0.5, 0.25)))));
 		default:
@@ -120,6 +120,11 @@ std::string trimString(std::string& str);
 std::string parseParams(tokenizer::iterator &it, tokenizer::iterator end);
 
 std::string generateRecoveryKey(int32_t fieldCount, int32_t fieldLength, bool mixCase = false);
+void random_seed(uint64_t seed);
+uint32_t random_next();
+uint32_t random_bounded(uint32_t range);
+void random_fill(uint32_t* values, uint32_t count, uint32_t range);
+double random_real();
 int32_t random_range(int32_t lowest_number, int32_t highest_number, DistributionType_t type = DISTRO_UNIFORM);
 
 int32_t round(float v);